@@ -44,6 +44,32 @@
 	;; in a shared setup.
 	${MIKTEX_CONFIG_VALUE_AUTOADMIN} = ${Core_AutoAdmin}
 
+	;; Size (in kilobytes) of the buffer through which a
+	;; decompressing thread passes data to the reader.
+	${MIKTEX_CONFIG_VALUE_DECOMPRESSIONBUFFERSIZE} = 256
+
+	;; Remember the results of file searches across processes.
+	;; The remembered results are discarded when a file name
+	;; database changes.
+	${MIKTEX_CONFIG_VALUE_FINDFILECACHE} = false
+
+	;; Number of file name database changes after which the
+	;; changes are merged into the database (0 disables merging).
+	${MIKTEX_CONFIG_VALUE_FNDBCOMPACTIONTHRESHOLD} = 1000
+
+	;; Minimum time (in milliseconds) between two checks for
+	;; changes made to the file name database by other processes.
+	${MIKTEX_CONFIG_VALUE_FNDBREVALIDATIONINTERVAL} = 1000
+
+	;; Number of threads used to scan a root directory when the
+	;; file name database is created (0: choose automatically, 1:
+	;; scan sequentially).
+	${MIKTEX_CONFIG_VALUE_FNDBSCANTHREADS} = 0
+
+	;; Compressed files up to this size (in bytes) are
+	;; decompressed at once without starting a separate thread.
+	${MIKTEX_CONFIG_VALUE_SYNCDECOMPRESSIONTHRESHOLD} = 65536
+
 	;; System-wide directory in which to create symbolic links to
         ;; MiKTeX executables.
 	${MIKTEX_CONFIG_VALUE_COMMONLINKTARGETDIRECTORY} = ${MIKTEX_SYSTEM_LINK_TARGET_DIR}
@@ -816,6 +842,10 @@
 	;; Install missing packages automatically (on-the-fly).
 	${MIKTEX_CONFIG_VALUE_AUTOINSTALL} = ${MPM_AutoInstall}
 
+	;; Maximum number of package archives which are downloaded
+	;; and verified at the same time (1: download sequentially).
+	${MIKTEX_CONFIG_VALUE_MAXPARALLELDOWNLOADS} = 4
+
 [${MIKTEX_CONFIG_SECTION_TEXANDFRIENDS}]
 
 	;; Create auxiliary directory if '--aux-directory=DIR' refers
@@ -828,3 +858,7 @@
 
 	;; Enable file:line:error style messages.
 	${MIKTEX_CONFIG_VALUE_CSTYLEERRORS} = f
+
+	;; Compress format files (memory dump files) when they are
+	;; created.
+	${MIKTEX_CONFIG_VALUE_COMPRESSMEMORYDUMPFILES} = f
@@ -21,9 +21,12 @@
 
 #include "config.h"
 
+#include <cstring>
+
 #include <fstream>
 
 #include <miktex/Core/Cfg.h>
+#include <miktex/Core/Directory>
 #include <miktex/Core/FileStream>
 #include <miktex/Core/Registry.h>
 #include <miktex/Trace/StopWatch>
@@ -481,6 +484,175 @@ private:
 };
 #endif
 
+// A snapshot records the actions of the parser (sections, value
+// definitions, directives, included files), so that an INI file can
+// be loaded without tokenizing it again.  Strings are stored once in
+// a string pool.
+//
+// Layout (host byte order):
+//
+//   header
+//   files: the INI file and all included files
+//   ops: parser actions
+//   string pool: null-terminated strings
+struct CfgSnapshotHeader
+{
+  static const uint32_t Signature = 0x53474643; // 'CFGS' (the x86 way)
+  static const uint32_t Version = 1;
+  uint32_t signature;
+  uint32_t version;
+  // size (in bytes) of the snapshot; includes header size
+  uint32_t size;
+  uint32_t numFiles;
+  uint32_t numOps;
+  uint32_t foFiles;
+  uint32_t foOps;
+  uint32_t foStrings;
+  // MD5 of everything after the header
+  uint8_t digest[16];
+};
+
+struct CfgSnapshotFile
+{
+  uint32_t path;
+  uint32_t reserved;
+  uint64_t size;
+  int64_t lastWriteTime;
+};
+
+enum class CfgSnapshotOpKind : uint8_t
+{
+  // begin of a file; name: default key name
+  Begin,
+  // end of a file
+  End,
+  // section header; name: key name
+  Key,
+  // value definition
+  Put,
+  // !clear directive; name: value name
+  Clear
+};
+
+struct CfgSnapshotOp
+{
+  CfgSnapshotOpKind kind;
+  uint8_t putMode;
+  uint8_t commentedOut;
+  uint8_t reserved;
+  uint32_t name;
+  uint32_t value;
+  uint32_t documentation;
+};
+
+class CfgRecorder
+{
+public:
+  CfgRecorder()
+  {
+    Intern("");
+  }
+
+public:
+  void AddFile(const PathName& path)
+  {
+    CfgSnapshotFile file;
+    memset(&file, 0, sizeof(file));
+    file.path = Intern(path.ToString());
+    file.size = File::GetSize(path);
+    file.lastWriteTime = File::GetLastWriteTime(path);
+    files.push_back(file);
+    // time stamps have a resolution of one second (or worse): a file
+    // which has been modified recently might be modified again
+    // without changing size and time stamp
+    if (file.lastWriteTime > static_cast<int64_t>(time(nullptr)) - MIN_FILE_AGE)
+    {
+      stable = false;
+    }
+  }
+
+public:
+  void AddOp(CfgSnapshotOpKind kind, const string& name, const string& value = "", const string& documentation = "", uint8_t putMode = 0, bool commentedOut = false)
+  {
+    CfgSnapshotOp op;
+    memset(&op, 0, sizeof(op));
+    op.kind = kind;
+    op.putMode = putMode;
+    op.commentedOut = commentedOut ? 1 : 0;
+    op.name = Intern(name);
+    op.value = Intern(value);
+    op.documentation = Intern(documentation);
+    ops.push_back(op);
+  }
+
+public:
+  vector<unsigned char> GetSnapshot() const
+  {
+    CfgSnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    header.signature = CfgSnapshotHeader::Signature;
+    header.version = CfgSnapshotHeader::Version;
+    header.numFiles = static_cast<uint32_t>(files.size());
+    header.numOps = static_cast<uint32_t>(ops.size());
+    header.foFiles = sizeof(header);
+    header.foOps = static_cast<uint32_t>(header.foFiles + files.size() * sizeof(CfgSnapshotFile));
+    header.foStrings = static_cast<uint32_t>(header.foOps + ops.size() * sizeof(CfgSnapshotOp));
+    header.size = static_cast<uint32_t>(header.foStrings + strings.size());
+    vector<unsigned char> snapshot(header.size);
+    memcpy(&snapshot[header.foFiles], files.data(), files.size() * sizeof(CfgSnapshotFile));
+    if (!ops.empty())
+    {
+      memcpy(&snapshot[header.foOps], ops.data(), ops.size() * sizeof(CfgSnapshotOp));
+    }
+    memcpy(&snapshot[header.foStrings], strings.data(), strings.size());
+    MD5Builder md5Builder;
+    md5Builder.Update(&snapshot[sizeof(header)], snapshot.size() - sizeof(header));
+    MD5 md5 = md5Builder.Final();
+    memcpy(header.digest, md5.data(), sizeof(header.digest));
+    memcpy(&snapshot[0], &header, sizeof(header));
+    return snapshot;
+  }
+
+public:
+  // false, if the parser output cannot be replayed (signed files)
+  bool replayable = true;
+
+public:
+  // false, if one of the files has been modified within the last
+  // MIN_FILE_AGE seconds
+  bool stable = true;
+
+private:
+  static constexpr int64_t MIN_FILE_AGE = 2;
+
+private:
+  uint32_t Intern(const string& s)
+  {
+    auto it = offsets.find(s);
+    if (it != offsets.end())
+    {
+      return it->second;
+    }
+    uint32_t fo = static_cast<uint32_t>(strings.size());
+    strings.insert(strings.end(), s.begin(), s.end());
+    strings.push_back(0);
+    offsets[s] = fo;
+    return fo;
+  }
+
+private:
+  vector<CfgSnapshotFile> files;
+
+private:
+  vector<CfgSnapshotOp> ops;
+
+private:
+  vector<char> strings;
+
+private:
+  unordered_map<string, uint32_t> offsets;
+};
+
 class CfgImpl :
   public Cfg
 {
@@ -634,6 +806,15 @@ public:
 public:
   void MIKTEXTHISCALL Write(const PathName& path, const string& header, IPrivateKeyProvider* pPrivateKeyProvider) override;
 
+public:
+  void MIKTEXTHISCALL ReadWithSnapshot(const PathName& path, const PathName& snapshotDirectory) override;
+
+private:
+  bool IsValidSnapshot(const vector<unsigned char>& snapshot, const PathName& path) const;
+
+private:
+  void Replay(const vector<unsigned char>& snapshot);
+
 private:
   enum PutMode {
     None,
@@ -701,6 +882,9 @@ private:
 private:
   PathName currentFile;
 
+private:
+  CfgRecorder* recorder = nullptr;
+
 private:
   friend class Cfg;
 };
@@ -959,7 +1143,16 @@ void CfgImpl::Read(const PathName& path, const string& defaultKeyName, int level
   AutoRestore<int> autoRestore1(lineno);
   AutoRestore<PathName> autoRestore(currentFile);
   std::ifstream reader = File::CreateInputStream(path);
+  if (recorder != nullptr)
+  {
+    recorder->AddFile(path);
+    recorder->AddOp(CfgSnapshotOpKind::Begin, defaultKeyName);
+  }
   Read(reader, defaultKeyName, level, mustBeSigned, publicKeyFile);
+  if (recorder != nullptr)
+  {
+    recorder->AddOp(CfgSnapshotOpKind::End, "");
+  }
   reader.close();
 }
 
@@ -1019,6 +1212,10 @@ void CfgImpl::Read(std::istream& reader, const string& defaultKeyName, int level
         {
           FATAL_CFG_ERROR(T_("missing value name argument"));
         }
+        if (recorder != nullptr)
+        {
+          recorder->AddOp(CfgSnapshotOpKind::Clear, *tok);
+        }
         ClearValue(keyName, *tok);
       }
       else
@@ -1037,6 +1234,10 @@ void CfgImpl::Read(std::istream& reader, const string& defaultKeyName, int level
       keyName = *tok;
       lookupKeyName = Utils::MakeLower(keyName);
       ignoreKey = options[Option::NoOverwriteKeys] && keyMap.find(lookupKeyName) != keyMap.end();
+      if (recorder != nullptr)
+      {
+        recorder->AddOp(CfgSnapshotOpKind::Key, keyName);
+      }
     }
     else if (line.length() >= 3 && line[0] == COMMENT_CHAR && line[1] == COMMENT_CHAR && line[2] == ' ')
     {
@@ -1057,8 +1258,17 @@ void CfgImpl::Read(std::istream& reader, const string& defaultKeyName, int level
         {
           FATAL_CFG_ERROR(T_("invalid value definition"));
         }
+        if (recorder != nullptr)
+        {
+          recorder->AddOp(CfgSnapshotOpKind::Put, valueName, value, documentation, static_cast<uint8_t>(putMode), line[0] == COMMENT_CHAR);
+        }
         PutValue(keyName, valueName, std::move(value), putMode, std::move(documentation), line[0] == COMMENT_CHAR);
       }
+      else if (recorder != nullptr)
+      {
+        // the key might not be ignored when the snapshot is replayed
+        recorder->replayable = false;
+      }
     }
     else if (line.length() >= 4 && line[0] == COMMENT_CHAR && line[1] == COMMENT_CHAR && line[2] == COMMENT_CHAR && line[3] == COMMENT_CHAR)
     {
@@ -1068,6 +1278,10 @@ void CfgImpl::Read(std::istream& reader, const string& defaultKeyName, int level
       {
         if (*tok == "signature/miktex:")
         {
+          if (recorder != nullptr)
+          {
+            recorder->replayable = false;
+          }
           ++tok;
           if (tok && wasEmpty && level == 0)
           {
@@ -1144,6 +1358,197 @@ void CfgImpl::Read(std::istream& reader, const string& defaultKeyName, int level
   }
 }
 
+void CfgImpl::ReadWithSnapshot(const PathName& path, const PathName& snapshotDirectory)
+{
+  PathName absPath(path);
+  absPath.MakeAbsolute();
+  PathName snapshotFile = snapshotDirectory / ("cfg-" + MD5::FromChars(absPath.ToString()).ToString() + ".snapshot");
+  vector<unsigned char> snapshot;
+  try
+  {
+    if (File::Exists(snapshotFile))
+    {
+      snapshot = File::ReadAllBytes(snapshotFile);
+    }
+  }
+  catch (const MiKTeXException&)
+  {
+    snapshot.clear();
+  }
+  if (!snapshot.empty() && IsValidSnapshot(snapshot, absPath))
+  {
+    traceStream->WriteFormattedLine("core", T_("loading %s from snapshot %s"), Q_(path), Q_(snapshotFile));
+    this->path = path;
+    Replay(snapshot);
+    return;
+  }
+  CfgRecorder recorder;
+  bool wasEmpty = Empty();
+  this->recorder = &recorder;
+  try
+  {
+    Read(absPath);
+    this->path = path;
+  }
+  catch (const exception&)
+  {
+    this->recorder = nullptr;
+    throw;
+  }
+  this->recorder = nullptr;
+  if (!recorder.replayable || (wasEmpty && !signature.empty()))
+  {
+    return;
+  }
+  if (!recorder.stable)
+  {
+    traceStream->WriteFormattedLine("core", T_("not creating snapshot %s: %s has been modified recently"), Q_(snapshotFile), Q_(path));
+    return;
+  }
+  // other processes might be reading the existing snapshot
+  PathName tempFile;
+  try
+  {
+    if (!Directory::Exists(snapshotDirectory))
+    {
+      Directory::Create(snapshotDirectory);
+    }
+    tempFile.SetToTempFile(snapshotDirectory);
+    File::WriteBytes(tempFile, recorder.GetSnapshot());
+    File::Move(tempFile, snapshotFile, { FileMoveOption::ReplaceExisting });
+  }
+  catch (const MiKTeXException& e)
+  {
+    // not an error: the INI file has been read (e.g., the user data
+    // directory may be read-only)
+    traceStream->WriteFormattedLine("core", T_("snapshot %s cannot be written: %s"), Q_(snapshotFile), e.GetErrorMessage().c_str());
+    if (!tempFile.Empty() && File::Exists(tempFile))
+    {
+      try
+      {
+        File::Delete(tempFile);
+      }
+      catch (const MiKTeXException&)
+      {
+      }
+    }
+  }
+}
+
+bool CfgImpl::IsValidSnapshot(const vector<unsigned char>& snapshot, const PathName& path) const
+{
+  CfgSnapshotHeader header;
+  if (snapshot.size() < sizeof(header))
+  {
+    return false;
+  }
+  memcpy(&header, &snapshot[0], sizeof(header));
+  if (header.signature != CfgSnapshotHeader::Signature
+    || header.version != CfgSnapshotHeader::Version
+    || header.size != snapshot.size()
+    || header.numFiles == 0
+    || header.foFiles != sizeof(header)
+    || header.foOps != header.foFiles + static_cast<uint64_t>(header.numFiles) * sizeof(CfgSnapshotFile)
+    || header.foStrings != header.foOps + static_cast<uint64_t>(header.numOps) * sizeof(CfgSnapshotOp)
+    || header.foStrings >= header.size
+    || snapshot.back() != 0)
+  {
+    return false;
+  }
+  MD5Builder md5Builder;
+  md5Builder.Update(&snapshot[sizeof(header)], snapshot.size() - sizeof(header));
+  MD5 md5 = md5Builder.Final();
+  if (memcmp(md5.data(), header.digest, sizeof(header.digest)) != 0)
+  {
+    return false;
+  }
+  size_t stringPoolSize = header.size - header.foStrings;
+  const char* strings = reinterpret_cast<const char*>(&snapshot[header.foStrings]);
+  const CfgSnapshotOp* ops = reinterpret_cast<const CfgSnapshotOp*>(&snapshot[header.foOps]);
+  for (uint32_t idx = 0; idx < header.numOps; ++idx)
+  {
+    if (ops[idx].name >= stringPoolSize || ops[idx].value >= stringPoolSize || ops[idx].documentation >= stringPoolSize)
+    {
+      return false;
+    }
+  }
+  // the snapshot is outdated, if one of the files has been changed
+  const CfgSnapshotFile* files = reinterpret_cast<const CfgSnapshotFile*>(&snapshot[header.foFiles]);
+  for (uint32_t idx = 0; idx < header.numFiles; ++idx)
+  {
+    if (files[idx].path >= stringPoolSize)
+    {
+      return false;
+    }
+    PathName filePath(strings + files[idx].path);
+    if (idx == 0 && filePath != path)
+    {
+      return false;
+    }
+    if (!File::Exists(filePath)
+      || File::GetSize(filePath) != files[idx].size
+      || File::GetLastWriteTime(filePath) != files[idx].lastWriteTime)
+    {
+      traceStream->WriteFormattedLine("core", T_("snapshot is outdated: %s has been changed"), Q_(filePath));
+      return false;
+    }
+  }
+  return true;
+}
+
+void CfgImpl::Replay(const vector<unsigned char>& snapshot)
+{
+  const CfgSnapshotHeader* header = reinterpret_cast<const CfgSnapshotHeader*>(&snapshot[0]);
+  const char* strings = reinterpret_cast<const char*>(&snapshot[header->foStrings]);
+  const CfgSnapshotOp* ops = reinterpret_cast<const CfgSnapshotOp*>(&snapshot[header->foOps]);
+  // key name and ignore flag of the files being read
+  vector<pair<string, bool>> stack;
+  for (uint32_t idx = 0; idx < header->numOps; ++idx)
+  {
+    const CfgSnapshotOp& op = ops[idx];
+    switch (op.kind)
+    {
+    case CfgSnapshotOpKind::Begin:
+      stack.push_back(make_pair(string(strings + op.name), false));
+      break;
+    case CfgSnapshotOpKind::End:
+      if (stack.empty())
+      {
+        MIKTEX_UNEXPECTED();
+      }
+      stack.pop_back();
+      break;
+    case CfgSnapshotOpKind::Key:
+      if (stack.empty())
+      {
+        MIKTEX_UNEXPECTED();
+      }
+      stack.back().first = strings + op.name;
+      stack.back().second = options[Option::NoOverwriteKeys] && keyMap.find(Utils::MakeLower(stack.back().first)) != keyMap.end();
+      break;
+    case CfgSnapshotOpKind::Put:
+      if (stack.empty())
+      {
+        MIKTEX_UNEXPECTED();
+      }
+      if (!stack.back().second)
+      {
+        PutValue(stack.back().first, strings + op.name, string(strings + op.value), static_cast<PutMode>(op.putMode), string(strings + op.documentation), op.commentedOut != 0);
+      }
+      break;
+    case CfgSnapshotOpKind::Clear:
+      if (stack.empty())
+      {
+        MIKTEX_UNEXPECTED();
+      }
+      ClearValue(stack.back().first, strings + op.name);
+      break;
+    default:
+      MIKTEX_UNEXPECTED();
+    }
+  }
+}
+
 bool CfgImpl::ParseValueDefinition(const string& line, string& valueName, string& value, CfgImpl::PutMode& putMode)
 {
   MIKTEX_ASSERT(!line.empty() && (IsAlNum(line[0]) || line[0] == '.'));
@@ -21,6 +21,7 @@
 
 #include "config.h"
 
+#include <fcntl.h>
 #include <unistd.h>
 #include <sys/stat.h>
 
@@ -90,6 +91,21 @@ void Directory::SetTimes(const PathName& path, time_t creationTime, time_t lastA
   File::SetTimes(path, creationTime, lastAccessTime, lastWriteTime);
 }
 
+void Directory::Sync(const PathName& path)
+{
+  int fd = open(path.GetData(), O_RDONLY);
+  if (fd < 0)
+  {
+    MIKTEX_FATAL_CRT_ERROR_2("open", "path", path.ToString());
+  }
+  int ret = fsync(fd);
+  close(fd);
+  if (ret != 0)
+  {
+    MIKTEX_FATAL_CRT_ERROR_2("fsync", "path", path.ToString());
+  }
+}
+
 void Directory::Move(const PathName& source, const PathName& dest)
 {
   File::Move(source, dest);
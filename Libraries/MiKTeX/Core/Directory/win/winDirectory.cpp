@@ -124,6 +124,10 @@ void Directory::SetTimes(const PathName& path, time_t creationTime, time_t lastA
   SetTimesInternal(h, creationTime, lastAccessTime, lastWriteTime);
 }
 
+void Directory::Sync(const PathName& path)
+{
+}
+
 void Directory::Move(const PathName& source, const PathName& dest)
 {
   File::Move(source, dest);
@@ -33,6 +33,15 @@
 #  include <sys/time.h>
 #endif
 
+#if defined(HAVE_LINUX_FS_H)
+#  include <linux/fs.h>
+#  include <sys/ioctl.h>
+#endif
+
+#if defined(HAVE_SYS_SENDFILE_H)
+#  include <sys/sendfile.h>
+#endif
+
 #include <miktex/Core/Directory>
 #include <miktex/Core/File>
 #include <miktex/Core/FileStream>
@@ -330,6 +339,179 @@ void File::Move(const PathName& source, const PathName& dest, FileMoveOptionSet
   }
 }
 
+constexpr size_t COPY_BUFFER_SIZE = 1024 * 1024;
+
+#if defined(HAVE_COPY_FILE_RANGE) || defined(HAVE_SYS_SENDFILE_H)
+static bool IsCopyNotSupported(int err)
+{
+  return err == ENOSYS || err == EXDEV || err == EINVAL || err == EBADF || err == EOPNOTSUPP
+#if defined(ENOTSUP) && ENOTSUP != EOPNOTSUPP
+    || err == ENOTSUP
+#endif
+    ;
+}
+#endif
+
+// copies up to count bytes; the kernel copies the data, if possible
+static size_t CopyFileData(int fdIn, off_t offIn, int fdOut, off_t offOut, size_t count)
+{
+  size_t copied = 0;
+#if defined(HAVE_COPY_FILE_RANGE)
+  while (copied < count)
+  {
+    ssize_t n = copy_file_range(fdIn, &offIn, fdOut, &offOut, count - copied, 0);
+    if (n < 0)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+      if (IsCopyNotSupported(errno))
+      {
+        break;
+      }
+      MIKTEX_FATAL_CRT_ERROR("copy_file_range");
+    }
+    if (n == 0)
+    {
+      if (copied > 0)
+      {
+        return copied;
+      }
+      // some file systems report 0 instead of an error
+      break;
+    }
+    copied += n;
+  }
+#endif
+#if defined(HAVE_SYS_SENDFILE_H)
+  if (copied < count && lseek(fdOut, offOut, SEEK_SET) == offOut)
+  {
+    const size_t MAX_SENDFILE_COUNT = 0x7ffff000;
+    while (copied < count)
+    {
+      ssize_t n = sendfile(fdOut, fdIn, &offIn, std::min(count - copied, MAX_SENDFILE_COUNT));
+      if (n < 0)
+      {
+        if (errno == EINTR)
+        {
+          continue;
+        }
+        if (IsCopyNotSupported(errno))
+        {
+          break;
+        }
+        MIKTEX_FATAL_CRT_ERROR("sendfile");
+      }
+      if (n == 0)
+      {
+        return copied;
+      }
+      copied += n;
+      offOut += n;
+    }
+  }
+#endif
+  if (copied < count)
+  {
+    vector<char> buffer(std::min(count - copied, COPY_BUFFER_SIZE));
+    while (copied < count)
+    {
+      ssize_t n = pread(fdIn, &buffer[0], std::min(count - copied, buffer.size()), offIn);
+      if (n < 0)
+      {
+        if (errno == EINTR)
+        {
+          continue;
+        }
+        MIKTEX_FATAL_CRT_ERROR("pread");
+      }
+      if (n == 0)
+      {
+        break;
+      }
+      for (ssize_t written = 0; written < n; )
+      {
+        ssize_t m = pwrite(fdOut, &buffer[written], n - written, offOut + written);
+        if (m < 0)
+        {
+          if (errno == EINTR)
+          {
+            continue;
+          }
+          MIKTEX_FATAL_CRT_ERROR("pwrite");
+        }
+        written += m;
+      }
+      copied += n;
+      offIn += n;
+      offOut += n;
+    }
+  }
+  return copied;
+}
+
+// copies the remaining data, starting at the current file offsets,
+// until the end of the input is reached
+static void CopyUntilEof(int fdIn, int fdOut)
+{
+  vector<char> buffer(COPY_BUFFER_SIZE);
+  while (true)
+  {
+    ssize_t n = read(fdIn, &buffer[0], buffer.size());
+    if (n < 0)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+      MIKTEX_FATAL_CRT_ERROR("read");
+    }
+    if (n == 0)
+    {
+      break;
+    }
+    for (ssize_t written = 0; written < n; )
+    {
+      ssize_t m = write(fdOut, &buffer[written], n - written);
+      if (m < 0)
+      {
+        if (errno == EINTR)
+        {
+          continue;
+        }
+        MIKTEX_FATAL_CRT_ERROR("write");
+      }
+      written += m;
+    }
+  }
+}
+
+size_t File::CopyData(FILE* source, FILE* dest, size_t count)
+{
+  if (fflush(dest) != 0)
+  {
+    MIKTEX_FATAL_CRT_ERROR("fflush");
+  }
+  off_t sourcePos = ftello(source);
+  if (sourcePos < 0)
+  {
+    MIKTEX_FATAL_CRT_ERROR("ftello");
+  }
+  off_t destPos = ftello(dest);
+  if (destPos < 0)
+  {
+    MIKTEX_FATAL_CRT_ERROR("ftello");
+  }
+  size_t copied = CopyFileData(fileno(source), sourcePos, fileno(dest), destPos, count);
+  // move the stream positions past the copied data
+  if (fseeko(source, sourcePos + copied, SEEK_SET) != 0 || fseeko(dest, destPos + copied, SEEK_SET) != 0)
+  {
+    MIKTEX_FATAL_CRT_ERROR("fseeko");
+  }
+  return copied;
+}
+
 void File::Copy(const PathName& source, const PathName& dest, FileCopyOptionSet options)
 {
   shared_ptr<SessionImpl> session = SessionImpl::TryGetSession(); 
@@ -337,23 +519,41 @@ void File::Copy(const PathName& source, const PathName& dest, FileCopyOptionSet
   {
     session->trace_files->WriteFormattedLine("core", T_("copying %s to %s"), Q_(source), Q_(dest));
   }
+  FileStream sourceStream(File::Open(source, FileMode::Open, FileAccess::Read, false));
   struct stat sourceStat;
-  if (options[FileCopyOption::PreserveAttributes])
+  if (fstat(fileno(sourceStream.GetFile()), &sourceStat) != 0)
   {
-    if (stat(source.GetData(), &sourceStat) != 0)
-    {
-      MIKTEX_FATAL_CRT_ERROR_2("stat", "path", source.ToString());
-    }
+    MIKTEX_FATAL_CRT_ERROR_2("fstat", "path", source.ToString());
   }
-  FileStream sourceStream(File::Open(source, FileMode::Open, FileAccess::Read, false));
   try
   {
     FileStream destStream(File::Open(dest, FileMode::Create, FileAccess::Write, false));
-    char buffer[4096];
-    size_t n;
-    while ((n = sourceStream.Read(buffer, 4096)) > 0)
+    int fdIn = fileno(sourceStream.GetFile());
+    int fdOut = fileno(destStream.GetFile());
+    bool cloned = false;
+    off_t copied = 0;
+    // the kernel can only copy regular files: other files (e.g., pipes
+    // or procfs files) don't report their size
+    if (S_ISREG(sourceStat.st_mode))
     {
-      destStream.Write(buffer, n);
+#if defined(HAVE_LINUX_FS_H) && defined(FICLONE)
+      // share the data blocks (copy-on-write file systems)
+      cloned = ioctl(fdOut, FICLONE, fdIn) == 0;
+#endif
+      if (!cloned)
+      {
+        copied = CopyFileData(fdIn, 0, fdOut, 0, sourceStat.st_size);
+      }
+    }
+    if (!cloned)
+    {
+      // continue until EOF: the file might have grown in the meantime;
+      // the kernel copy doesn't move the source offset
+      if (copied > 0 && (lseek(fdIn, copied, SEEK_SET) != copied || lseek(fdOut, copied, SEEK_SET) != copied))
+      {
+        MIKTEX_FATAL_CRT_ERROR_2("lseek", "path", source.ToString());
+      }
+      CopyUntilEof(fdIn, fdOut);
     }
     sourceStream.Close();
     destStream.Close();
@@ -577,6 +777,30 @@ bool File::TryLock(int fd, File::LockType lockType, chrono::milliseconds timeout
   return locked;
 }
 
+void File::Sync(FILE* file)
+{
+  if (fflush(file) != 0)
+  {
+    MIKTEX_FATAL_CRT_ERROR("fflush");
+  }
+  if (fsync(fileno(file)) != 0)
+  {
+    MIKTEX_FATAL_CRT_ERROR("fsync");
+  }
+}
+
+void File::SetSize(FILE* file, size_t size)
+{
+  if (fflush(file) != 0)
+  {
+    MIKTEX_FATAL_CRT_ERROR("fflush");
+  }
+  if (ftruncate(fileno(file), size) != 0)
+  {
+    MIKTEX_FATAL_CRT_ERROR("ftruncate");
+  }
+}
+
 void File::Unlock(int fd)
 {
   if (flock(fd, LOCK_UN) != 0)
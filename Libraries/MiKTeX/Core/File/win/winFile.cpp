@@ -387,6 +387,31 @@ void File::Copy(const PathName& source, const PathName& dest, FileCopyOptionSet
   }
 }
 
+size_t File::CopyData(FILE* source, FILE* dest, size_t count)
+{
+  const size_t COPY_BUFFER_SIZE = 1024 * 1024;
+  vector<char> buffer(std::min(count, COPY_BUFFER_SIZE));
+  size_t copied = 0;
+  while (copied < count)
+  {
+    size_t n = fread(&buffer[0], 1, std::min(count - copied, buffer.size()), source);
+    if (ferror(source) != 0)
+    {
+      MIKTEX_FATAL_CRT_ERROR("fread");
+    }
+    if (n == 0)
+    {
+      break;
+    }
+    if (fwrite(&buffer[0], 1, n, dest) != n)
+    {
+      MIKTEX_FATAL_CRT_ERROR("fwrite");
+    }
+    copied += n;
+  }
+  return copied;
+}
+
 void File::CreateLink(const PathName& oldName, const PathName& newName, CreateLinkOptionSet options)
 {
   if (options[CreateLinkOption::ReplaceExisting] && File::Exists(newName) )
@@ -595,6 +620,30 @@ void File::Unlock(HANDLE hFile)
   }
 }
 
+void File::Sync(FILE* file)
+{
+  if (fflush(file) != 0)
+  {
+    MIKTEX_FATAL_CRT_ERROR("fflush");
+  }
+  if (!FlushFileBuffers(reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(file)))))
+  {
+    MIKTEX_FATAL_WINDOWS_ERROR("FlushFileBuffers");
+  }
+}
+
+void File::SetSize(FILE* file, size_t size)
+{
+  if (fflush(file) != 0)
+  {
+    MIKTEX_FATAL_CRT_ERROR("fflush");
+  }
+  if (_chsize_s(_fileno(file), size) != 0)
+  {
+    MIKTEX_FATAL_CRT_ERROR("_chsize_s");
+  }
+}
+
 void File::Unlock(int fd)
 {
   Unlock(reinterpret_cast<HANDLE>(_get_osfhandle(fd)));
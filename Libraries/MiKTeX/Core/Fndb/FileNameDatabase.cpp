@@ -29,9 +29,13 @@
 #include <unistd.h>
 #endif
 
+#include <algorithm>
+
 #include <fmt/format.h>
 #include <fmt/ostream.h>
 
+#include <miktex/Core/ConfigNames>
+#include <miktex/Core/Directory>
 #include <miktex/Core/File>
 #include <miktex/Core/FileStream>
 #include <miktex/Core/LockFile>
@@ -44,6 +48,9 @@
 #include "internal.h"
 
 #include "FileNameDatabase.h"
+#include "FndbManager.h"
+#include "PathPatternMatcher.h"
+#include "Session/SessionImpl.h"
 #include "Utils/CoreStopWatch.h"
 #include "Utils/inliners.h"
 
@@ -77,56 +84,13 @@ FileNameDatabase::~FileNameDatabase()
   }
 }
 
-// FIXME: not UTF-8 safe
-MIKTEXSTATICFUNC(bool) Match(const char* pathPattern, const char* path)
-{
-  MIKTEX_ASSERT(PathName(pathPattern).IsComparable());
-  MIKTEX_ASSERT(PathName(path).IsComparable());
-  int lastch = 0;
-  for (; *pathPattern != 0 && *path != 0; ++pathPattern, ++path)
-  {
-    if (*pathPattern == *path)
-    {
-      lastch = *path;
-      continue;
-    }
-    MIKTEX_ASSERT(RECURSION_INDICATOR_LENGTH == 2);
-    MIKTEX_ASSERT(IsDirectoryDelimiter(RECURSION_INDICATOR[0]));
-    MIKTEX_ASSERT(IsDirectoryDelimiter(RECURSION_INDICATOR[1]));
-    if (*pathPattern == RECURSION_INDICATOR[1] && IsDirectoryDelimiter(lastch))
-    {
-      for (; IsDirectoryDelimiter(*pathPattern); ++pathPattern)
-      {
-      };
-      if (*pathPattern == 0)
-      {
-        return true;
-      }
-      for (; *path != 0; ++path)
-      {
-        if (IsDirectoryDelimiter(lastch))
-        {
-          // RECURSION
-          if (Match(pathPattern, path))
-          {
-            return true;
-          }
-        }
-        lastch = *path;
-      }
-    }
-    return false;
-  }
-  return (*pathPattern == 0 || strcmp(pathPattern, RECURSION_INDICATOR) == 0 || strcmp(pathPattern, "/") == 0) && *path == 0;
-}
-
 bool FileNameDatabase::Search(const PathName& relativePath, const string& pathPattern_, bool firstMatchOnly, vector<Fndb::Record>& result)
 {
   string pathPattern = pathPattern_;
 
-  ApplyChangeFile();
+  RevalidateChangeFile();
 
-  trace_fndb->WriteLine("core", fmt::format(T_("fndb search: rootDirectory={0}, relativePath={1}, pathpattern={2}"), Q_(rootDirectory), Q_(relativePath), Q_(pathPattern)));
+  MIKTEX_TRACE_WRITE_LINE(trace_fndb, "core", fmt::format(T_("fndb search: rootDirectory={0}, relativePath={1}, pathpattern={2}"), Q_(rootDirectory), Q_(relativePath), Q_(pathPattern)));
 
   MIKTEX_ASSERT(result.size() == 0);
   MIKTEX_ASSERT(!Utils::IsAbsolutePath(relativePath));
@@ -151,8 +115,7 @@ bool FileNameDatabase::Search(const PathName& relativePath, const string& pathPa
   }
 
   // check to see whether we have this file name
-  pair<FileNameHashTable::const_iterator, FileNameHashTable::const_iterator> range = fileNames.equal_range(MakeKey(fileName));
-  if (range.first == range.second)
+  if (!HasFileName(fileName.ToString()))
   {
     return false;
   }
@@ -170,32 +133,53 @@ bool FileNameDatabase::Search(const PathName& relativePath, const string& pathPa
 
   PathName comparablePathPattern(pathPattern);
   comparablePathPattern.TransformForComparison();
+  PathPatternMatcher matcher(comparablePathPattern.ToString());
 
-  for (FileNameHashTable::const_iterator it = range.first; it != range.second; ++it)
+  // returns false, if the search is complete
+  auto matchRecord = [this, &matcher, &fileName, firstMatchOnly, &result](const char* relativeDirectory, const char* comparableRelativeDirectory, const char* info)
   {
-    PathName relativeDirectory;
-    relativeDirectory = it->second.GetDirectory();
-    if (Match(comparablePathPattern.GetData(), PathName(relativeDirectory).TransformForComparison().GetData()))
+    if (!matcher.Match(comparableRelativeDirectory))
     {
-      PathName path;
-      path = rootDirectory;
-      path /= relativeDirectory;
-      path /= fileName;
-      trace_fndb->WriteLine("core", fmt::format(T_("found: {0} ({1})"), Q_(path), Q_(it->second.GetInfo())));
-      result.push_back({ path, it->second.GetInfo() });
-      if (firstMatchOnly)
-      {
-        break;
-      }
+      return true;
     }
+    PathName path;
+    path = rootDirectory;
+    path /= relativeDirectory;
+    path /= fileName;
+    MIKTEX_TRACE_WRITE_LINE(trace_fndb, "core", fmt::format(T_("found: {0} ({1})"), Q_(path), Q_(info)));
+    result.push_back({ path, info });
+    return !firstMatchOnly;
+  };
+
+  bool more = true;
+
+  ForEachRecord(fileName.GetData(), [this, &more, &matchRecord](FndbWord idx, const FileNameDatabaseRecord& rec)
+  {
+    more = matchRecord(GetString(rec.foDirectory), GetString(rec.foComparableDirectory), GetString(rec.foInfo));
+    return more;
+  });
+
+  pair<FileNameHashTable::const_iterator, FileNameHashTable::const_iterator> range = fileNames.equal_range(MakeKey(fileName));
+  for (FileNameHashTable::const_iterator it = range.first; more && it != range.second; ++it)
+  {
+    more = matchRecord(it->second.GetDirectory().c_str(), it->second.GetComparableDirectory().c_str(), it->second.GetInfo().c_str());
   }
 
   return !result.empty();
 }
 
-void FileNameDatabase::Add(const vector<Fndb::Record>& records)
+void FileNameDatabase::Add(const vector<Fndb::Record>& records, bool deferCommit)
 {
-  FileStream writer(OpenChangeFileExclusively());
+  FileStream writer;
+  if (deferCommit)
+  {
+    RevalidateChangeFile();
+  }
+  else
+  {
+    // pick up the changes made by other processes before applying ours
+    writer.Attach(OpenChangeFileExclusively());
+  }
   for (const auto& rec : records)
   {
     string fileName;
@@ -203,70 +187,128 @@ void FileNameDatabase::Add(const vector<Fndb::Record>& records)
     std::tie(fileName, directory) = SplitPath(rec.path);
     if (InsertRecord(Record(fileName, directory, rec.fileNameInfo)))
     {
-      string s = fmt::format("+{0}{1}{2}{1}{3}\n", fileName, char(PathName::PathNameDelimiter), directory, rec.fileNameInfo);
-      fputs(s.c_str(), writer.GetFile());
-      changeFileRecordCount++;
-      changeFileSize += s.length();
+      uncommittedChanges += fmt::format("+{0}{1}{2}{1}{3}\n", fileName, char(PathName::PathNameDelimiter), directory, rec.fileNameInfo);
+      uncommittedRecordCount++;
     }
   }
-  fflush(writer.GetFile());
-#if 1
-  // TODO: File::Sync API
-#if defined(MIKTEX_WINDOWS)
-  if (!FlushFileBuffers(reinterpret_cast<HANDLE>(_get_osfhandle(fileno(writer.GetFile())))))
-  {
-    MIKTEX_FATAL_WINDOWS_ERROR("FlushFileBuffers");
-  }
-#else
-  if (fsync(fileno(writer.GetFile())) != 0)
+  if (!deferCommit)
   {
-    MIKTEX_FATAL_CRT_ERROR("fsync");
+    WriteChanges(writer);
   }
-#endif
-#endif
-  File::Unlock(writer.GetFile());
-  writer.Close();
 }
 
-void FileNameDatabase::Remove(const vector<PathName>& paths)
+void FileNameDatabase::Remove(const vector<PathName>& paths, bool deferCommit)
 {
-  FileStream writer(OpenChangeFileExclusively());
+  FileStream writer;
+  if (deferCommit)
+  {
+    RevalidateChangeFile();
+  }
+  else
+  {
+    // pick up the changes made by other processes before applying ours
+    writer.Attach(OpenChangeFileExclusively());
+  }
   for (const auto& path : paths)
   {
     string fileName;
     string directory;
     std::tie(fileName, directory) = SplitPath(path);
+    if (!HasRecord(fileName, directory))
+    {
+      // another process has removed the record
+      trace_fndb->WriteLine("core", fmt::format(T_("{0} has already been removed"), Q_(path)));
+      continue;
+    }
     EraseRecord(Record(fileName, directory, ""));
-    string s = fmt::format("-{}{}{}\n", fileName, char(PathName::PathNameDelimiter), directory);
-    fputs(s.c_str(), writer.GetFile());
-    changeFileRecordCount++;
-    changeFileSize += s.length();
-  }
-  fflush(writer.GetFile());
-#if 1
-  // TODO: File::Sync API
-#if defined(MIKTEX_WINDOWS)
-  if (!FlushFileBuffers(reinterpret_cast<HANDLE>(_get_osfhandle(fileno(writer.GetFile())))))
+    uncommittedChanges += fmt::format("-{}{}{}\n", fileName, char(PathName::PathNameDelimiter), directory);
+    uncommittedRecordCount++;
+  }
+  if (!deferCommit)
   {
-    MIKTEX_FATAL_WINDOWS_ERROR("FlushFileBuffers");
+    WriteChanges(writer);
   }
-#else
-  if (fsync(fileno(writer.GetFile())) != 0)
+}
+
+void FileNameDatabase::Commit()
+{
+  if (uncommittedChanges.empty())
   {
-    MIKTEX_FATAL_CRT_ERROR("fsync");
+    return;
   }
-#endif
-#endif
+  // this also rebases the uncommitted records on top of the changes
+  // made by other processes
+  FileStream writer(OpenChangeFileExclusively());
+  WriteChanges(writer);
+}
+
+// appends the uncommitted records to the exclusively locked change
+// file and releases the lock
+void FileNameDatabase::WriteChanges(FileStream& writer)
+{
+  if (uncommittedChanges.empty())
+  {
+    File::Unlock(writer.GetFile());
+    writer.Close();
+    return;
+  }
+  if (uncommittedRecordCount > 1)
+  {
+    trace_fndb->WriteLine("core", fmt::format(T_("committing {0} change records to {1}"), uncommittedRecordCount, Q_(changeFile)));
+  }
+  // switch from reading to writing
+  writer.Seek(0, SeekOrigin::End);
+  writer.Write(uncommittedChanges.c_str(), uncommittedChanges.length());
+  File::Sync(writer.GetFile());
+  changeFileRecordCount += uncommittedRecordCount;
+  changeFileSize += uncommittedChanges.length();
+  uncommittedChanges.clear();
+  uncommittedRecordCount = 0;
   File::Unlock(writer.GetFile());
   writer.Close();
+  // the compaction must not hold the lock: other processes would
+  // stall while the new FNDB file is built
+  if (compactionThreshold > 0 && changeFileRecordCount >= std::max(compactionThreshold, compactionRetryRecordCount))
+  {
+    if (!Compact())
+    {
+      compactionRetryRecordCount = changeFileRecordCount + compactionThreshold;
+    }
+  }
 }
 
 bool FileNameDatabase::FileExists(const PathName& path)
 {
-  ApplyChangeFile();
+  RevalidateChangeFile();
   string fileName;
   string directory;
   std::tie(fileName, directory) = SplitPath(path);
+  return HasRecord(fileName, directory);
+}
+
+bool FileNameDatabase::HasFileName(const string& fileName) const
+{
+  bool found = false;
+  ForEachRecord(fileName.c_str(), [&found](FndbWord idx, const FileNameDatabaseRecord& rec)
+  {
+    found = true;
+    return false;
+  });
+  return found || fileNames.find(MakeKey(fileName)) != fileNames.end();
+}
+
+bool FileNameDatabase::HasRecord(const string& fileName, const string& directory) const
+{
+  bool found = false;
+  ForEachRecord(fileName.c_str(), [this, &directory, &found](FndbWord idx, const FileNameDatabaseRecord& rec)
+  {
+    found = PathName::Compare(GetString(rec.foDirectory), directory.c_str()) == 0;
+    return !found;
+  });
+  if (found)
+  {
+    return true;
+  }
   pair<FileNameHashTable::const_iterator, FileNameHashTable::const_iterator> range = fileNames.equal_range(MakeKey(fileName));
   for (FileNameHashTable::const_iterator it = range.first; it != range.second; ++it)
   {
@@ -310,16 +352,11 @@ void FileNameDatabase::FastInsertRecord(FileNameDatabase::Record&& record)
 
 bool FileNameDatabase::InsertRecord(FileNameDatabase::Record&& record)
 {
-  string key = MakeKey(record.fileName);
-  pair<FileNameHashTable::const_iterator, FileNameHashTable::const_iterator> range = fileNames.equal_range(key);
-  for (FileNameHashTable::const_iterator it = range.first; it != range.second; ++it)
+  if (HasRecord(record.fileName, record.GetDirectory()))
   {
-    if (PathName::Compare(it->second.GetDirectory(), record.GetDirectory()) == 0)
-    {
-      return false;
-    }
+    return false;
   }
-  fileNames.insert(pair<string, Record>(std::move(key), std::move(record)));
+  FastInsertRecord(std::move(record));
   return true;
 }
 
@@ -342,12 +379,17 @@ string FileNameDatabase::MakeKey(const PathName& fileName) const
 
 void FileNameDatabase::EraseRecord(const FileNameDatabase::Record& record)
 {
-  pair<FileNameHashTable::const_iterator, FileNameHashTable::const_iterator> range = fileNames.equal_range(MakeKey(record.fileName));
-  if (range.first == range.second)
+  vector<FndbWord> toBeRemovedFromFndb;
+  ForEachRecord(record.fileName.c_str(), [this, &record, &toBeRemovedFromFndb](FndbWord idx, const FileNameDatabaseRecord& rec)
   {
-    MIKTEX_FATAL_ERROR_2(T_("The file name record could not be found in the database."), "fileName", record.fileName);
-  }
+    if (PathName::Compare(GetString(rec.foDirectory), record.GetDirectory().c_str()) == 0)
+    {
+      toBeRemovedFromFndb.push_back(idx);
+    }
+    return true;
+  });
   vector<FileNameHashTable::const_iterator> toBeRemoved;
+  pair<FileNameHashTable::const_iterator, FileNameHashTable::const_iterator> range = fileNames.equal_range(MakeKey(record.fileName));
   for (FileNameHashTable::const_iterator it = range.first; it != range.second; ++it)
   {
     if (PathName::Compare(it->second.GetDirectory(), record.GetDirectory()) == 0)
@@ -355,30 +397,17 @@ void FileNameDatabase::EraseRecord(const FileNameDatabase::Record& record)
       toBeRemoved.push_back(it);
     }
   }
-  if (toBeRemoved.empty())
+  if (toBeRemovedFromFndb.empty() && toBeRemoved.empty())
   {
     MIKTEX_FATAL_ERROR_2(T_("The file name record could not be found in the database."), "fileName", record.fileName, "directory", record.GetDirectory());
   }
-  for (const auto& it : toBeRemoved)
+  for (FndbWord idx : toBeRemovedFromFndb)
   {
-    fileNames.erase(it);
+    removedRecords.insert(idx);
   }
-}
-
-void FileNameDatabase::ReadFileNames()
-{
-  fileNames.clear();
-  fileNames.rehash(fndbHeader->numFiles);
-  CoreStopWatch stopWatch(fmt::format("fndb read file names {}", Q_(rootDirectory)));
-  ReadFileNames(GetTable());
-}
-
-void FileNameDatabase::ReadFileNames(const FileNameDatabaseRecord* table)
-{
-  for (size_t idx = 0; idx < fndbHeader->numFiles; ++idx)
+  for (const auto& it : toBeRemoved)
   {
-    const FileNameDatabaseRecord* rec = &table[idx];
-    FastInsertRecord(Record(this, GetString(rec->foFileName), rec->foDirectory, rec->foInfo));
+    fileNames.erase(it);
   }
 }
 
@@ -398,91 +427,284 @@ void FileNameDatabase::Finalize()
 
 void FileNameDatabase::Initialize(const PathName& fndbPath, const PathName& rootDirectory)
 {
+  this->fndbPath = fndbPath;
   this->rootDirectory = rootDirectory;
 
   OpenFileNameDatabase(fndbPath);
-  ReadFileNames();
 
   changeFile = fndbPath;
   changeFile.SetExtension(MIKTEX_FNDB_CHANGE_FILE_SUFFIX);
-  
+
   ApplyChangeFile();
 }
 
-void FileNameDatabase::ApplyChangeFile()
+void FileNameDatabase::ReadConfiguration()
 {
-  lastAccessTime = chrono::high_resolution_clock::now();
-  if (!File::Exists(changeFile))
+  if (haveConfiguration)
   {
     return;
   }
-  size_t newChangeFileSize = File::GetSize(changeFile);
-  if (newChangeFileSize == changeFileSize)
+  // reading configuration values might search this FNDB
+  haveConfiguration = true;
+  shared_ptr<SessionImpl> session = SessionImpl::GetSession();
+  changeFileRevalidationInterval = chrono::milliseconds(session->GetConfigValue(MIKTEX_CONFIG_SECTION_CORE, MIKTEX_CONFIG_VALUE_FNDBREVALIDATIONINTERVAL, 1000).GetInt());
+  compactionThreshold = session->GetConfigValue(MIKTEX_CONFIG_SECTION_CORE, MIKTEX_CONFIG_VALUE_FNDBCOMPACTIONTHRESHOLD, 1000).GetInt();
+}
+
+// changes made by this process are applied immediately; changes made
+// by other processes are picked up once the revalidation interval has
+// elapsed
+void FileNameDatabase::RevalidateChangeFile()
+{
+  ReadConfiguration();
+  lastAccessTime = chrono::high_resolution_clock::now();
+  if (lastAccessTime < nextChangeFileRevalidation)
   {
     return;
   }
-  MIKTEX_ASSERT(newChangeFileSize > changeFileSize);
-  CoreStopWatch stopWatch(fmt::format(T_("applying FNDB change file {0} starting at record #{1}"), Q_(changeFile), changeFileRecordCount));
-  FileStream reader(File::Open(changeFile, FileMode::Open, FileAccess::Read, false));
-  if (!File::TryLock(reader.GetFile(), File::LockType::Shared, 2s))
-  {
-    MIKTEX_FATAL_ERROR_2(T_("Could not acquire shared lock."), "path", changeFile.ToString());
-  }
-  if (changeFileSize > 0)
-  {
-    reader.Seek(changeFileSize, SeekOrigin::Begin);
-  }
-  for (string line; Utils::ReadLine(line, reader.GetFile(), false); )
-  {
-    if (line.empty())
+  ApplyChangeFile();
+}
+
+// reads the records which other processes have appended to the change
+// file; lockedChangeFile, if not null, is the change file opened by
+// OpenChangeFileExclusively()
+void FileNameDatabase::ApplyChangeFile(FILE* lockedChangeFile)
+{
+  lastAccessTime = chrono::high_resolution_clock::now();
+  nextChangeFileRevalidation = lastAccessTime + changeFileRevalidationInterval;
+  bool changeFileExists = File::Exists(changeFile);
+  size_t newChangeFileSize = changeFileExists ? File::GetSize(changeFile) : 0;
+  bool reloaded = false;
+  if (newChangeFileSize < changeFileSize || File::Exists(fndbPath) && File::GetLastWriteTime(fndbPath) != fndbLastWriteTime)
+  {
+    // another process has compacted or recreated the FNDB
+    Reload();
+    reloaded = true;
+  }
+  bool haveNewRecords = false;
+  if (changeFileExists && newChangeFileSize != changeFileSize)
+  {
+    MIKTEX_ASSERT(newChangeFileSize > changeFileSize);
+    CoreStopWatch stopWatch(fmt::format(T_("applying FNDB change file {0} starting at record #{1}"), Q_(changeFile), changeFileRecordCount));
+    FileStream reader;
+    FILE* file = lockedChangeFile;
+    if (file == nullptr)
     {
-      MIKTEX_FATAL_ERROR_2(T_("FNDB change file has been tampered with."), "path", changeFile.ToString());
+      reader.Attach(File::Open(changeFile, FileMode::Open, FileAccess::Read, false));
+      if (!File::TryLock(reader.GetFile(), File::LockType::Shared, 2s))
+      {
+        MIKTEX_FATAL_ERROR_2(T_("Could not acquire shared lock."), "path", changeFile.ToString());
+      }
+      file = reader.GetFile();
     }
-    changeFileRecordCount++;
-    changeFileSize += line.length() + sizeof('\n');
-    string op = line.substr(0, 1);
-    vector<string> data = StringUtil::Split(line.substr(1), PathName::PathNameDelimiter);
-    if (data.size() < 2)
+    // else: a second handle would conflict with our own lock
+    if (fseek(file, changeFileSize, SEEK_SET) != 0)
     {
-      MIKTEX_FATAL_ERROR_2(T_("FNDB change file has been tampered with."), "path", changeFile.ToString());
+      MIKTEX_FATAL_CRT_ERROR_2("fseek", "path", changeFile.ToString());
+    }
+    // the uncommitted changes have already been applied, i.e., the
+    // records of other processes might be redundant
+    bool replay = !uncommittedChanges.empty();
+    for (string line; Utils::ReadLine(line, file, false); )
+    {
+      changeFileRecordCount++;
+      changeFileSize += line.length() + sizeof('\n');
+      ApplyChange(line, replay);
+    }
+    haveNewRecords = true;
+    if (lockedChangeFile == nullptr)
+    {
+      File::Unlock(reader.GetFile());
+      reader.Close();
     }
-    string& fileName = data[0];
-    string& directory = data[1];
-    if (op == "+")
+  }
+  if ((reloaded || haveNewRecords) && !uncommittedChanges.empty())
+  {
+    // the uncommitted changes must follow the changes of other
+    // processes: apply them again, skipping those which are already
+    // covered by the database
+    string changes;
+    changes.swap(uncommittedChanges);
+    uncommittedRecordCount = 0;
+    for (const string& line : StringUtil::Split(changes, '\n'))
     {
-      if (data.size() < 3)
+      if (!line.empty() && ApplyChange(line, true))
       {
-        MIKTEX_FATAL_ERROR_2(T_("FNDB change file has been tampered with."), "path", changeFile.ToString());
+        uncommittedChanges += line;
+        uncommittedChanges += '\n';
+        uncommittedRecordCount++;
       }
-      string& fileNameInfo = data[2];
-      FastInsertRecord(Record(std::move(fileName), std::move(directory), std::move(fileNameInfo)));
     }
-    else if (op == "-")
+  }
+}
+
+// applies a change file record; returns false, if an uncommitted
+// record (replay) has no effect
+bool FileNameDatabase::ApplyChange(const string& line, bool replay)
+{
+  if (line.empty())
+  {
+    MIKTEX_FATAL_ERROR_2(T_("FNDB change file has been tampered with."), "path", changeFile.ToString());
+  }
+  string op = line.substr(0, 1);
+  vector<string> data = StringUtil::Split(line.substr(1), PathName::PathNameDelimiter);
+  if (data.size() < 2)
+  {
+    MIKTEX_FATAL_ERROR_2(T_("FNDB change file has been tampered with."), "path", changeFile.ToString());
+  }
+  string& fileName = data[0];
+  string& directory = data[1];
+  if (op == "+")
+  {
+    if (data.size() < 3)
     {
-      EraseRecord(Record(std::move(fileName), std::move(directory), ""));
+      MIKTEX_FATAL_ERROR_2(T_("FNDB change file has been tampered with."), "path", changeFile.ToString());
     }
-    else
+    string& fileNameInfo = data[2];
+    if (replay)
     {
-      MIKTEX_FATAL_ERROR_2(T_("FNDB change file has been tampered with."), "path", changeFile.ToString());
+      return InsertRecord(Record(std::move(fileName), std::move(directory), std::move(fileNameInfo)));
     }
+    FastInsertRecord(Record(std::move(fileName), std::move(directory), std::move(fileNameInfo)));
   }
-  File::Unlock(reader.GetFile());
-  reader.Close();
+  else if (op == "-")
+  {
+    if (replay && !HasRecord(fileName, directory))
+    {
+      return false;
+    }
+    EraseRecord(Record(std::move(fileName), std::move(directory), ""));
+  }
+  else
+  {
+    MIKTEX_FATAL_ERROR_2(T_("FNDB change file has been tampered with."), "path", changeFile.ToString());
+  }
+  return true;
 }
 
+// locks the change file and applies the changes made by other
+// processes; the returned file is open for reading and appending
 FILE* FileNameDatabase::OpenChangeFileExclusively()
 {
-  ApplyChangeFile();
-  FileStream writer(File::Open(changeFile, FileMode::Append, FileAccess::Write, false));
+  FileStream writer(File::Open(changeFile, FileMode::Append, FileAccess::ReadWrite, false));
   if (!File::TryLock(writer.GetFile(), File::LockType::Exclusive, 2s))
   {
     MIKTEX_FATAL_ERROR_2(T_("Could not acquire exclusive lock."), "path", changeFile.ToString());
   }
+  ApplyChangeFile(writer.GetFile());
   return writer.Detach();
 }
 
+void FileNameDatabase::Reload()
+{
+  trace_fndb->WriteLine("core", fmt::format(T_("reloading fndb {0}"), Q_(fndbPath)));
+  if (mmap->GetPtr() != nullptr)
+  {
+    mmap->Close();
+  }
+  fileNames.clear();
+  removedRecords.clear();
+  changeFileSize = 0;
+  changeFileRecordCount = 0;
+  compactionRetryRecordCount = 0;
+  OpenFileNameDatabase(fndbPath);
+}
+
+// merges the change file into the FNDB file; the new FNDB file is
+// built from the state of this process without holding the change
+// file lock; the lock is only taken to swap in the new file, which is
+// discarded if another process has changed the change file or the
+// FNDB file in the meantime
+bool FileNameDatabase::Compact()
+{
+  CoreStopWatch stopWatch(fmt::format(T_("compacting FNDB {0} ({1} change records)"), Q_(fndbPath), changeFileRecordCount));
+  size_t snapshotChangeFileSize = changeFileSize;
+  time_t snapshotFndbLastWriteTime = fndbLastWriteTime;
+  FndbManager fndbManager;
+  const FileNameDatabaseRecord* table = GetTable();
+  for (FndbWord idx = 0; idx < fndbHeader->numFiles; ++idx)
+  {
+    if (removedRecords.find(idx) == removedRecords.end())
+    {
+      fndbManager.AddRecord(GetString(table[idx].foFileName), GetString(table[idx].foDirectory), GetString(table[idx].foInfo));
+    }
+  }
+  for (const auto& kv : fileNames)
+  {
+    fndbManager.AddRecord(kv.second.fileName, kv.second.GetDirectory(), kv.second.GetInfo());
+  }
+  // keep the directory time stamps for incremental updates
+  const FileNameDatabaseDirectoryRecord* directoryTable = GetDirectoryTable();
+  for (FndbWord idx = 0; idx < fndbHeader->numDirectoryRecords; ++idx)
+  {
+    fndbManager.AddDirectoryRecord(GetString(directoryTable[idx].foDirectory), static_cast<time_t>(directoryTable[idx].lastWriteTime));
+  }
+  PathName newFndbPath;
+  try
+  {
+    newFndbPath = fndbManager.WriteCompacted(fndbPath);
+  }
+  catch (const MiKTeXException& e)
+  {
+    trace_fndb->WriteLine("core", fmt::format(T_("fndb compaction failed: {0}"), e.GetErrorMessage()));
+    return false;
+  }
+  bool swapped = false;
+  bool unmapped = false;
+  FileStream lockedChangeFile(File::Open(changeFile, FileMode::Append, FileAccess::ReadWrite, false));
+  if (!File::TryLock(lockedChangeFile.GetFile(), File::LockType::Exclusive, 2s))
+  {
+    trace_fndb->WriteLine("core", T_("fndb compaction discarded: change file is locked"));
+  }
+  else
+  {
+    if (File::GetSize(changeFile) != snapshotChangeFileSize || File::GetLastWriteTime(fndbPath) != snapshotFndbLastWriteTime)
+    {
+      trace_fndb->WriteLine("core", T_("fndb compaction discarded: fndb has been changed by another process"));
+    }
+    else
+    {
+#if defined(MIKTEX_WINDOWS)
+      // a mapped file cannot be replaced
+      mmap->Close();
+      unmapped = true;
+#endif
+      try
+      {
+        File::Move(newFndbPath, fndbPath, { FileMoveOption::ReplaceExisting });
+        swapped = true;
+        // make the rename durable before the change file is emptied
+        Directory::Sync(fndbPath.GetDirectoryName());
+        File::SetSize(lockedChangeFile.GetFile(), 0);
+      }
+      catch (const MiKTeXException& e)
+      {
+        // not fatal: other processes may still have mapped the FNDB file
+        trace_fndb->WriteLine("core", fmt::format(T_("fndb compaction failed: {0}"), e.GetErrorMessage()));
+      }
+    }
+    File::Unlock(lockedChangeFile.GetFile());
+  }
+  lockedChangeFile.Close();
+  if (!swapped && File::Exists(newFndbPath))
+  {
+    File::Delete(newFndbPath);
+  }
+  if (swapped || unmapped)
+  {
+    Reload();
+  }
+  if (swapped)
+  {
+    trace_fndb->WriteLine("core", T_("fndb compaction completed"));
+  }
+  return swapped;
+}
+
 void FileNameDatabase::OpenFileNameDatabase(const PathName& fndbPath)
 {
+  fndbLastWriteTime = File::GetLastWriteTime(fndbPath);
+
   mmap->Open(fndbPath, false);
 
   if (mmap->GetSize() < sizeof(*fndbHeader))
@@ -505,6 +727,32 @@ void FileNameDatabase::OpenFileNameDatabase(const PathName& fndbPath)
   {
     MIKTEX_FATAL_ERROR_2(T_("Unknown file name database file version."), "path", fndbPath.ToString(), "versionFound", std::to_string(fndbHeader->Version), "versionExpected", std::to_string(FileNameDatabaseHeader::Version));
   }
+
+  // check the hash table
+  FndbWord hashTableSize = fndbHeader->hashTableSize;
+  if (hashTableSize <= fndbHeader->numFiles
+    || (hashTableSize & (hashTableSize - 1)) != 0
+    || fndbHeader->foHashTable < sizeof(*fndbHeader)
+    || static_cast<size_t>(fndbHeader->foHashTable) + hashTableSize * sizeof(FndbHashTableSlot) > foEnd)
+  {
+    MIKTEX_FATAL_ERROR_2(T_("Not a file name database file (corrupted hash table)."), "path", fndbPath.ToString());
+  }
+
+  // check the record table
+  if (fndbHeader->numFiles > 0
+    && (fndbHeader->foTable < sizeof(*fndbHeader)
+      || static_cast<size_t>(fndbHeader->foTable) + static_cast<size_t>(fndbHeader->numFiles) * sizeof(FileNameDatabaseRecord) > foEnd))
+  {
+    MIKTEX_FATAL_ERROR_2(T_("Not a file name database file (corrupted record table)."), "path", fndbPath.ToString());
+  }
+
+  // check the directory table
+  if (fndbHeader->numDirectoryRecords > 0
+    && (fndbHeader->foDirectoryTable < sizeof(*fndbHeader)
+      || static_cast<size_t>(fndbHeader->foDirectoryTable) + static_cast<size_t>(fndbHeader->numDirectoryRecords) * sizeof(FileNameDatabaseDirectoryRecord) > foEnd))
+  {
+    MIKTEX_FATAL_ERROR_2(T_("Not a file name database file (corrupted directory table)."), "path", fndbPath.ToString());
+  }
 }
 
 void FileNameDatabase::CloseFileNameDatabase()
@@ -26,9 +26,12 @@
 
 #include <chrono>
 #include <tuple>
+#include <unordered_map>
+#include <unordered_set>
 
 #include <miktex/Core/Debug>
 #include <miktex/Core/DirectoryLister>
+#include <miktex/Core/FileStream>
 #include <miktex/Core/Fndb>
 #include <miktex/Core/MemoryMappedFile>
 #include <miktex/Core/PathName>
@@ -54,11 +57,23 @@ public:
 public:
   bool Search(const MiKTeX::Core::PathName& relativePath, const std::string& pathPattern, bool firstMatchOnly, std::vector<MiKTeX::Core::Fndb::Record>& result);
 
+  // changes are applied on top of the changes made by other
+  // processes; if deferCommit is true, they are written to the change
+  // file by the next Commit()
 public:
-  void Add(const std::vector<MiKTeX::Core::Fndb::Record>& records);
+  void Add(const std::vector<MiKTeX::Core::Fndb::Record>& records, bool deferCommit = false);
 
 public:
-  void Remove(const std::vector<MiKTeX::Core::PathName>& paths);
+  void Remove(const std::vector<MiKTeX::Core::PathName>& paths, bool deferCommit = false);
+
+public:
+  void Commit();
+
+public:
+  bool HasUncommittedChanges() const
+  {
+    return !uncommittedChanges.empty();
+  }
 
 public:
   bool FileExists(const MiKTeX::Core::PathName& path);
@@ -72,66 +87,45 @@ public:
 private:
   struct Record
   {
-  public:
-    Record(const FileNameDatabase* fndb, std::string&& fileName, FndbByteOffset foDirectory, FndbByteOffset foInfo) :
-      fndb(fndb),
-      fileName(std::move(fileName)),
-      foDirectory(foDirectory),
-      foInfo(foInfo)
-    {
-    }
   public:
     Record(const std::string& fileName, const std::string& directory, const std::string& info) :
       fileName(fileName),
       directory(directory),
-      info(info)
+      info(info),
+      comparableDirectory(MiKTeX::Core::PathName(this->directory).TransformForComparison().ToString())
     {
     }
   public:
     Record(std::string&& fileName, std::string&& directory, std::string&& info) :
       fileName(std::move(fileName)),
       directory(std::move(directory)),
-      info(std::move(info))
+      info(std::move(info)),
+      comparableDirectory(MiKTeX::Core::PathName(this->directory).TransformForComparison().ToString())
     {
     }
   public:
-    std::string GetDirectory() const
+    const std::string& GetDirectory() const
     {
-      if (foDirectory != 0)
-      {
-        MIKTEX_ASSERT(fndb != nullptr);
-        return fndb->GetString(foDirectory);
-      }
-      else
-      {
-        return directory;
-      }
+      return directory;
     }
   public:
-    std::string GetInfo() const
+    const std::string& GetComparableDirectory() const
     {
-      if (foInfo != 0)
-      {
-        MIKTEX_ASSERT(fndb != nullptr);
-        return fndb->GetString(foInfo);
-      }
-      else
-      {
-        return info;
-      }
+      return comparableDirectory;
+    }
+  public:
+    const std::string& GetInfo() const
+    {
+      return info;
     }
-  private:
-    const FileNameDatabase* fndb = nullptr;
   public:
     std::string fileName;
-  private:
-    FndbByteOffset foDirectory = 0;
   private:
     std::string directory;
-  private:
-    FndbByteOffset foInfo = 0;
   private:
     std::string info;
+  private:
+    std::string comparableDirectory;
   };
 
 private:
@@ -143,6 +137,12 @@ private:
 private:
   std::string MakeKey(const MiKTeX::Core::PathName& fileName) const;
 
+private:
+  bool HasFileName(const std::string& fileName) const;
+
+private:
+  bool HasRecord(const std::string& fileName, const std::string& directory) const;
+
 private:
   void FastInsertRecord(Record&& record);
 
@@ -152,11 +152,6 @@ private:
 private:
   void EraseRecord(const Record& record);
   
-private:
-  void ReadFileNames();
-
-private:
-  void ReadFileNames(const FileNameDatabaseRecord* table);
 private:
   void Finalize();
 
@@ -195,15 +190,76 @@ private:
     return reinterpret_cast<const FileNameDatabaseRecord*>(GetPointer(fndbHeader->foTable));
   }
 
+private:
+  const FndbHashTableSlot* GetHashTable() const
+  {
+    return reinterpret_cast<const FndbHashTableSlot*>(GetPointer(fndbHeader->foHashTable));
+  }
+
+private:
+  const FileNameDatabaseDirectoryRecord* GetDirectoryTable() const
+  {
+    return reinterpret_cast<const FileNameDatabaseDirectoryRecord*>(GetPointer(fndbHeader->foDirectoryTable));
+  }
+
+  // probes the mmap-resident hash table; func(idx, rec) is called for
+  // each record (not removed by the change file) whose file name
+  // matches; iteration stops when func returns false
+private:
+  template<typename Func> void ForEachRecord(const char* fileName, Func func) const
+  {
+    const FileNameDatabaseRecord* table = GetTable();
+    const FndbHashTableSlot* slots = GetHashTable();
+    FndbWord mask = fndbHeader->hashTableSize - 1;
+    FndbWord slot = FndbHash(fileName) & mask;
+    // the slots are not validated when the table is mapped: a corrupt
+    // table must neither loop forever nor index past the record table
+    for (FndbWord step = 0; step < fndbHeader->hashTableSize && slots[slot] != 0; ++step, slot = (slot + 1) & mask)
+    {
+      FndbWord idx = slots[slot] - 1;
+      if (idx >= fndbHeader->numFiles)
+      {
+        MIKTEX_FATAL_ERROR(T_("The file name database is corrupted."));
+      }
+      const FileNameDatabaseRecord& rec = table[idx];
+      if (MiKTeX::Core::PathName::Compare(GetString(rec.foFileName), fileName) != 0 || removedRecords.find(idx) != removedRecords.end())
+      {
+        continue;
+      }
+      if (!func(idx, rec))
+      {
+        return;
+      }
+    }
+  }
+
 private:
   void Initialize(const MiKTeX::Core::PathName& fndbPath, const MiKTeX::Core::PathName& rootDirectory);
 
 private:
-  void ApplyChangeFile();
+  void ReadConfiguration();
+
+private:
+  void RevalidateChangeFile();
+
+private:
+  void ApplyChangeFile(FILE* lockedChangeFile = nullptr);
+
+private:
+  bool ApplyChange(const std::string& line, bool replay);
 
 private:
   FILE* OpenChangeFileExclusively();
 
+private:
+  void WriteChanges(MiKTeX::Core::FileStream& writer);
+
+private:
+  void Reload();
+
+private:
+  bool Compact();
+
 private:
   void OpenFileNameDatabase(const MiKTeX::Core::PathName& fndbPath);
 
@@ -221,6 +277,14 @@ private:
 private:
   FileNameDatabaseHeader* fndbHeader = nullptr;
 
+  // file-system path to the FNDB file
+private:
+  MiKTeX::Core::PathName fndbPath;
+
+  // last write time of the mapped FNDB file
+private:
+  time_t fndbLastWriteTime = 0;
+
   // file-system path to root directory
 private:
   MiKTeX::Core::PathName rootDirectory;
@@ -228,9 +292,14 @@ private:
 private:
   typedef std::unordered_multimap<std::string, Record> FileNameHashTable;
 
+  // records added by the change file
 private:
   FileNameHashTable fileNames;
 
+  // indices of FNDB records removed by the change file
+private:
+  std::unordered_set<FndbWord> removedRecords;
+
 private:
   MiKTeX::Core::PathName changeFile;
   
@@ -240,9 +309,35 @@ private:
 private:
   int changeFileRecordCount = 0;
 
+  // change file records not yet committed
+private:
+  std::string uncommittedChanges;
+
+private:
+  int uncommittedRecordCount = 0;
+
 private:
   std::chrono::time_point<std::chrono::high_resolution_clock> lastAccessTime = std::chrono::high_resolution_clock::now();
 
+private:
+  bool haveConfiguration = false;
+
+  // minimum time between two checks of the change file
+private:
+  std::chrono::milliseconds changeFileRevalidationInterval{ 0 };
+
+private:
+  std::chrono::time_point<std::chrono::high_resolution_clock> nextChangeFileRevalidation;
+
+  // number of change file records which triggers a compaction
+private:
+  int compactionThreshold = 0;
+
+  // number of change file records which triggers the next attempt
+  // after a compaction has been discarded
+private:
+  int compactionRetryRecordCount = 0;
+
 private:
   std::unique_ptr<MiKTeX::Trace::TraceStream> trace_fndb;
 };
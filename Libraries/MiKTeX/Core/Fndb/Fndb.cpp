@@ -59,7 +59,8 @@ void Fndb::Add(const vector<Fndb::Record>& records)
     {
       MIKTEX_UNEXPECTED();
     }
-    fndb->Add(records);
+    fndb->Add(records, session->IsFndbTransactionActive());
+    session->InvalidateFindFileCache();
   }
   else
   {
@@ -89,7 +90,18 @@ void Fndb::Remove(const vector<PathName>& paths)
   {
     MIKTEX_UNEXPECTED();
   }
-  fndb->Remove(paths);
+  fndb->Remove(paths, session->IsFndbTransactionActive());
+  session->InvalidateFindFileCache();
+}
+
+void Fndb::BeginTransaction()
+{
+  SessionImpl::GetSession()->BeginFndbTransaction();
+}
+
+void Fndb::CommitTransaction()
+{
+  SessionImpl::GetSession()->CommitFndbTransaction();
 }
 
 bool Fndb::FileExists(const PathName& path)
@@ -0,0 +1,280 @@
+/* FndbManager.h: creating the file name database         -*- C++ -*-
+
+   Copyright (C) 1996-2019 Christian Schenk
+
+   This file is part of the MiKTeX Core Library.
+
+   The MiKTeX Core Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+
+   The MiKTeX Core Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with the MiKTeX Core Library; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#pragma once
+
+#if !defined(D3F1B0E3C5A74F6A9C1D2B6E8F4A7C51)
+#define D3F1B0E3C5A74F6A9C1D2B6E8F4A7C51
+
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <miktex/Core/Debug>
+#include <miktex/Core/Fndb>
+#include <miktex/Core/PathName>
+#include <miktex/Trace/TraceStream>
+
+#include "fndbmem.h"
+
+CORE_INTERNAL_BEGIN_NAMESPACE;
+
+struct FILENAMEINFO
+{
+  std::string FileName;
+  const std::string* Directory = nullptr;
+  const std::string* Info = nullptr;
+};
+
+struct DIRECTORYINFO
+{
+  const std::string* Directory = nullptr;
+  time_t LastWriteTime = 0;
+};
+
+class FndbManager
+{
+public:
+  FndbManager() :
+    trace_fndb(MiKTeX::Trace::TraceStream::Open(MIKTEX_TRACE_FNDB)),
+    trace_error(MiKTeX::Trace::TraceStream::Open(MIKTEX_TRACE_ERROR))
+  {
+  }
+
+public:
+  bool Create(const MiKTeX::Core::PathName& fndbPath, const MiKTeX::Core::PathName& rootPath, MiKTeX::Core::ICreateFndbCallback* callback, bool enableStringPooling, bool storeFileNameInfo);
+
+  /// Recreates an FNDB file; the contents of unchanged directories are
+  /// taken from the existing file.
+public:
+  bool Update(const MiKTeX::Core::PathName& fndbPath, const MiKTeX::Core::PathName& rootPath, MiKTeX::Core::ICreateFndbCallback* callback, bool enableStringPooling, bool storeFileNameInfo);
+
+  /// Adds a record to be written by WriteCompacted().
+public:
+  void AddRecord(const std::string& fileName, const std::string& directory, const std::string& info);
+
+  /// Adds a directory record to be written by WriteCompacted(); directory
+  /// records must be added in pre-order.
+public:
+  void AddDirectoryRecord(const std::string& directory, time_t lastWriteTime);
+
+  /// Writes a new FNDB file containing the added records; the file
+  /// is created next to the FNDB file and is on disk when the function
+  /// returns; the caller moves it into place.
+  /// @return Returns the path of the new file.
+public:
+  MiKTeX::Core::PathName WriteCompacted(const MiKTeX::Core::PathName& fndbPath);
+
+public:
+  struct DirectoryNode
+  {
+    MiKTeX::Core::PathName parentPath;
+    std::string folderName;
+    size_t level = 0;
+    std::string directory;
+    time_t lastWriteTime = 0;
+    bool reused = false;
+    std::vector<std::string> subDirectoryNames;
+    std::vector<std::string> fileNames;
+    std::vector<std::string> fileNameInfos;
+    std::vector<std::unique_ptr<DirectoryNode>> children;
+  };
+
+  /// Reads a directory; called concurrently by the directory walker.
+public:
+  void ReadDirectoryNode(DirectoryNode& node);
+
+private:
+  void AddFileNames(const std::string& directory, std::vector<std::string>& names, const std::vector<std::string>& infos, std::vector<FILENAMEINFO>& fileNames);
+
+private:
+  void MergeDirectoryNode(DirectoryNode& node, std::vector<FILENAMEINFO>& fileNames);
+
+private:
+  void CollectFilesParallel(size_t numThreads, std::vector<FILENAMEINFO>& fileNames);
+
+private:
+  static size_t GetNumberOfScanThreads();
+
+private:
+  void BuildDatabase(const std::vector<FILENAMEINFO>& fileNames);
+
+private:
+  void* GetMemPointer()
+  {
+    return byteArray.data();
+  }
+
+private:
+  FndbByteOffset GetMemTop() const
+  {
+    return static_cast<FndbByteOffset>(byteArray.size());
+  }
+
+private:
+  void SetMem(FndbByteOffset fo, const void* data, size_t size)
+  {
+    MIKTEX_ASSERT(fo + size <= GetMemTop());
+    const uint8_t* begin = reinterpret_cast<const uint8_t*>(data);
+    const uint8_t* end = begin + size;
+    std::copy(begin, end, byteArray.begin() + fo);
+  }
+
+private:
+  void SetMem(FndbByteOffset fo, FndbByteOffset data)
+  {
+    SetMem(fo, &data, sizeof(data));
+  }
+
+private:
+  FndbByteOffset ReserveMem(size_t size);
+
+private:
+  void FastPushBack(uint8_t data)
+  {
+    byteArray.push_back(data);
+  }
+
+private:
+  FndbByteOffset PushBack(uint8_t data)
+  {
+    FndbByteOffset ret = GetMemTop();
+    FastPushBack(data);
+    return ret;
+  }
+
+private:
+  FndbByteOffset PushBack(FndbWord data);
+
+private:
+  FndbByteOffset PushBack(const void* data, size_t size);
+
+private:
+  FndbByteOffset PushBack(const char* data);
+
+private:
+  void AlignMem(size_t align = 8);
+
+private:
+  static FndbWord GetHashTableSize(size_t numFiles);
+
+private:
+  void WriteHashTable(FndbByteOffset foHashTable, FndbWord hashTableSize, const std::vector<FILENAMEINFO>& fileNames);
+
+private:
+  static void GetIgnorableFiles(const MiKTeX::Core::PathName& dirPath, std::vector<std::string>& filesToBeIgnored);
+
+private:
+  void ListDirectory(const MiKTeX::Core::PathName& dirPath, std::vector<std::string>& subDirectoryNames, std::vector<std::string>& fileNames, bool doCleanUp);
+
+public:
+  void ReadDirectory(const MiKTeX::Core::PathName& dirPath, std::vector<std::string>& subDirectoryNames, std::vector<FILENAMEINFO>& fileNames, bool doCleanUp);
+
+private:
+  void CollectFiles(const MiKTeX::Core::PathName& parentPath, const MiKTeX::Core::PathName& folderName, std::vector<FILENAMEINFO>& fileNames);
+
+private:
+  time_t GetDirectoryTimeStamp(const MiKTeX::Core::PathName& path) const;
+
+private:
+  bool TryReuseDirectory(const std::string& directory, time_t lastWriteTime, std::vector<std::string>& subDirectoryNames, std::vector<std::string>& fileNames, std::vector<std::string>& fileNameInfos) const;
+
+private:
+  bool LoadSnapshot(const MiKTeX::Core::PathName& fndbPath);
+
+private:
+  MiKTeX::Core::PathName rootPath;
+
+private:
+  std::vector<uint8_t> byteArray;
+
+private:
+  size_t deepestLevel = 0;
+
+private:
+  size_t currentLevel = 0;
+
+private:
+  size_t numDirectories = 0;
+
+private:
+  size_t numFiles = 0;
+
+private:
+  MiKTeX::Core::ICreateFndbCallback* callback = nullptr;
+
+private:
+  std::vector<FILENAMEINFO> records;
+
+private:
+  std::vector<DIRECTORYINFO> directoryInfos;
+
+private:
+  time_t scanStartTime = 0;
+
+private:
+  size_t numReusedDirectories = 0;
+
+private:
+  struct SnapshotDirectory
+  {
+    time_t lastWriteTime = 0;
+    std::vector<std::string> subDirectoryNames;
+    std::vector<std::string> fileNames;
+    std::vector<std::string> fileNameInfos;
+  };
+
+  /// Directory contents of the previous FNDB file, keyed by directory.
+private:
+  std::unordered_map<std::string, SnapshotDirectory> snapshot;
+
+private:
+  std::mutex callbackMutex;
+
+private:
+  std::unordered_set<std::string> stringPool;
+  
+private:
+  typedef std::unordered_map<std::string, FndbByteOffset> StringMap;
+
+private:
+  StringMap stringMap;
+
+private:
+  bool enableStringPooling = true;
+
+private:
+  bool storeFileNameInfo = false;
+
+private:
+  std::unique_ptr<MiKTeX::Trace::TraceStream> trace_fndb;
+
+private:
+  std::unique_ptr<MiKTeX::Trace::TraceStream> trace_error;
+};
+
+CORE_INTERNAL_END_NAMESPACE;
+
+#endif
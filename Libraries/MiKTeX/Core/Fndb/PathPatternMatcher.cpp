@@ -0,0 +1,160 @@
+/* PathPatternMatcher.cpp: compiled FNDB path patterns
+
+   Copyright (C) 2019 Christian Schenk
+
+   This file is part of the MiKTeX Core Library.
+
+   The MiKTeX Core Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+
+   The MiKTeX Core Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with the MiKTeX Core Library; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#include "config.h"
+
+#include <miktex/Core/PathName>
+
+#include "internal.h"
+
+#include "PathPatternMatcher.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+
+// the rest of a path pattern matches the end of a path
+MIKTEXSTATICFUNC(bool) IsEndOfPattern(const char* pathPattern)
+{
+  return *pathPattern == 0 || strcmp(pathPattern, RECURSION_INDICATOR) == 0 || strcmp(pathPattern, "/") == 0;
+}
+
+// FIXME: not UTF-8 safe
+MIKTEXSTATICFUNC(bool) MatchPattern(const char* pathPattern, const char* path)
+{
+  MIKTEX_ASSERT(PathName(pathPattern).IsComparable());
+  MIKTEX_ASSERT(PathName(path).IsComparable());
+  int lastch = 0;
+  for (; *pathPattern != 0 && *path != 0; ++pathPattern, ++path)
+  {
+    if (*pathPattern == *path)
+    {
+      lastch = *path;
+      continue;
+    }
+    MIKTEX_ASSERT(RECURSION_INDICATOR_LENGTH == 2);
+    MIKTEX_ASSERT(IsDirectoryDelimiter(RECURSION_INDICATOR[0]));
+    MIKTEX_ASSERT(IsDirectoryDelimiter(RECURSION_INDICATOR[1]));
+    if (*pathPattern == RECURSION_INDICATOR[1] && IsDirectoryDelimiter(lastch))
+    {
+      for (; IsDirectoryDelimiter(*pathPattern); ++pathPattern)
+      {
+      };
+      if (*pathPattern == 0)
+      {
+        return true;
+      }
+      for (; *path != 0; ++path)
+      {
+        if (IsDirectoryDelimiter(lastch))
+        {
+          // RECURSION
+          if (MatchPattern(pathPattern, path))
+          {
+            return true;
+          }
+        }
+        lastch = *path;
+      }
+    }
+    return false;
+  }
+  return IsEndOfPattern(pathPattern) && *path == 0;
+}
+
+PathPatternMatcher::PathPatternMatcher(const string& comparablePathPattern) :
+  pathPattern(comparablePathPattern)
+{
+  MIKTEX_ASSERT(PathName(pathPattern).IsComparable());
+  const char* p = pathPattern.c_str();
+  size_t end = pathPattern.length();
+  size_t start = 0;
+  while (true)
+  {
+    // a recursion indicator starts with the second of two delimiters
+    size_t idx = start + 1;
+    while (idx < end && !(IsDirectoryDelimiter(p[idx]) && IsDirectoryDelimiter(p[idx - 1])))
+    {
+      ++idx;
+    }
+    if (idx >= end)
+    {
+      segments.push_back({ start, end - start, false });
+      break;
+    }
+    segments.push_back({ start, idx - start, true });
+    for (; idx < end && IsDirectoryDelimiter(p[idx]); ++idx)
+    {
+    }
+    if (idx == end)
+    {
+      break;
+    }
+    start = idx;
+  }
+}
+
+bool PathPatternMatcher::Match(const char* comparablePath) const
+{
+  MIKTEX_ASSERT(PathName(comparablePath).IsComparable());
+  return Match(0, comparablePath);
+}
+
+bool PathPatternMatcher::Match(size_t segmentIdx, const char* path) const
+{
+  const Segment& segment = segments[segmentIdx];
+  const char* pattern = pathPattern.c_str() + segment.offset;
+  size_t len = 0;
+  while (len < segment.length && path[len] != 0 && pattern[len] == path[len])
+  {
+    ++len;
+  }
+  if (path[len] == 0)
+  {
+    return IsEndOfPattern(pattern + len);
+  }
+  if (len < segment.length || !segment.recursive)
+  {
+    return false;
+  }
+  if (pattern[len] == path[len])
+  {
+    // the path contains a recursion indicator
+    return MatchPattern(pattern, path);
+  }
+  if (segmentIdx + 1 == segments.size())
+  {
+    // trailing recursion indicator
+    return true;
+  }
+  for (const char* subPath = path + len; *subPath != 0; ++subPath)
+  {
+    if (subPath == path + len || IsDirectoryDelimiter(subPath[-1]))
+    {
+      // RECURSION
+      if (Match(segmentIdx + 1, subPath))
+      {
+        return true;
+      }
+    }
+  }
+  return false;
+}
@@ -0,0 +1,66 @@
+/* PathPatternMatcher.h: compiled FNDB path patterns        -*- C++ -*-
+
+   Copyright (C) 2019 Christian Schenk
+
+   This file is part of the MiKTeX Core Library.
+
+   The MiKTeX Core Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+
+   The MiKTeX Core Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with the MiKTeX Core Library; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#pragma once
+
+#if !defined(B94F82FD0F274F28BF1AB301E516E7E8)
+#define B94F82FD0F274F28BF1AB301E516E7E8
+
+#include <string>
+#include <vector>
+
+CORE_INTERNAL_BEGIN_NAMESPACE;
+
+/// Matches comparable directory paths against a path pattern.
+///
+/// The pattern is split once into literal segments separated by
+/// recursion indicators (`//`), so that a directory can be matched
+/// without copying or transforming the pattern.
+class PathPatternMatcher
+{
+public:
+  explicit PathPatternMatcher(const std::string& comparablePathPattern);
+
+public:
+  bool Match(const char* comparablePath) const;
+
+private:
+  bool Match(size_t segmentIdx, const char* path) const;
+
+private:
+  struct Segment
+  {
+    size_t offset;
+    size_t length;
+    // the segment is followed by a recursion indicator
+    bool recursive;
+  };
+
+private:
+  std::string pathPattern;
+
+private:
+  std::vector<Segment> segments;
+};
+
+CORE_INTERNAL_END_NAMESPACE;
+
+#endif
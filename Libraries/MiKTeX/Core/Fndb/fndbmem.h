@@ -62,7 +62,19 @@ struct FileNameDatabaseHeader
 
   // size (in bytes) of fndb; includes header size
   FndbWord size;
-  
+
+  // pointer to the file name hash table
+  FndbByteOffset foHashTable;
+
+  // number of hash table slots (a power of two)
+  FndbWord hashTableSize;
+
+  // pointer to the directory table
+  FndbByteOffset foDirectoryTable;
+
+  // number of directory records
+  FndbWord numDirectoryRecords;
+
   FndbWord reserved;
 
   void Init()
@@ -72,6 +84,11 @@ struct FileNameDatabaseHeader
     version = Version;
     flags = 0;
     size = sizeof(*this);
+    foHashTable = 0;
+    hashTableSize = 0;
+    foDirectoryTable = 0;
+    numDirectoryRecords = 0;
+    reserved = 0;
   }
 };
 
@@ -80,9 +97,43 @@ struct FileNameDatabaseRecord
   FndbByteOffset foFileName;
   FndbByteOffset foDirectory;
   FndbByteOffset foInfo;
-  FndbByteOffset reserved = 0;
+  // directory transformed for comparison; equals foDirectory if the
+  // directory is already comparable
+  FndbByteOffset foComparableDirectory;
+};
+
+// the directory table lists all scanned directories in pre-order; the
+// last write time is used to skip unchanged directories when the FNDB
+// is updated; a zero time stamp forces a rescan
+struct FileNameDatabaseDirectoryRecord
+{
+  FndbByteOffset foDirectory;
+  FndbWord reserved = 0;
+  int64_t lastWriteTime;
 };
 
+// a hash table slot holds the one-based index of a record; zero marks
+// an empty slot
+typedef FndbWord FndbHashTableSlot;
+
+// FNV-1a hash of a file name; ASCII letters are folded to lower case
+// so that the hash table can be probed case-insensitively
+inline FndbWord FndbHash(const char* fileName)
+{
+  FndbWord h = 2166136261u;
+  for (; *fileName != 0; ++fileName)
+  {
+    uint8_t ch = static_cast<uint8_t>(*fileName);
+    if (ch >= 'A' && ch <= 'Z')
+    {
+      ch = ch - 'A' + 'a';
+    }
+    h ^= ch;
+    h *= 16777619u;
+  }
+  return h;
+}
+
 CORE_INTERNAL_END_NAMESPACE;
 
 #endif
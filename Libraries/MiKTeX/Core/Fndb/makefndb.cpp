@@ -21,7 +21,14 @@
 
 #include "config.h"
 
+#include <algorithm>
+#include <ctime>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
 #include <fstream>
+#include <mutex>
 #include <thread>
 #include <unordered_map>
 #include <unordered_set>
@@ -30,6 +37,7 @@
 #include <fmt/ostream.h>
 
 #include <miktex/Core/AutoResource>
+#include <miktex/Core/ConfigNames>
 #include <miktex/Core/Directory>
 #include <miktex/Core/FileStream>
 #include <miktex/Core/Paths>
@@ -40,7 +48,7 @@
 #include "internal.h"
 
 #include "Session/SessionImpl.h"
-#include "fndbmem.h"
+#include "FndbManager.h"
 
 using namespace std;
 
@@ -51,133 +59,6 @@ const uint8_t null_byte = 0;
 
 #define FN_MIKTEXIGNORE ".miktexignore"
 
-struct FILENAMEINFO
-{
-  string FileName;
-  const string* Directory = nullptr;
-  const string* Info = nullptr;
-};
-
-class FndbManager
-{
-public:
-  FndbManager() :
-    trace_fndb(TraceStream::Open(MIKTEX_TRACE_FNDB)),
-    trace_error(TraceStream::Open(MIKTEX_TRACE_ERROR))
-  {
-  }
-
-public:
-  bool Create(const PathName& fndbPath, const PathName& rootPath, ICreateFndbCallback* callback, bool enableStringPooling, bool storeFileNameInfo);
-
-private:
-  void* GetMemPointer()
-  {
-    return byteArray.data();
-  }
-
-private:
-  FndbByteOffset GetMemTop() const
-  {
-    return static_cast<FndbByteOffset>(byteArray.size());
-  }
-
-private:
-  void SetMem(FndbByteOffset fo, const void* data, size_t size)
-  {
-    MIKTEX_ASSERT(fo + size <= GetMemTop());
-    const uint8_t* begin = reinterpret_cast<const uint8_t*>(data);
-    const uint8_t* end = begin + size;
-    std::copy(begin, end, byteArray.begin() + fo);
-  }
-
-private:
-  void SetMem(FndbByteOffset fo, FndbByteOffset data)
-  {
-    SetMem(fo, &data, sizeof(data));
-  }
-
-private:
-  FndbByteOffset ReserveMem(size_t size);
-
-private:
-  void FastPushBack(uint8_t data)
-  {
-    byteArray.push_back(data);
-  }
-
-private:
-  FndbByteOffset PushBack(uint8_t data)
-  {
-    FndbByteOffset ret = GetMemTop();
-    FastPushBack(data);
-    return ret;
-  }
-
-private:
-  FndbByteOffset PushBack(FndbWord data);
-
-private:
-  FndbByteOffset PushBack(const void* data, size_t size);
-
-private:
-  FndbByteOffset PushBack(const char* data);
-
-private:
-  void AlignMem(size_t align = 8);
-
-private:
-  static void GetIgnorableFiles(const PathName& dirPath, vector<string>& filesToBeIgnored);
-
-public:
-  void ReadDirectory(const PathName& dirPath, vector<string>& subDirectoryNames, vector<FILENAMEINFO>& fileNames, bool doCleanUp);
-
-private:
-  void CollectFiles(const PathName& parentPath, const PathName& folderName, vector<FILENAMEINFO>& fileNames);
-
-private:
-  PathName rootPath;
-
-private:
-  vector<uint8_t> byteArray;
-
-private:
-  size_t deepestLevel;
-
-private:
-  size_t currentLevel;
-
-private:
-  size_t numDirectories;
-
-private:
-  size_t numFiles;
-
-private:
-  ICreateFndbCallback* callback;
-
-private:
-  unordered_set<string> stringPool;
-  
-private:
-  typedef unordered_map<string, FndbByteOffset> StringMap;
-
-private:
-  StringMap stringMap;
-
-private:
-  bool enableStringPooling;
-
-private:
-  bool storeFileNameInfo;
-
-private:
-  unique_ptr<TraceStream> trace_fndb;
-
-private:
-  unique_ptr<TraceStream> trace_error;
-};
-
 FndbByteOffset FndbManager::ReserveMem(size_t size)
 {
   FndbByteOffset ret = GetMemTop();
@@ -249,6 +130,33 @@ void FndbManager::AlignMem(size_t align)
   }
 }
 
+FndbWord FndbManager::GetHashTableSize(size_t numFiles)
+{
+  // keep the load factor at or below 0.5
+  FndbWord size = 16;
+  while (size < 2 * numFiles)
+  {
+    size *= 2;
+  }
+  return size;
+}
+
+void FndbManager::WriteHashTable(FndbByteOffset foHashTable, FndbWord hashTableSize, const vector<FILENAMEINFO>& fileNames)
+{
+  MIKTEX_ASSERT((hashTableSize & (hashTableSize - 1)) == 0);
+  FndbHashTableSlot* slots = reinterpret_cast<FndbHashTableSlot*>(reinterpret_cast<uint8_t*>(GetMemPointer()) + foHashTable);
+  for (size_t idx = 0; idx < fileNames.size(); ++idx)
+  {
+    // linear probing
+    FndbWord slot = FndbHash(fileNames[idx].FileName.c_str()) & (hashTableSize - 1);
+    while (slots[slot] != 0)
+    {
+      slot = (slot + 1) & (hashTableSize - 1);
+    }
+    slots[slot] = static_cast<FndbHashTableSlot>(idx + 1);
+  }
+}
+
 void FndbManager::GetIgnorableFiles(const PathName& dirPath, vector<string>& filesToBeIgnored)
 {
   PathName ignoreFile(dirPath, FN_MIKTEXIGNORE);
@@ -265,7 +173,7 @@ void FndbManager::GetIgnorableFiles(const PathName& dirPath, vector<string>& fil
   sort(filesToBeIgnored.begin(), filesToBeIgnored.end(), StringComparerIgnoringCase());
 }
 
-void FndbManager::ReadDirectory(const PathName& dirPath, vector<string>& subDirectoryNames, vector<FILENAMEINFO>& fileNames, bool doCleanUp)
+void FndbManager::ListDirectory(const PathName& dirPath, vector<string>& subDirectoryNames, vector<string>& fileNames, bool doCleanUp)
 {
   if (!Directory::Exists(dirPath))
   {
@@ -277,8 +185,6 @@ void FndbManager::ReadDirectory(const PathName& dirPath, vector<string>& subDire
   unique_ptr<DirectoryLister> lister = DirectoryLister::Open(dirPath);
   DirectoryEntry entry;
   vector<DirectoryEntry> toBeDeleted;
-  PathName directory = Utils::GetRelativizedPath(dirPath.GetData(), rootPath.GetData());
-  directory = directory.ToUnix();
   while (lister->GetNext(entry))
   {
     if (binary_search(filesToBeIgnored.begin(), filesToBeIgnored.end(), entry.name, StringComparerIgnoringCase()))
@@ -295,10 +201,7 @@ void FndbManager::ReadDirectory(const PathName& dirPath, vector<string>& subDire
     }
     else
     {
-      FILENAMEINFO filenameinfo;
-      filenameinfo.FileName = entry.name;
-      filenameinfo.Directory = &*stringPool.insert(directory.ToString()).first;
-      fileNames.push_back(filenameinfo);
+      fileNames.push_back(entry.name);
     }
   }
   lister->Close();
@@ -324,6 +227,26 @@ void FndbManager::ReadDirectory(const PathName& dirPath, vector<string>& subDire
   }
 }
 
+void FndbManager::ReadDirectory(const PathName& dirPath, vector<string>& subDirectoryNames, vector<FILENAMEINFO>& fileNames, bool doCleanUp)
+{
+  vector<string> names;
+  ListDirectory(dirPath, subDirectoryNames, names, doCleanUp);
+  if (names.empty())
+  {
+    return;
+  }
+  PathName directory = Utils::GetRelativizedPath(dirPath.GetData(), rootPath.GetData());
+  directory = directory.ToUnix();
+  const string* pooledDirectory = &*stringPool.insert(directory.ToString()).first;
+  for (string& name : names)
+  {
+    FILENAMEINFO filenameinfo;
+    filenameinfo.FileName = std::move(name);
+    filenameinfo.Directory = pooledDirectory;
+    fileNames.push_back(std::move(filenameinfo));
+  }
+}
+
 void FndbManager::CollectFiles(const PathName& parentPath, const PathName& folderName, vector<FILENAMEINFO>& fileNames)
 {
   if (currentLevel > deepestLevel)
@@ -342,6 +265,8 @@ void FndbManager::CollectFiles(const PathName& parentPath, const PathName& folde
   PathName directory = Utils::GetRelativizedPath(path.GetData(), rootPath.GetData());
   directory = directory.ToUnix();
 
+  time_t lastWriteTime = 0;
+
   if (callback != nullptr)
   {
     if (!callback->OnProgress(static_cast<unsigned>(currentLevel), path))
@@ -356,14 +281,20 @@ void FndbManager::CollectFiles(const PathName& parentPath, const PathName& folde
     {
       subDirectoryNames = subDirs;
       MIKTEX_ASSERT(files.size() == infos.size());
-      for (int i = 0; i < files.size(); ++i)
-      {
-        FILENAMEINFO filenameinfo;
-        filenameinfo.FileName = files[i];
-        filenameinfo.Directory = &*stringPool.insert(directory.ToString()).first;
-        filenameinfo.Info = &*stringPool.insert(infos[i]).first;
-        fileNames.push_back(filenameinfo);
-      }
+      AddFileNames(directory.ToString(), files, infos, fileNames);
+    }
+  }
+
+  if (!done)
+  {
+    lastWriteTime = GetDirectoryTimeStamp(path);
+    vector<string> files;
+    vector<string> infos;
+    done = TryReuseDirectory(directory.ToString(), lastWriteTime, subDirectoryNames, files, infos);
+    if (done)
+    {
+      numReusedDirectories++;
+      AddFileNames(directory.ToString(), files, infos, fileNames);
     }
   }
 
@@ -372,6 +303,11 @@ void FndbManager::CollectFiles(const PathName& parentPath, const PathName& folde
     ReadDirectory(path, subDirectoryNames, fileNames, true);
   }
 
+  DIRECTORYINFO directoryinfo;
+  directoryinfo.Directory = &*stringPool.insert(directory.ToString()).first;
+  directoryinfo.LastWriteTime = lastWriteTime;
+  directoryInfos.push_back(directoryinfo);
+
   numDirectories += subDirectoryNames.size();
 
   // recurse into sub-directories
@@ -387,6 +323,407 @@ void FndbManager::CollectFiles(const PathName& parentPath, const PathName& folde
   --currentLevel;
 }
 
+void FndbManager::ReadDirectoryNode(DirectoryNode& node)
+{
+  PathName path(node.parentPath, node.folderName);
+  path.MakeAbsolute();
+
+  PathName directory = Utils::GetRelativizedPath(path.GetData(), rootPath.GetData());
+  node.directory = directory.ToUnix().ToString();
+
+  bool done = false;
+
+  if (callback != nullptr)
+  {
+    // the callback is not required to be thread-safe
+    lock_guard<mutex> lockGuard(callbackMutex);
+    if (!callback->OnProgress(static_cast<unsigned>(node.level), path))
+    {
+      throw OperationCancelledException();
+    }
+    vector<string> subDirs;
+    vector<string> files;
+    vector<string> infos;
+    done = callback->ReadDirectory(path, subDirs, files, infos);
+    if (done)
+    {
+      MIKTEX_ASSERT(files.size() == infos.size());
+      node.subDirectoryNames = std::move(subDirs);
+      node.fileNames = std::move(files);
+      node.fileNameInfos = std::move(infos);
+    }
+  }
+
+  if (!done)
+  {
+    node.lastWriteTime = GetDirectoryTimeStamp(path);
+    done = TryReuseDirectory(node.directory, node.lastWriteTime, node.subDirectoryNames, node.fileNames, node.fileNameInfos);
+    node.reused = done;
+  }
+
+  if (!done)
+  {
+    node.subDirectoryNames.reserve(40);
+    ListDirectory(path, node.subDirectoryNames, node.fileNames, true);
+  }
+
+  PathName pathFolder(node.parentPath, node.folderName);
+  node.children.reserve(node.subDirectoryNames.size());
+  for (const string& s : node.subDirectoryNames)
+  {
+    unique_ptr<DirectoryNode> child = make_unique<DirectoryNode>();
+    child->parentPath = pathFolder;
+    child->folderName = s;
+    child->level = node.level + 1;
+    node.children.push_back(std::move(child));
+  }
+}
+
+void FndbManager::AddFileNames(const string& directory, vector<string>& names, const vector<string>& infos, vector<FILENAMEINFO>& fileNames)
+{
+  if (names.empty())
+  {
+    return;
+  }
+  const string* pooledDirectory = &*stringPool.insert(directory).first;
+  for (size_t i = 0; i < names.size(); ++i)
+  {
+    FILENAMEINFO filenameinfo;
+    filenameinfo.FileName = std::move(names[i]);
+    filenameinfo.Directory = pooledDirectory;
+    if (i < infos.size() && !infos[i].empty())
+    {
+      filenameinfo.Info = &*stringPool.insert(infos[i]).first;
+    }
+    fileNames.push_back(std::move(filenameinfo));
+  }
+}
+
+void FndbManager::MergeDirectoryNode(DirectoryNode& node, vector<FILENAMEINFO>& fileNames)
+{
+  if (node.level > deepestLevel)
+  {
+    deepestLevel = node.level;
+  }
+  AddFileNames(node.directory, node.fileNames, node.fileNameInfos, fileNames);
+  DIRECTORYINFO directoryinfo;
+  directoryinfo.Directory = &*stringPool.insert(node.directory).first;
+  directoryinfo.LastWriteTime = node.lastWriteTime;
+  directoryInfos.push_back(directoryinfo);
+  if (node.reused)
+  {
+    numReusedDirectories++;
+  }
+  numDirectories += node.subDirectoryNames.size();
+  for (unique_ptr<DirectoryNode>& child : node.children)
+  {
+    // RECURSION
+    MergeDirectoryNode(*child, fileNames);
+    child = nullptr;
+  }
+}
+
+// Each worker owns a deque of directories to be read: it pushes and
+// pops at the back and, when its own deque is empty, steals from the
+// front of the other deques.  Directory contents are kept in a tree
+// which is merged depth-first, so the result does not depend on the
+// order in which directories have been read.
+class DirectoryWalker
+{
+public:
+  DirectoryWalker(FndbManager& fndbManager, size_t numThreads) :
+    fndbManager(fndbManager),
+    queues(numThreads)
+  {
+  }
+
+public:
+  void Run(FndbManager::DirectoryNode* root)
+  {
+    Push(0, root);
+    vector<thread> threads;
+    for (size_t idx = 1; idx < queues.size(); ++idx)
+    {
+      threads.push_back(thread(&DirectoryWalker::Work, this, idx));
+    }
+    Work(0);
+    for (thread& t : threads)
+    {
+      t.join();
+    }
+    if (error)
+    {
+      rethrow_exception(error);
+    }
+  }
+
+private:
+  struct Queue
+  {
+    mutex queueMutex;
+    deque<FndbManager::DirectoryNode*> nodes;
+  };
+
+private:
+  void Push(size_t worker, FndbManager::DirectoryNode* node)
+  {
+    pendingNodes++;
+    queuedNodes++;
+    {
+      lock_guard<mutex> lockGuard(queues[worker].queueMutex);
+      queues[worker].nodes.push_back(node);
+    }
+    Notify(false);
+  }
+
+  // wakes up idle workers; the wait mutex is taken so that a worker
+  // cannot miss the notification between checking and waiting
+private:
+  void Notify(bool all)
+  {
+    {
+      lock_guard<mutex> lockGuard(waitMutex);
+    }
+    if (all)
+    {
+      workAvailable.notify_all();
+    }
+    else
+    {
+      workAvailable.notify_one();
+    }
+  }
+
+private:
+  FndbManager::DirectoryNode* Pop(size_t worker)
+  {
+    {
+      Queue& own = queues[worker];
+      lock_guard<mutex> lockGuard(own.queueMutex);
+      if (!own.nodes.empty())
+      {
+        FndbManager::DirectoryNode* node = own.nodes.back();
+        own.nodes.pop_back();
+        queuedNodes--;
+        return node;
+      }
+    }
+    for (size_t i = 1; i < queues.size(); ++i)
+    {
+      Queue& victim = queues[(worker + i) % queues.size()];
+      lock_guard<mutex> lockGuard(victim.queueMutex);
+      if (!victim.nodes.empty())
+      {
+        FndbManager::DirectoryNode* node = victim.nodes.front();
+        victim.nodes.pop_front();
+        queuedNodes--;
+        return node;
+      }
+    }
+    return nullptr;
+  }
+
+private:
+  void Work(size_t worker)
+  {
+    while (pendingNodes > 0 && !failed)
+    {
+      FndbManager::DirectoryNode* node = Pop(worker);
+      if (node == nullptr)
+      {
+        // sleep until a node is pushed or the walk is over
+        unique_lock<mutex> lock(waitMutex);
+        workAvailable.wait(lock, [this]() { return queuedNodes > 0 || pendingNodes == 0 || failed; });
+        continue;
+      }
+      try
+      {
+        fndbManager.ReadDirectoryNode(*node);
+        // children are pushed before the node is retired, so that
+        // pendingNodes cannot drop to zero prematurely
+        for (unique_ptr<FndbManager::DirectoryNode>& child : node->children)
+        {
+          Push(worker, child.get());
+        }
+      }
+      catch (...)
+      {
+        lock_guard<mutex> lockGuard(errorMutex);
+        if (!error)
+        {
+          error = current_exception();
+        }
+        failed = true;
+        Notify(true);
+      }
+      if (--pendingNodes == 0)
+      {
+        Notify(true);
+      }
+    }
+  }
+
+private:
+  FndbManager& fndbManager;
+
+private:
+  vector<Queue> queues;
+
+  // nodes pushed but not yet processed
+private:
+  atomic_size_t pendingNodes{ 0 };
+
+  // nodes waiting in the queues
+private:
+  atomic_size_t queuedNodes{ 0 };
+
+private:
+  atomic_bool failed{ false };
+
+private:
+  mutex waitMutex;
+
+private:
+  condition_variable workAvailable;
+
+private:
+  mutex errorMutex;
+
+private:
+  exception_ptr error;
+};
+
+void FndbManager::CollectFilesParallel(size_t numThreads, vector<FILENAMEINFO>& fileNames)
+{
+  DirectoryNode root;
+  root.parentPath = rootPath;
+  root.folderName = CURRENT_DIRECTORY;
+  DirectoryWalker walker(*this, numThreads);
+  walker.Run(&root);
+  MergeDirectoryNode(root, fileNames);
+}
+
+void FndbManager::BuildDatabase(const vector<FILENAMEINFO>& fileNames)
+{
+  byteArray.clear();
+  stringMap.clear();
+  ReserveMem(sizeof(FileNameDatabaseHeader));
+  FileNameDatabaseHeader fndb;
+  fndb.Init();
+  numFiles = fileNames.size();
+  AlignMem();
+  fndb.foTable = ReserveMem(fileNames.size() * sizeof(FileNameDatabaseRecord));
+  AlignMem();
+  fndb.foStrings = GetMemTop();
+  unordered_map<const string*, FndbByteOffset> comparableDirectories;
+  for (size_t idx = 0; idx < fileNames.size(); ++idx)
+  {
+    FileNameDatabaseRecord rec;
+    rec.foFileName = PushBack(fileNames[idx].FileName.c_str());
+    rec.foDirectory = PushBack(fileNames[idx].Directory->c_str());
+    rec.foInfo = PushBack(fileNames[idx].Info == nullptr ? "" : fileNames[idx].Info->c_str());
+    auto it = comparableDirectories.find(fileNames[idx].Directory);
+    if (it == comparableDirectories.end())
+    {
+      PathName comparableDirectory(*fileNames[idx].Directory);
+      it = comparableDirectories.insert({ fileNames[idx].Directory, comparableDirectory.IsComparable() ? rec.foDirectory : PushBack(comparableDirectory.TransformForComparison().GetData()) }).first;
+    }
+    rec.foComparableDirectory = it->second;
+    SetMem(static_cast<unsigned>(fndb.foTable + idx * sizeof(rec)), &rec, sizeof(rec));
+  }
+  AlignMem();
+  fndb.hashTableSize = GetHashTableSize(fileNames.size());
+  fndb.foHashTable = ReserveMem(fndb.hashTableSize * sizeof(FndbHashTableSlot));
+  WriteHashTable(fndb.foHashTable, fndb.hashTableSize, fileNames);
+  AlignMem();
+  fndb.numDirectoryRecords = static_cast<FndbWord>(directoryInfos.size());
+  fndb.foDirectoryTable = ReserveMem(directoryInfos.size() * sizeof(FileNameDatabaseDirectoryRecord));
+  for (size_t idx = 0; idx < directoryInfos.size(); ++idx)
+  {
+    FileNameDatabaseDirectoryRecord rec;
+    rec.foDirectory = PushBack(directoryInfos[idx].Directory->c_str());
+    rec.lastWriteTime = directoryInfos[idx].LastWriteTime;
+    SetMem(static_cast<unsigned>(fndb.foDirectoryTable + idx * sizeof(rec)), &rec, sizeof(rec));
+  }
+  fndb.numDirs = static_cast<unsigned>(numDirectories);
+  fndb.numFiles = static_cast<unsigned>(numFiles);
+  fndb.depth = static_cast<unsigned>(deepestLevel);
+  fndb.size = GetMemTop();
+  AlignMem(FNDB_PAGESIZE);
+  SetMem(0, &fndb, sizeof(fndb));
+}
+
+void FndbManager::AddRecord(const string& fileName, const string& directory, const string& info)
+{
+  FILENAMEINFO filenameinfo;
+  filenameinfo.FileName = fileName;
+  auto p = stringPool.insert(directory);
+  filenameinfo.Directory = &*p.first;
+  if (p.second)
+  {
+    numDirectories++;
+    size_t level = directory.empty() || directory == CURRENT_DIRECTORY ? 0 : std::count(directory.begin(), directory.end(), PathName::UnixDirectoryDelimiter) + 1;
+    if (level > deepestLevel)
+    {
+      deepestLevel = level;
+    }
+  }
+  if (!info.empty())
+  {
+    filenameinfo.Info = &*stringPool.insert(info).first;
+  }
+  records.push_back(filenameinfo);
+}
+
+void FndbManager::AddDirectoryRecord(const string& directory, time_t lastWriteTime)
+{
+  DIRECTORYINFO directoryinfo;
+  directoryinfo.Directory = &*stringPool.insert(directory).first;
+  directoryinfo.LastWriteTime = lastWriteTime;
+  directoryInfos.push_back(directoryinfo);
+}
+
+PathName FndbManager::WriteCompacted(const PathName& fndbPath)
+{
+  trace_fndb->WriteLine("core", fmt::format(T_("compacting fndb file {0}..."), Q_(fndbPath)));
+  enableStringPooling = true;
+  BuildDatabase(records);
+  // the new file is moved into place, so that readers keep their
+  // mapping of the old file; the name is unique, because several
+  // processes might compact at the same time
+  PathName newFndbPath;
+  newFndbPath.SetToTempFile(fndbPath.GetDirectoryName());
+  try
+  {
+    FileStream streamFndb(File::Open(newFndbPath, FileMode::Create, FileAccess::Write, false));
+    streamFndb.Write(reinterpret_cast<const char*>(GetMemPointer()), GetMemTop());
+    // the caller truncates the change file: the new file must be on
+    // disk before it replaces the old one
+    File::Sync(streamFndb.GetFile());
+    streamFndb.Close();
+  }
+  catch (const MiKTeXException&)
+  {
+    if (File::Exists(newFndbPath))
+    {
+      File::Delete(newFndbPath);
+    }
+    throw;
+  }
+  return newFndbPath;
+}
+
+size_t FndbManager::GetNumberOfScanThreads()
+{
+  int numThreads = SessionImpl::GetSession()->GetConfigValue(MIKTEX_CONFIG_SECTION_CORE, MIKTEX_CONFIG_VALUE_FNDBSCANTHREADS, 0).GetInt();
+  if (numThreads <= 0)
+  {
+    // directory reading is mostly I/O bound
+    numThreads = std::max(4u, thread::hardware_concurrency());
+  }
+  return static_cast<size_t>(numThreads);
+}
+
 bool FndbManager::Create(const PathName& fndbPath, const PathName& rootPath, ICreateFndbCallback* callback, bool enableStringPooling, bool storeFileNameInfo)
 {
   trace_fndb->WriteLine("core", fmt::format(T_("creating fndb file {0}..."), Q_(fndbPath)));
@@ -397,35 +734,30 @@ bool FndbManager::Create(const PathName& fndbPath, const PathName& rootPath, ICr
   byteArray.reserve(2 * 1024 * 1024);
   try
   {
-    ReserveMem(sizeof(FileNameDatabaseHeader));
-    FileNameDatabaseHeader fndb;
-    fndb.Init();
     numDirectories = 0;
     numFiles = 0;
     deepestLevel = 0;
     currentLevel = 0;
+    numReusedDirectories = 0;
+    directoryInfos.clear();
+    scanStartTime = time(nullptr);
     this->callback = callback;
     vector<FILENAMEINFO> fileNames;
-    CollectFiles(rootPath, CURRENT_DIRECTORY, fileNames);
-    numFiles = fileNames.size();
-    AlignMem();
-    fndb.foTable = ReserveMem(fileNames.size() * sizeof(FileNameDatabaseRecord));
-    AlignMem();
-    fndb.foStrings = GetMemTop();
-    for (size_t idx = 0; idx < fileNames.size(); ++idx)
-    {
-      FileNameDatabaseRecord rec;
-      rec.foFileName = PushBack(fileNames[idx].FileName.c_str());
-      rec.foDirectory = PushBack(fileNames[idx].Directory->c_str());
-      rec.foInfo = PushBack(fileNames[idx].Info == nullptr ? "" : fileNames[idx].Info->c_str());
-      SetMem(static_cast<unsigned>(fndb.foTable + idx * sizeof(rec)), &rec, sizeof(rec));
-    }
-    fndb.numDirs = static_cast<unsigned>(numDirectories);
-    fndb.numFiles = static_cast<unsigned>(numFiles);
-    fndb.depth = static_cast<unsigned>(deepestLevel);
-    fndb.size = GetMemTop();
-    AlignMem(FNDB_PAGESIZE);
-    SetMem(0, &fndb, sizeof(fndb));
+    size_t numThreads = GetNumberOfScanThreads();
+    if (numThreads > 1)
+    {
+      trace_fndb->WriteLine("core", fmt::format(T_("scanning {0} with {1} threads"), Q_(rootPath), numThreads));
+      CollectFilesParallel(numThreads, fileNames);
+    }
+    else
+    {
+      CollectFiles(rootPath, CURRENT_DIRECTORY, fileNames);
+    }
+    if (!snapshot.empty())
+    {
+      trace_fndb->WriteLine("core", fmt::format(T_("reused {0} of {1} directories"), numReusedDirectories, directoryInfos.size()));
+    }
+    BuildDatabase(fileNames);
 
     // <fixme>
     bool unloaded = false;
@@ -443,7 +775,16 @@ bool FndbManager::Create(const PathName& fndbPath, const PathName& rootPath, ICr
       MIKTEX_FATAL_ERROR(T_("fndb cannot be unloaded"));
     }
     // </fixme>
-    
+
+    // serialize with writers and compactions of the change file
+    PathName changeFile = fndbPath;
+    changeFile.SetExtension(MIKTEX_FNDB_CHANGE_FILE_SUFFIX);
+    FileStream changeFileStream(File::Open(changeFile, FileMode::Append, FileAccess::ReadWrite, false));
+    if (!File::TryLock(changeFileStream.GetFile(), File::LockType::Exclusive, 10s))
+    {
+      MIKTEX_FATAL_ERROR_2(T_("Could not acquire exclusive lock."), "path", changeFile.ToString());
+    }
+
     FileStream streamFndb;
 #if defined(MIKTEX_WINDOWS)
     chrono::time_point<chrono::high_resolution_clock> tryUntil = chrono::high_resolution_clock::now() + chrono::seconds(10);
@@ -470,16 +811,17 @@ bool FndbManager::Create(const PathName& fndbPath, const PathName& rootPath, ICr
       MIKTEX_FATAL_ERROR_2(T_("Could not acquire exclusive lock."), "path", fndbPath.ToString());
     }
     streamFndb.Write(reinterpret_cast<const char*>(GetMemPointer()), GetMemTop());
-    PathName changeFile = fndbPath;
-    changeFile.SetExtension(MIKTEX_FNDB_CHANGE_FILE_SUFFIX);
-    if (File::Exists(changeFile))
-    {
-      File::Delete(changeFile);
-    }
+    // the change file has been superseded: empty it under its lock;
+    // a compaction that was started before cannot replace the new
+    // file, because it finds the change file modified
+    File::SetSize(changeFileStream.GetFile(), 0);
+    File::Unlock(changeFileStream.GetFile());
+    changeFileStream.Close();
     File::Unlock(streamFndb.GetFile());
     streamFndb.Close();
     trace_fndb->WriteLine("core", T_("fndb creation completed"));
     SessionImpl::GetSession()->RecordMaintenance();
+    SessionImpl::GetSession()->InvalidateFindFileCache();
     return true;
   }
   catch (const OperationCancelledException&)
@@ -489,6 +831,129 @@ bool FndbManager::Create(const PathName& fndbPath, const PathName& rootPath, ICr
   }
 }
 
+time_t FndbManager::GetDirectoryTimeStamp(const PathName& path) const
+{
+  try
+  {
+    if (File::Exists(PathName(path, FN_MIKTEXIGNORE)))
+    {
+      // editing the ignore file does not touch the directory
+      return 0;
+    }
+    time_t lastWriteTime = File::GetLastWriteTime(path);
+    // the directory might change again within the time stamp resolution
+    return lastWriteTime < scanStartTime ? lastWriteTime : 0;
+  }
+  catch (const MiKTeXException&)
+  {
+    return 0;
+  }
+}
+
+bool FndbManager::TryReuseDirectory(const string& directory, time_t lastWriteTime, vector<string>& subDirectoryNames, vector<string>& fileNames, vector<string>& fileNameInfos) const
+{
+  if (lastWriteTime == 0)
+  {
+    return false;
+  }
+  auto it = snapshot.find(directory);
+  if (it == snapshot.end() || it->second.lastWriteTime != lastWriteTime)
+  {
+    return false;
+  }
+  subDirectoryNames = it->second.subDirectoryNames;
+  fileNames = it->second.fileNames;
+  fileNameInfos = it->second.fileNameInfos;
+  return true;
+}
+
+bool FndbManager::LoadSnapshot(const PathName& fndbPath)
+{
+  snapshot.clear();
+  if (!File::Exists(fndbPath))
+  {
+    return false;
+  }
+  vector<unsigned char> bytes = File::ReadAllBytes(fndbPath);
+  if (bytes.size() < sizeof(FileNameDatabaseHeader))
+  {
+    return false;
+  }
+  const FileNameDatabaseHeader* fndb = reinterpret_cast<const FileNameDatabaseHeader*>(bytes.data());
+  if (fndb->signature != FileNameDatabaseHeader::Signature
+    || fndb->version != FileNameDatabaseHeader::Version
+    || fndb->size > bytes.size()
+    || fndb->numDirectoryRecords == 0
+    || fndb->foDirectoryTable + static_cast<size_t>(fndb->numDirectoryRecords) * sizeof(FileNameDatabaseDirectoryRecord) > fndb->size
+    || fndb->foTable + static_cast<size_t>(fndb->numFiles) * sizeof(FileNameDatabaseRecord) > fndb->size)
+  {
+    trace_fndb->WriteLine("core", fmt::format(T_("{0} cannot be used for an incremental update"), Q_(fndbPath)));
+    return false;
+  }
+  auto getString = [&bytes, fndb](FndbByteOffset fo) -> const char*
+  {
+    return fo < fndb->size ? reinterpret_cast<const char*>(bytes.data() + fo) : nullptr;
+  };
+  const FileNameDatabaseDirectoryRecord* directoryTable = reinterpret_cast<const FileNameDatabaseDirectoryRecord*>(bytes.data() + fndb->foDirectoryTable);
+  // the directory table is in pre-order: the first entry is the root
+  // directory and the sub-directories of a directory appear in
+  // directory listing order
+  string rootDirectory;
+  for (FndbWord idx = 0; idx < fndb->numDirectoryRecords; ++idx)
+  {
+    const char* directory = getString(directoryTable[idx].foDirectory);
+    if (directory == nullptr)
+    {
+      snapshot.clear();
+      return false;
+    }
+    snapshot[directory].lastWriteTime = static_cast<time_t>(directoryTable[idx].lastWriteTime);
+    if (idx == 0)
+    {
+      rootDirectory = directory;
+      continue;
+    }
+    const char* lastSlash = strrchr(directory, PathName::UnixDirectoryDelimiter);
+    string parent = lastSlash == nullptr ? rootDirectory : string(directory, lastSlash - directory);
+    snapshot[parent].subDirectoryNames.push_back(lastSlash == nullptr ? directory : lastSlash + 1);
+  }
+  const FileNameDatabaseRecord* table = reinterpret_cast<const FileNameDatabaseRecord*>(bytes.data() + fndb->foTable);
+  for (FndbWord idx = 0; idx < fndb->numFiles; ++idx)
+  {
+    const char* fileName = getString(table[idx].foFileName);
+    const char* directory = getString(table[idx].foDirectory);
+    const char* info = getString(table[idx].foInfo);
+    if (fileName == nullptr || directory == nullptr || info == nullptr)
+    {
+      snapshot.clear();
+      return false;
+    }
+    auto it = snapshot.find(directory);
+    if (it == snapshot.end())
+    {
+      continue;
+    }
+    it->second.fileNames.push_back(fileName);
+    if (storeFileNameInfo)
+    {
+      it->second.fileNameInfos.push_back(info);
+    }
+  }
+  return true;
+}
+
+bool FndbManager::Update(const PathName& fndbPath, const PathName& rootPath, ICreateFndbCallback* callback, bool enableStringPooling, bool storeFileNameInfo)
+{
+  this->storeFileNameInfo = storeFileNameInfo;
+  if (!LoadSnapshot(fndbPath))
+  {
+    trace_fndb->WriteLine("core", T_("no usable fndb snapshot; scanning all directories"));
+  }
+  bool result = Create(fndbPath, rootPath, callback, enableStringPooling, storeFileNameInfo);
+  snapshot.clear();
+  return result;
+}
+
 bool Fndb::Create(const PathName& fndbPath, const PathName& rootPath, ICreateFndbCallback* callback)
 {
   return Fndb::Create(fndbPath, rootPath, callback, true, false);
@@ -510,11 +975,27 @@ bool Fndb::Create(const PathName& fndbPath, const PathName& rootPath, ICreateFnd
   return true;
 }
 
+bool Fndb::Update(const PathName& fndbPath, const PathName& rootPath, ICreateFndbCallback* callback)
+{
+  FndbManager fndbmngr;
+
+  if (!fndbmngr.Update(fndbPath, rootPath, callback, true, false))
+  {
+    return false;
+  }
+
+#if defined(MIKTEX_WINDOWS) && REPORT_EVENTS
+  ReportMiKTeXEvent(EVENTLOG_INFORMATION_TYPE, MIKTEX_EVENT_FNDB_CREATED, fndbPath, rootPath, 0);
+#endif
+
+  return true;
+}
+
 bool Fndb::Refresh(const PathName& path, ICreateFndbCallback* callback)
 {
   unsigned root = SessionImpl::GetSession()->DeriveTEXMFRoot(path);
   PathName pathFndbPath = SessionImpl::GetSession()->GetFilenameDatabasePathName(root);
-  return Fndb::Create(pathFndbPath, SessionImpl::GetSession()->GetRootDirectoryPath(root), callback);
+  return Fndb::Update(pathFndbPath, SessionImpl::GetSession()->GetRootDirectoryPath(root), callback);
 }
 
 bool Fndb::Refresh(ICreateFndbCallback* callback)
@@ -535,7 +1016,7 @@ bool Fndb::Refresh(ICreateFndbCallback* callback)
     }
     PathName rootDirectory = session->GetRootDirectoryPath(ord);
     PathName pathFndbPath = session->GetFilenameDatabasePathName(ord);
-    if (!Fndb::Create(pathFndbPath, rootDirectory, callback))
+    if (!Fndb::Update(pathFndbPath, rootDirectory, callback))
     {
       return false;
     }
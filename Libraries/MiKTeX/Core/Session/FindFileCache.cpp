@@ -0,0 +1,252 @@
+/* FindFileCache.cpp: remembering file search results
+
+   Copyright (C) 2019 Christian Schenk
+
+   This file is part of the MiKTeX Core Library.
+
+   The MiKTeX Core Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+
+   The MiKTeX Core Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with the MiKTeX Core Library; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#include "config.h"
+
+#include <cstdlib>
+#include <cstring>
+
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+
+#include <miktex/Core/Directory>
+#include <miktex/Core/DirectoryLister>
+#include <miktex/Core/File>
+#include <miktex/Core/FileStream>
+#include <miktex/Trace/Trace>
+
+#include "internal.h"
+
+#include "FindFileCache.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Trace;
+
+#define CACHE_FILE_PREFIX "findfile-"
+#define CACHE_FILE_SUFFIX ".cache"
+
+FindFileCache::FindFileCache(const PathName& directory) :
+  directory(directory),
+  trace_filesearch(TraceStream::Open(MIKTEX_TRACE_FILESEARCH))
+{
+}
+
+void FindFileCache::SetGeneration(const string& generation, time_t timestamp)
+{
+  if (generation == this->generation)
+  {
+    return;
+  }
+  this->generation = generation;
+  this->timestamp = timestamp;
+  cacheFile = directory / fmt::format("{0}{1}-{2}{3}", CACHE_FILE_PREFIX, timestamp, generation, CACHE_FILE_SUFFIX);
+  entries.clear();
+  loadedSize = 0;
+  loaded = false;
+}
+
+bool FindFileCache::Lookup(const string& key, string& value)
+{
+  if (generation.empty())
+  {
+    return false;
+  }
+  if (!loaded)
+  {
+    Load();
+  }
+  auto it = entries.find(key);
+  if (it == entries.end())
+  {
+    return false;
+  }
+  value = it->second;
+  return true;
+}
+
+void FindFileCache::Store(const string& key, const string& value)
+{
+  if (generation.empty())
+  {
+    return;
+  }
+  if (!loaded)
+  {
+    Load();
+  }
+  auto it = entries.find(key);
+  if ((it != entries.end() && it->second == value) || entries.size() >= MAX_ENTRIES)
+  {
+    return;
+  }
+  try
+  {
+    bool created = !File::Exists(cacheFile);
+    if (created && !Directory::Exists(directory))
+    {
+      Directory::Create(directory);
+    }
+    // read and write through the same (locked) handle
+    FileStream file(File::Open(cacheFile, FileMode::Append, FileAccess::ReadWrite, false));
+    if (!File::TryLock(file.GetFile(), File::LockType::Exclusive, 100ms))
+    {
+      trace_filesearch->WriteLine("core", fmt::format(T_("find file cache {0} is busy"), Q_(cacheFile)));
+      return;
+    }
+    // other processes might have stored the same search result
+    bool complete = ReadEntries(file.GetFile());
+    it = entries.find(key);
+    if (complete && (it == entries.end() || it->second != value) && entries.size() < MAX_ENTRIES)
+    {
+      // a single write; readers ignore an incomplete last line
+      string line = key + '\t' + value + '\n';
+      if (fputs(line.c_str(), file.GetFile()) == EOF || fflush(file.GetFile()) == EOF)
+      {
+        MIKTEX_FATAL_CRT_ERROR_2("fputs", "path", cacheFile.ToString());
+      }
+      entries[key] = value;
+      loadedSize += line.length();
+    }
+    else if (!complete)
+    {
+      // another process has been interrupted while writing
+      trace_filesearch->WriteLine("core", fmt::format(T_("find file cache {0} is incomplete"), Q_(cacheFile)));
+    }
+    File::Unlock(file.GetFile());
+    file.Close();
+    if (created)
+    {
+      RemoveOldCacheFiles();
+    }
+  }
+  catch (const MiKTeXException& e)
+  {
+    trace_filesearch->WriteLine("core", fmt::format(T_("find file cache {0} cannot be written: {1}"), Q_(cacheFile), e.GetErrorMessage()));
+  }
+}
+
+void FindFileCache::Load()
+{
+  loaded = true;
+  entries.clear();
+  loadedSize = 0;
+  if (!File::Exists(cacheFile))
+  {
+    return;
+  }
+  try
+  {
+    FileStream file(File::Open(cacheFile, FileMode::Open, FileAccess::Read, false));
+    // the shared lock keeps RemoveOldCacheFiles() away
+    if (!File::TryLock(file.GetFile(), File::LockType::Shared, 100ms))
+    {
+      trace_filesearch->WriteLine("core", fmt::format(T_("find file cache {0} is busy"), Q_(cacheFile)));
+      return;
+    }
+    ReadEntries(file.GetFile());
+    File::Unlock(file.GetFile());
+    file.Close();
+    trace_filesearch->WriteLine("core", fmt::format(T_("loaded {0} entries from find file cache {1}"), entries.size(), Q_(cacheFile)));
+  }
+  catch (const MiKTeXException&)
+  {
+    entries.clear();
+    loadedSize = 0;
+  }
+}
+
+// reads the complete lines written since the last call; returns
+// false, if the file ends with an incomplete line
+bool FindFileCache::ReadEntries(FILE* file)
+{
+  if (fseek(file, static_cast<long>(loadedSize), SEEK_SET) != 0)
+  {
+    MIKTEX_FATAL_CRT_ERROR_2("fseek", "path", cacheFile.ToString());
+  }
+  string text;
+  char buf[4096];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), file)) > 0)
+  {
+    text.append(buf, n);
+  }
+  if (ferror(file) != 0)
+  {
+    MIKTEX_FATAL_CRT_ERROR_2("fread", "path", cacheFile.ToString());
+  }
+  string::size_type pos = 0;
+  for (string::size_type end; (end = text.find('\n', pos)) != string::npos; pos = end + 1)
+  {
+    string::size_type tab = text.find('\t', pos);
+    if (tab != string::npos && tab < end)
+    {
+      entries[text.substr(pos, tab - pos)] = text.substr(tab + 1, end - tab - 1);
+    }
+  }
+  loadedSize += pos;
+  return pos == text.length();
+}
+
+void FindFileCache::RemoveOldCacheFiles()
+{
+  unique_ptr<DirectoryLister> lister = DirectoryLister::Open(directory, CACHE_FILE_PREFIX "*" CACHE_FILE_SUFFIX);
+  DirectoryEntry entry;
+  vector<PathName> oldFiles;
+  while (lister->GetNext(entry))
+  {
+    // keep the cache files of the current and of newer generations:
+    // other processes might not have noticed the FNDB changes yet
+    if (!entry.isDirectory && std::strtoll(entry.name.c_str() + strlen(CACHE_FILE_PREFIX), nullptr, 10) < timestamp)
+    {
+      oldFiles.push_back(directory / entry.name);
+    }
+  }
+  lister->Close();
+  for (const PathName& path : oldFiles)
+  {
+    try
+    {
+      // don't remove a cache file which is being used by another
+      // process
+      FileStream file(File::Open(path, FileMode::Open, FileAccess::Read, false));
+      if (!File::TryLock(file.GetFile(), File::LockType::Exclusive, 0ms))
+      {
+        continue;
+      }
+#if defined(MIKTEX_WINDOWS)
+      // fails, if the file is still open in another process
+      File::Unlock(file.GetFile());
+      file.Close();
+      File::Delete(path);
+#else
+      File::Delete(path);
+      File::Unlock(file.GetFile());
+      file.Close();
+#endif
+      trace_filesearch->WriteLine("core", fmt::format(T_("removed old find file cache {0}"), Q_(path)));
+    }
+    catch (const MiKTeXException&)
+    {
+    }
+  }
+}
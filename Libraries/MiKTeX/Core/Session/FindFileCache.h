@@ -0,0 +1,111 @@
+/* FindFileCache.h: remembering file search results      -*- C++ -*-
+
+   Copyright (C) 2019 Christian Schenk
+
+   This file is part of the MiKTeX Core Library.
+
+   The MiKTeX Core Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+
+   The MiKTeX Core Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with the MiKTeX Core Library; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#pragma once
+
+#if !defined(E19380487F894F44A4FE2195643294CB)
+#define E19380487F894F44A4FE2195643294CB
+
+#include <cstddef>
+#include <cstdio>
+#include <ctime>
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include <miktex/Core/PathName>
+#include <miktex/Trace/TraceStream>
+
+CORE_INTERNAL_BEGIN_NAMESPACE;
+
+/// Remembers file search results across processes.
+///
+/// There is one cache file per FNDB generation; entries are appended
+/// to the cache file and never changed.  A new FNDB generation
+/// starts with an empty cache file.  A search result is appended only
+/// once, and at most `MAX_ENTRIES` entries are stored per generation.
+class FindFileCache
+{
+public:
+  FindFileCache(const MiKTeX::Core::PathName& directory);
+
+  /// Selects the cache file for an FNDB generation.
+  /// @param generation The FNDB generation; an empty string disables
+  /// the cache.
+  /// @param timestamp The time the FNDB generation came into being;
+  /// cache files of older generations are removed.
+public:
+  void SetGeneration(const std::string& generation, time_t timestamp);
+
+  /// Looks up a search result.
+  /// @param key The search key.
+  /// @param[out] value The path to the found file; empty, if the file
+  /// was not found.
+  /// @return Returns true, if the search result is known.
+public:
+  bool Lookup(const std::string& key, std::string& value);
+
+  /// Remembers a search result.
+public:
+  void Store(const std::string& key, const std::string& value);
+
+private:
+  void Load();
+
+private:
+  bool ReadEntries(FILE* file);
+
+private:
+  void RemoveOldCacheFiles();
+
+private:
+  static constexpr std::size_t MAX_ENTRIES = 10000;
+
+private:
+  MiKTeX::Core::PathName directory;
+
+private:
+  MiKTeX::Core::PathName cacheFile;
+
+private:
+  std::string generation;
+
+private:
+  time_t timestamp = 0;
+
+private:
+  bool loaded = false;
+
+private:
+  // number of bytes read from the cache file
+  std::size_t loadedSize = 0;
+
+private:
+  std::unordered_map<std::string, std::string> entries;
+
+private:
+  std::unique_ptr<MiKTeX::Trace::TraceStream> trace_filesearch;
+};
+
+CORE_INTERNAL_END_NAMESPACE;
+
+#endif
@@ -51,6 +51,8 @@ using namespace MiKTeX::Core;
 using namespace MiKTeX::Trace;
 using namespace MiKTeX::Util;
 
+const size_t TRACE_RING_BUFFER_SIZE = 1024 * 256;
+
 weak_ptr<SessionImpl> SessionImpl::theSession;
 
 shared_ptr<Session> Session::Create(const Session::InitInfo& initInfo)
@@ -179,6 +181,11 @@ void SessionImpl::Initialize(const Session::InitInfo& initInfo)
   if (!traceOptions.empty())
   {
     TraceStream::SetOptions(traceOptions);
+    string traceDumpFile;
+    if (Utils::GetEnvironmentString(MIKTEX_ENV_TRACE_DUMP_FILE, traceDumpFile))
+    {
+      TraceStream::EnableRingBuffer(traceDumpFile, TRACE_RING_BUFFER_SIZE);
+    }
   }
 
   DoStartupConfig();
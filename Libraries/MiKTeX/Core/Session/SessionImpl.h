@@ -48,6 +48,7 @@
 #include <miktex/Core/hash_icase>
 
 #include "Fndb/FileNameDatabase.h"
+#include "FindFileCache.h"
 #include "RootDirectoryInternals.h"
 
 #if defined(MIKTEX_WINDOWS) && USE_LOCAL_SERVER
@@ -113,6 +114,11 @@ struct InternalFileTypeInfo :
 {
 public:
   std::vector<MiKTeX::Core::PathName> searchVec;
+
+  // MD5 of the search vector; identifies the search vector in the find
+  // file cache
+public:
+  std::string searchVecDigest;
 };
 
 class DvipsPaperSizeInfo : public MiKTeX::Core::PaperSizeInfo
@@ -524,6 +530,18 @@ public:
 public:
   std::shared_ptr<FileNameDatabase> GetFileNameDatabase(const char* path);
 
+public:
+  void BeginFndbTransaction();
+
+public:
+  void CommitFndbTransaction();
+
+public:
+  bool IsFndbTransactionActive() const
+  {
+    return fndbTransactionLevel > 0;
+  }
+
 public:
   MiKTeX::Core::PathName GetTempDirectory();
 
@@ -544,6 +562,11 @@ public:
 public:
   void RecordMaintenance();
 
+  /// Makes sure that the find file cache is revalidated before its
+  /// next use; called when this process changes an FNDB.
+public:
+  void InvalidateFindFileCache();
+
 private:
   void ReadDvipsPaperSizes();
 
@@ -749,6 +772,21 @@ private:
 private:
   bool SearchFileSystem(const std::string& fileName, const char* dirPath, bool firstMatchOnly, std::vector<MiKTeX::Core::PathName>& result);
 
+private:
+  FindFileCache* GetFindFileCache();
+
+private:
+  std::string GetFndbGeneration(time_t& timestamp);
+
+private:
+  const std::string& GetSearchVectorDigest(MiKTeX::Core::FileType fileType);
+
+private:
+  bool IsCoveredByFndb(const MiKTeX::Core::PathName& directoryPattern);
+
+private:
+  bool TryGetCachedResult(const std::vector<MiKTeX::Core::PathName>& fileNamesToTry, const std::vector<MiKTeX::Core::PathName>& vec, const std::string& cachedPath, std::vector<MiKTeX::Core::PathName>& result);
+
 private:
   bool CheckCandidate(MiKTeX::Core::PathName& path, const char* fileInfo);
 
@@ -975,6 +1013,31 @@ private:
 private:
   SearchPathDictionary expandedPathPatterns;
 
+private:
+  std::unique_ptr<FindFileCache> findFileCache;
+
+private:
+  bool haveFindFileCacheConfiguration = false;
+
+private:
+  std::chrono::milliseconds findFileCacheRevalidationInterval;
+
+private:
+  std::chrono::time_point<std::chrono::high_resolution_clock> nextFindFileCacheRevalidation;
+
+  // nesting level of FNDB transactions
+private:
+  int fndbTransactionLevel = 0;
+
+  // roots (including the MPM root) which have an FNDB; updated when
+  // the find file cache is revalidated
+private:
+  std::set<unsigned> rootsWithFndb;
+
+  // true, if the FNDB search found a file in the MPM root
+private:
+  bool sawPackageCandidate = false;
+
   // file access history
 private:
   std::vector<MiKTeX::Core::FileInfoRecord> fileInfoRecords;
@@ -674,6 +674,8 @@ void SessionImpl::ReadAllConfigFiles(const string& baseName, Cfg& cfg)
   {
     return;
   }
+  // parsed configuration files are cached as binary snapshots
+  PathName snapshotDirectory = GetSpecialPath(SpecialPath::UserDataRoot) / MIKTEX_PATH_FNDB_DIR;
   for (vector<PathName>::const_reverse_iterator it = configFiles.rbegin(); it != configFiles.rend(); ++it)
   {
     unsigned r = TryDeriveTEXMFRoot(*it);
@@ -681,7 +683,7 @@ void SessionImpl::ReadAllConfigFiles(const string& baseName, Cfg& cfg)
     {
       continue;
     }
-    cfg.Read(*it);
+    cfg.ReadWithSnapshot(*it, snapshotDirectory);
   }
 }
 
@@ -50,7 +50,7 @@ using namespace std;
 
 using namespace MiKTeX::Core;
 
-const size_t PIPE_SIZE = 4096;
+const size_t PIPE_SIZE = 1024 * 64;
 
 MIKTEXSTATICFUNC(int) Close(int fd)
 {
@@ -255,6 +255,31 @@ FILE* SessionImpl::InitiateProcessPipe(const string& command, FileAccess access,
   }
 }
 
+#if defined(HAVE_FOPENCOOKIE) || defined(HAVE_FUNOPEN)
+#if defined(HAVE_FOPENCOOKIE)
+MIKTEXSTATICFUNC(ssize_t) ReadStreamCookie(void* cookie, char* buf, size_t size)
+#else
+MIKTEXSTATICFUNC(int) ReadStreamCookie(void* cookie, char* buf, int size)
+#endif
+{
+  try
+  {
+    return reinterpret_cast<Stream*>(cookie)->Read(buf, size);
+  }
+  catch (const exception&)
+  {
+    errno = EIO;
+    return -1;
+  }
+}
+
+MIKTEXSTATICFUNC(int) CloseStreamCookie(void* cookie)
+{
+  delete reinterpret_cast<Stream*>(cookie);
+  return 0;
+}
+#endif
+
 MIKTEXSTATICFUNC(void) ReaderThread(unique_ptr<Stream> inStream, unique_ptr<Stream> outStream)
 {
   try
@@ -271,12 +296,33 @@ MIKTEXSTATICFUNC(void) ReaderThread(unique_ptr<Stream> inStream, unique_ptr<Stre
   }
 }
 
+// read the stream through stdio callbacks if possible; otherwise let
+// a thread copy the stream into a pipe
 FILE* SessionImpl::OpenFileOnStream(std::unique_ptr<Stream> stream)
 {
+#if defined(HAVE_FOPENCOOKIE)
+  cookie_io_functions_t functions = { ReadStreamCookie, nullptr, nullptr, CloseStreamCookie };
+  FILE* file = fopencookie(stream.get(), "rb", functions);
+  if (file == nullptr)
+  {
+    MIKTEX_FATAL_CRT_ERROR("fopencookie");
+  }
+  stream.release();
+  return file;
+#elif defined(HAVE_FUNOPEN)
+  FILE* file = funopen(stream.get(), ReadStreamCookie, nullptr, nullptr, CloseStreamCookie);
+  if (file == nullptr)
+  {
+    MIKTEX_FATAL_CRT_ERROR("funopen");
+  }
+  stream.release();
+  return file;
+#else
   array<unique_ptr<FileStream>, 2> files = CreatePipe(PIPE_SIZE);
   thread readerThread(&ReaderThread, move(stream), move(files[1]));
   readerThread.detach();
   return files[0]->Detach();
+#endif
 }
 
 pair<bool, Session::OpenFileInfo> SessionImpl::TryGetOpenFileInfo(FILE* file)
@@ -294,5 +294,6 @@ void SessionImpl::ClearSearchVectors()
   for (InternalFileTypeInfo& info : fileTypes)
   {
     info.searchVec.clear();
+    info.searchVecDigest.clear();
   }
 }
@@ -21,9 +21,13 @@
 
 #include "config.h"
 
+#include <algorithm>
+
 #include <fmt/format.h>
 #include <fmt/ostream.h>
 
+#include <miktex/Core/ConfigNames>
+#include <miktex/Core/MD5>
 #include <miktex/Core/Paths>
 #include <miktex/Core/Registry>
 
@@ -78,7 +82,7 @@ bool SessionImpl::SearchFileSystem(const string& fileName, const char* lpszDirec
     return false;
   }
 
-  trace_filesearch->WriteFormattedLine("core", T_("file system search: filename=%s, directory=%s"), Q_(fileName), Q_(lpszDirectoryPattern));
+  MIKTEX_TRACE_WRITE_LINE(trace_filesearch, "core", fmt::format(T_("file system search: filename={0}, directory={1}"), Q_(fileName), Q_(lpszDirectoryPattern)));
 
   vector<PathName> directories;
 
@@ -165,7 +169,7 @@ bool SessionImpl::FindFileInternal(const string& fileName, const vector<PathName
   {
     for (vector<PathName>::const_iterator it = directoryPatterns.begin(); !(found && firstMatchOnly) && it != directoryPatterns.end(); ++it)
     {
-      trace_filesearch->WriteFormattedLine("core", T_("going to search in fndb: filename=%s, directory=%s"), Q_(fileName), Q_(it->ToString()));
+      MIKTEX_TRACE_WRITE_LINE(trace_filesearch, "core", fmt::format(T_("going to search in fndb: filename={0}, directory={1}"), Q_(fileName), Q_(*it)));
       if (found && !firstMatchOnly && IsMpmFile(it->GetData()))
       {
         // don't trigger the package installer
@@ -179,6 +183,10 @@ bool SessionImpl::FindFileInternal(const string& fileName, const vector<PathName
         bool foundInFndb = fndb->Search(fileName, it->ToString(), firstMatchOnly, records);
         // we must release the FNDB handle since CheckCandidate() might request an unload of the FNDB
         fndb = nullptr;
+        if (foundInFndb && IsMpmFile(it->GetData()))
+        {
+          sawPackageCandidate = true;
+        }
         if (foundInFndb)
         {
           for (int idx = 0; idx < records.size(); ++idx)
@@ -193,7 +201,7 @@ bool SessionImpl::FindFileInternal(const string& fileName, const vector<PathName
       }
       else
       {
-        trace_filesearch->WriteFormattedLine("core", T_("no fndb found, so going to continue on disk: filename=%s, directory=%s"), Q_(fileName), Q_(it->ToString()));
+        MIKTEX_TRACE_WRITE_LINE(trace_filesearch, "core", fmt::format(T_("no fndb found, so going to continue on disk: filename={0}, directory={1}"), Q_(fileName), Q_(*it)));
         // search the file system because the file name database does not exist
         vector<PathName> paths;
         if (SearchFileSystem(fileName, it->GetData(), firstMatchOnly, paths))
@@ -294,10 +302,54 @@ bool SessionImpl::FindFileInternal(const string& fileName, FileType fileType, bo
   // try it with the given file name
   fileNamesToTry.push_back(fileName);
 
-  // first round: use the fndb
-  for (const PathName& fn : fileNamesToTry)
+  // the result of the first round can be remembered if it depends
+  // only on the FNDBs
+  FindFileCache* cache = firstMatchOnly ? GetFindFileCache() : nullptr;
+  string cacheKey;
+  if (cache != nullptr
+    && !Utils::IsAbsolutePath(fileName)
+    && !IsExplicitlyRelativePath(fileName.c_str())
+    && fileName.find_first_of("\t\r\n") == string::npos)
+  {
+    cacheKey = fmt::format("{};{};{}", static_cast<int>(fileType), GetSearchVectorDigest(fileType), fileName);
+  }
+
+  string cachedPath;
+  if (!cacheKey.empty() && cache->Lookup(cacheKey, cachedPath) && TryGetCachedResult(fileNamesToTry, vec, cachedPath, result))
   {
-    if (FindFileInternal(fn.GetData(), vec, firstMatchOnly, true, false, result) && firstMatchOnly)
+    MIKTEX_TRACE_WRITE_LINE(trace_filesearch, "core", fmt::format(T_("find file cache hit: {0} -> {1}"), Q_(fileName), Q_(cachedPath)));
+    if (!result.empty())
+    {
+      return true;
+    }
+  }
+  else
+  {
+    // first round: use the fndb
+    sawPackageCandidate = false;
+    for (const PathName& fn : fileNamesToTry)
+    {
+      if (FindFileInternal(fn.GetData(), vec, firstMatchOnly, true, false, result) && firstMatchOnly)
+      {
+        break;
+      }
+    }
+    if (!cacheKey.empty())
+    {
+      if (!result.empty())
+      {
+        if (Utils::IsAbsolutePath(result[0]) && IsCoveredByFndb(result[0]) && result[0].ToString().find_first_of("\t\r\n") == string::npos)
+        {
+          cache->Store(cacheKey, result[0].ToString());
+        }
+      }
+      else if (!sawPackageCandidate)
+      {
+        // don't remember a package which has not been installed
+        cache->Store(cacheKey, "");
+      }
+    }
+    if (firstMatchOnly && !result.empty())
     {
       return true;
     }
@@ -348,6 +400,136 @@ bool SessionImpl::FindFileInternal(const string& fileName, FileType fileType, bo
   return !result.empty();
 }
 
+FindFileCache* SessionImpl::GetFindFileCache()
+{
+  if (!haveFindFileCacheConfiguration)
+  {
+    // set the flag first: reading the configuration might search files
+    haveFindFileCacheConfiguration = true;
+    if (IsAdminMode() || !GetConfigValue(MIKTEX_CONFIG_SECTION_CORE, MIKTEX_CONFIG_VALUE_FINDFILECACHE, false).GetBool())
+    {
+      return nullptr;
+    }
+    findFileCacheRevalidationInterval = chrono::milliseconds(GetConfigValue(MIKTEX_CONFIG_SECTION_CORE, MIKTEX_CONFIG_VALUE_FNDBREVALIDATIONINTERVAL, 1000).GetInt());
+    findFileCache = make_unique<FindFileCache>(GetSpecialPath(SpecialPath::UserDataRoot) / MIKTEX_PATH_FNDB_DIR);
+  }
+  // the generation does not cover uncommitted FNDB changes
+  if (findFileCache == nullptr || IsFndbTransactionActive())
+  {
+    return nullptr;
+  }
+  chrono::time_point<chrono::high_resolution_clock> now = chrono::high_resolution_clock::now();
+  if (now >= nextFindFileCacheRevalidation)
+  {
+    time_t timestamp;
+    string generation = GetFndbGeneration(timestamp);
+    findFileCache->SetGeneration(generation, timestamp);
+    nextFindFileCacheRevalidation = now + findFileCacheRevalidationInterval;
+  }
+  return findFileCache.get();
+}
+
+void SessionImpl::InvalidateFindFileCache()
+{
+  nextFindFileCacheRevalidation = chrono::time_point<chrono::high_resolution_clock>();
+}
+
+string SessionImpl::GetFndbGeneration(time_t& timestamp)
+{
+  string generation;
+  timestamp = 0;
+  rootsWithFndb.clear();
+  try
+  {
+    // the last index denotes the MPM root
+    for (unsigned r = 0; r <= GetNumberOfTEXMFRoots(); ++r)
+    {
+      PathName fndbPath;
+      if (!FindFilenameDatabase(r, fndbPath))
+      {
+        generation += "-;";
+        continue;
+      }
+      rootsWithFndb.insert(r);
+      time_t lastWriteTime = File::GetLastWriteTime(fndbPath);
+      timestamp = std::max(timestamp, lastWriteTime);
+      generation += fmt::format("{};{};{};", fndbPath, lastWriteTime, File::GetSize(fndbPath));
+      PathName changeFile = fndbPath;
+      changeFile.SetExtension(MIKTEX_FNDB_CHANGE_FILE_SUFFIX);
+      if (File::Exists(changeFile))
+      {
+        lastWriteTime = File::GetLastWriteTime(changeFile);
+        timestamp = std::max(timestamp, lastWriteTime);
+        generation += fmt::format("{};{};", lastWriteTime, File::GetSize(changeFile));
+      }
+    }
+  }
+  catch (const MiKTeXException& e)
+  {
+    // an FNDB is being changed: don't use the cache for now
+    trace_filesearch->WriteLine("core", fmt::format(T_("cannot determine the FNDB generation: {0}"), e.GetErrorMessage()));
+    rootsWithFndb.clear();
+    return "";
+  }
+  return MD5::FromChars(generation).ToString();
+}
+
+const string& SessionImpl::GetSearchVectorDigest(FileType fileType)
+{
+  InternalFileTypeInfo* fti = GetInternalFileTypeInfo(fileType);
+  if (fti->searchVecDigest.empty())
+  {
+    fti->searchVecDigest = MD5::FromChars(MakeSearchPath(ConstructSearchVector(fileType))).ToString();
+  }
+  return fti->searchVecDigest;
+}
+
+bool SessionImpl::IsCoveredByFndb(const PathName& directoryPattern)
+{
+  if (!Utils::IsAbsolutePath(directoryPattern))
+  {
+    return false;
+  }
+  unsigned r = TryDeriveTEXMFRoot(directoryPattern);
+  return r != INVALID_ROOT_INDEX && rootsWithFndb.find(r) != rootsWithFndb.end();
+}
+
+bool SessionImpl::TryGetCachedResult(const vector<PathName>& fileNamesToTry, const vector<PathName>& vec, const string& cachedPath, vector<PathName>& result)
+{
+  // directories without an FNDB are not covered by the cache: they
+  // must not contain the file
+  vector<PathName> uncoveredDirectories;
+  for (const PathName& dir : vec)
+  {
+    if (!IsCoveredByFndb(dir))
+    {
+      uncoveredDirectories.push_back(dir);
+    }
+  }
+  if (!uncoveredDirectories.empty())
+  {
+    vector<PathName> paths;
+    for (const PathName& fn : fileNamesToTry)
+    {
+      if (FindFileInternal(fn.GetData(), uncoveredDirectories, true, true, false, paths))
+      {
+        return false;
+      }
+    }
+  }
+  if (cachedPath.empty())
+  {
+    return true;
+  }
+  PathName path(cachedPath);
+  if (!File::Exists(path))
+  {
+    return false;
+  }
+  result.push_back(path);
+  return true;
+}
+
 bool SessionImpl::FindFile(const string& fileName, const string& pathList, FindFileOptionSet options, vector<PathName>& result)
 {
   bool found = FindFileInternal(fileName, SplitSearchPath(pathList), !options[FindFileOption::All], true, false, result);
@@ -1182,6 +1182,12 @@ bool SessionImpl::UnloadFilenameDatabaseInternal_nolock(unsigned r, chrono::dura
   {
     trace_fndb->WriteLine("core", fmt::format(T_("going to unload file name database #{0}"), r));
 
+    if (fndb->HasUncommittedChanges())
+    {
+      trace_fndb->WriteLine("core", fmt::format(T_("cannot unload fndb #{0}: uncommitted changes"), r));
+      return false;
+    }
+
     // check the reference count
     if (fndb.use_count() > 2)
     {
@@ -1204,6 +1210,40 @@ bool SessionImpl::UnloadFilenameDatabaseInternal_nolock(unsigned r, chrono::dura
   return true;
 }
 
+void SessionImpl::BeginFndbTransaction()
+{
+  fndbTransactionLevel++;
+}
+
+void SessionImpl::CommitFndbTransaction()
+{
+  if (fndbTransactionLevel <= 0)
+  {
+    MIKTEX_UNEXPECTED();
+  }
+  if (--fndbTransactionLevel > 0)
+  {
+    return;
+  }
+  vector<shared_ptr<FileNameDatabase>> fndbs;
+  {
+    lock_guard<mutex> lockGuard(fndbMutex);
+    for (const RootDirectoryInternals& root : rootDirectories)
+    {
+      shared_ptr<FileNameDatabase> fndb = root.GetFndb();
+      if (fndb != nullptr && fndb->HasUncommittedChanges())
+      {
+        fndbs.push_back(fndb);
+      }
+    }
+  }
+  for (const shared_ptr<FileNameDatabase>& fndb : fndbs)
+  {
+    fndb->Commit();
+  }
+  InvalidateFindFileCache();
+}
+
 bool SessionImpl::UnloadFilenameDatabase(chrono::duration<double> minIdleTime)
 {
   bool done = true;
@@ -41,7 +41,7 @@ class BZip2StreamImpl :
 public:
   BZip2StreamImpl(const PathName& path, bool reading)
   {
-    StartThread(path, reading);
+    Start(path, reading);
   }
 
 public:
@@ -49,7 +49,7 @@ public:
   {
     try
     {
-      StopThread();
+      Stop();
     }
     catch (const exception &)
     {
@@ -79,30 +79,29 @@ private:
 protected:
   virtual void DoUncompress(const PathName& path)
   {
-    const size_t BUFFER_SIZE = 1024 * 16;
-    char inbuf[BUFFER_SIZE];
-    char outbuf[BUFFER_SIZE];
+    vector<char> inbuf(CHUNK_SIZE);
+    vector<char> outbuf(CHUNK_SIZE);
     unique_ptr<FileStream> fileStream = make_unique<FileStream>(File::Open(path, FileMode::Open, FileAccess::Read, false));
     unique_ptr<bz_stream_wrapper> bzStream = make_unique<bz_stream_wrapper>();
     bzStream->next_in = nullptr;
     bzStream->avail_in = 0;
-    bzStream->next_out = outbuf;
-    bzStream->avail_out = BUFFER_SIZE;
+    bzStream->next_out = outbuf.data();
+    bzStream->avail_out = CHUNK_SIZE;
     bool eof = false;
     while (true)
     {
       if (bzStream->avail_in == 0 && !eof)
       {
-        bzStream->next_in = inbuf;
-        bzStream->avail_in = static_cast<unsigned int>(fileStream->Read(inbuf, BUFFER_SIZE));
+        bzStream->next_in = inbuf.data();
+        bzStream->avail_in = static_cast<unsigned int>(fileStream->Read(inbuf.data(), CHUNK_SIZE));
         eof = bzStream->avail_in == 0;
       }
       int ret = BZ2_bzDecompress(bzStream.get());
       if (bzStream->avail_out == 0 || ret == BZ_STREAM_END)
       {
-        pipe.Write(outbuf, sizeof(outbuf) - bzStream->avail_out);
-        bzStream->next_out = outbuf;
-        bzStream->avail_out = BUFFER_SIZE;
+        Output(outbuf.data(), CHUNK_SIZE - bzStream->avail_out);
+        bzStream->next_out = outbuf.data();
+        bzStream->avail_out = CHUNK_SIZE;
       }
       if (ret != BZ_OK)
       {
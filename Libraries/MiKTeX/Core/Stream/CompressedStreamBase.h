@@ -19,8 +19,15 @@
    Software Foundation, 59 Temple Place - Suite 330, Boston, MA
    02111-1307, USA. */
 
+#include <algorithm>
+#include <memory>
 #include <thread>
+#include <vector>
 
+#include <miktex/Core/ConfigNames>
+#include <miktex/Core/File>
+
+#include "Session/SessionImpl.h"
 #include "Utils/Pipe.h"
 
 CORE_INTERNAL_BEGIN_NAMESPACE;
@@ -31,11 +38,23 @@ template<typename Interface> class CompressedStreamBase :
 public:
   size_t Read(void* data, size_t count) override
   {
+    if (synchronous)
+    {
+      size_t n = std::min(count, uncompressed.size() - readPos);
+      memcpy(data, uncompressed.data() + readPos, n);
+      readPos += n;
+      return n;
+    }
     if (IsUnsuccessful())
     {
       throw threadMiKTeXException;
     }
-    return pipe.Read(data, count);
+    size_t n = pipe->Read(data, count);
+    if (n == 0 && IsUnsuccessful())
+    {
+      throw threadMiKTeXException;
+    }
+    return n;
   }
 
 public:
@@ -56,17 +75,80 @@ public:
     UNIMPLEMENTED();
   }
 
+  /// Starts decompressing. Small files are decompressed at once
+  /// into memory; larger files (and small files which turn out to
+  /// expand too much) are decompressed by a separate thread.
 protected:
-  void StartThread(const MiKTeX::Core::PathName& path, bool reading)
+  void Start(const MiKTeX::Core::PathName& path, bool reading)
   {
+    size_t syncThreshold = DEFAULT_SYNC_THRESHOLD;
+    size_t bufferSize = Pipe::DEFAULT_CAPACITY;
+    std::shared_ptr<SessionImpl> session = SessionImpl::TryGetSession();
+    if (session != nullptr)
+    {
+      syncThreshold = session->GetConfigValue(MIKTEX_CONFIG_SECTION_CORE, MIKTEX_CONFIG_VALUE_SYNCDECOMPRESSIONTHRESHOLD, static_cast<int>(DEFAULT_SYNC_THRESHOLD)).GetInt();
+      int bufferSizeKb = session->GetConfigValue(MIKTEX_CONFIG_SECTION_CORE, MIKTEX_CONFIG_VALUE_DECOMPRESSIONBUFFERSIZE, static_cast<int>(Pipe::DEFAULT_CAPACITY / 1024)).GetInt();
+      // the buffer must hold at least one chunk; the pipe rounds up
+      // to a power of two
+      if (bufferSizeKb <= 0 || static_cast<size_t>(bufferSizeKb) < CHUNK_SIZE / 1024)
+      {
+        bufferSize = CHUNK_SIZE;
+      }
+      else if (static_cast<size_t>(bufferSizeKb) > Pipe::MAX_CAPACITY / 1024)
+      {
+        bufferSize = Pipe::MAX_CAPACITY;
+      }
+      else
+      {
+        bufferSize = static_cast<size_t>(bufferSizeKb) * 1024;
+      }
+    }
+    if (reading && MiKTeX::Core::File::GetSize(path) <= syncThreshold)
+    {
+      synchronous = true;
+      maxSyncSize = syncThreshold * MAX_SYNC_EXPANSION;
+      try
+      {
+        DoUncompress(path);
+        Finish(true);
+        return;
+      }
+      catch (const SyncSizeExceeded&)
+      {
+        synchronous = false;
+        std::vector<unsigned char>().swap(uncompressed);
+      }
+    }
+    pipe = std::make_unique<Pipe>(bufferSize);
     thrd = std::thread(&CompressedStreamBase::UncompressThread, this, path, reading);
   }
 
 protected:
-  void StopThread()
+  void Stop()
   {
-    pipe.Close();
-    thrd.join();
+    if (thrd.joinable())
+    {
+      pipe->Close();
+      thrd.join();
+    }
+  }
+
+  /// Passes decompressed data to the reader.
+protected:
+  void Output(const void* data, size_t count)
+  {
+    if (synchronous)
+    {
+      if (uncompressed.size() + count > maxSyncSize)
+      {
+        throw SyncSizeExceeded();
+      }
+      uncompressed.insert(uncompressed.end(), (const unsigned char*)data, (const unsigned char*)data + count);
+    }
+    else
+    {
+      pipe->Write(data, count);
+    }
   }
 
 protected:
@@ -79,18 +161,20 @@ protected:
         UNIMPLEMENTED();
       }
       DoUncompress(path);
-      pipe.Close();
+      pipe->Close();
       Finish(true);
     }
     catch (const MiKTeX::Core::MiKTeXException& e)
     {
       threadMiKTeXException = e;
       Finish(false);
+      pipe->Close();
     }
     catch (const std::exception& e)
     {
       threadMiKTeXException = MiKTeX::Core::MiKTeXException(e.what());
       Finish(false);
+      pipe->Close();
     }
   }
 
@@ -101,7 +185,31 @@ protected:
   std::thread thrd;
 
 protected:
-  Pipe pipe;
+  static constexpr size_t DEFAULT_SYNC_THRESHOLD = 1024 * 64;
+
+protected:
+  static constexpr size_t MAX_SYNC_EXPANSION = 16;
+
+protected:
+  static constexpr size_t CHUNK_SIZE = 1024 * 64;
+
+private:
+  class SyncSizeExceeded {};
+
+protected:
+  size_t maxSyncSize = 0;
+
+protected:
+  std::unique_ptr<Pipe> pipe;
+
+protected:
+  bool synchronous = false;
+
+protected:
+  std::vector<unsigned char> uncompressed;
+
+protected:
+  size_t readPos = 0;
 
 protected:
   enum State {
@@ -41,7 +41,7 @@ class GzipStreamImpl :
 public:
   GzipStreamImpl(const PathName& path, bool reading)
   {
-    StartThread(path, reading);
+    Start(path, reading);
   }
 
 public:
@@ -49,7 +49,7 @@ public:
   {
     try
     {
-      StopThread();
+      Stop();
     }
     catch (const exception &)
     {
@@ -79,30 +79,29 @@ private:
 protected:
   void DoUncompress(const PathName& path)
   {
-    const size_t BUFFER_SIZE = 1024 * 16;
-    unsigned char inbuf[BUFFER_SIZE];
-    unsigned char outbuf[BUFFER_SIZE];
+    vector<unsigned char> inbuf(CHUNK_SIZE);
+    vector<unsigned char> outbuf(CHUNK_SIZE);
     unique_ptr<FileStream> fileStream = make_unique<FileStream>(File::Open(path, FileMode::Open, FileAccess::Read, false));
     unique_ptr<gz_stream_wrapper> gzStream = make_unique<gz_stream_wrapper>();
     gzStream->next_in = nullptr;
     gzStream->avail_in = 0;
-    gzStream->next_out = outbuf;
-    gzStream->avail_out = BUFFER_SIZE;
+    gzStream->next_out = outbuf.data();
+    gzStream->avail_out = CHUNK_SIZE;
     bool eof = false;
     while (true)
     {
       if (gzStream->avail_in == 0 && !eof)
       {
-        gzStream->next_in = inbuf;
-        gzStream->avail_in = static_cast<uInt>(fileStream->Read(inbuf, BUFFER_SIZE));
+        gzStream->next_in = inbuf.data();
+        gzStream->avail_in = static_cast<uInt>(fileStream->Read(inbuf.data(), CHUNK_SIZE));
         eof = gzStream->avail_in == 0;
       }
       int ret = inflate(gzStream.get(), eof ? Z_FINISH : Z_NO_FLUSH);
       if (gzStream->avail_out == 0 || ret == Z_STREAM_END)
       {
-        pipe.Write(outbuf, sizeof(outbuf) - gzStream->avail_out);
-        gzStream->next_out = outbuf;
-        gzStream->avail_out = BUFFER_SIZE;
+        Output(outbuf.data(), CHUNK_SIZE - gzStream->avail_out);
+        gzStream->next_out = outbuf.data();
+        gzStream->avail_out = CHUNK_SIZE;
       }
       if (ret != Z_OK)
       {
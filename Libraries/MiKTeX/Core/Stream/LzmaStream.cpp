@@ -41,7 +41,7 @@ class LzmaStreamImpl :
 public:
   LzmaStreamImpl(const PathName& path, bool reading)
   {
-    StartThread(path, reading);
+    Start(path, reading);
   }
 
 public:
@@ -49,7 +49,7 @@ public:
   {
     try
     {
-      StopThread();
+      Stop();
     }
     catch (const exception &)
     {
@@ -79,30 +79,29 @@ private:
 protected:
   virtual void DoUncompress(const PathName& path)
   {
-    const size_t BUFFER_SIZE = 1024 * 16;
-    uint8_t inbuf[BUFFER_SIZE];
-    uint8_t outbuf[BUFFER_SIZE];
+    vector<uint8_t> inbuf(CHUNK_SIZE);
+    vector<uint8_t> outbuf(CHUNK_SIZE);
     unique_ptr<FileStream> fileStream = make_unique<FileStream>(File::Open(path, FileMode::Open, FileAccess::Read, false));
     unique_ptr<lzma_stream_wrapper> lzmaStream = make_unique<lzma_stream_wrapper>();
     lzmaStream->next_in = nullptr;
     lzmaStream->avail_in = 0;
-    lzmaStream->next_out = outbuf;
-    lzmaStream->avail_out = BUFFER_SIZE;
+    lzmaStream->next_out = outbuf.data();
+    lzmaStream->avail_out = CHUNK_SIZE;
     bool eof = false;
     while (true)
     {
       if (lzmaStream->avail_in == 0 && !eof)
       {
-        lzmaStream->next_in = inbuf;
-        lzmaStream->avail_in = fileStream->Read(inbuf, BUFFER_SIZE);
+        lzmaStream->next_in = inbuf.data();
+        lzmaStream->avail_in = fileStream->Read(inbuf.data(), CHUNK_SIZE);
         eof = lzmaStream->avail_in == 0;
       }
       lzma_ret ret = lzma_code(lzmaStream.get(), eof ? LZMA_FINISH : LZMA_RUN);
       if (lzmaStream->avail_out == 0 || ret == LZMA_STREAM_END)
       {
-        pipe.Write(outbuf, sizeof(outbuf) - lzmaStream->avail_out);
-        lzmaStream->next_out = outbuf;
-        lzmaStream->avail_out = BUFFER_SIZE;
+        Output(outbuf.data(), CHUNK_SIZE - lzmaStream->avail_out);
+        lzmaStream->next_out = outbuf.data();
+        lzmaStream->avail_out = CHUNK_SIZE;
       }
       if (ret != LZMA_OK)
       {
@@ -24,6 +24,7 @@
 #include <atomic>
 #include <condition_variable>
 #include <mutex>
+#include <thread>
 
 CORE_INTERNAL_BEGIN_NAMESPACE;
 
@@ -32,15 +33,46 @@ CORE_INTERNAL_BEGIN_NAMESPACE;
 #  undef min
 #endif
 
+// A single-producer/single-consumer ring buffer.  The producer owns
+// the tail index, the consumer owns the head index; both indices grow
+// monotonically and are reduced modulo the (power of two) capacity
+// when the buffer is accessed.  A thread which cannot make progress
+// spins for a short while and then goes to sleep; the other side
+// takes the mutex only if it sees that a thread is sleeping.
 class Pipe
 {
 public:
-  Pipe()
+  static constexpr size_t DEFAULT_CAPACITY = 1024 * 256;
+
+public:
+  static constexpr size_t MIN_CAPACITY = 1024;
+
+public:
+  static constexpr size_t MAX_CAPACITY = 1024 * 1024 * 64;
+
+public:
+  Pipe(size_t minCapacity = DEFAULT_CAPACITY)
   {
-    capacity = 1024 * 32;
+    // the capacity is a power of two between MIN_CAPACITY and
+    // MAX_CAPACITY
+    if (minCapacity > MAX_CAPACITY)
+    {
+      minCapacity = MAX_CAPACITY;
+    }
+    capacity = MIN_CAPACITY;
+    while (capacity < minCapacity)
+    {
+      capacity <<= 1;
+    }
     buffer = new unsigned char[capacity];
   }
 
+public:
+  Pipe(const Pipe& other) = delete;
+
+public:
+  Pipe& operator=(const Pipe& other) = delete;
+
 public:
   ~Pipe()
   {
@@ -51,30 +83,35 @@ public:
   void Close() noexcept
   {
     done = true;
-    readCondition.notify_one();
-    writeCondition.notify_one();
+    WakeUp(readerSleeping);
+    WakeUp(writerSleeping);
   }
 
 public:
   void Write(const void* data, size_t count)
   {
-    std::unique_lock<std::mutex> lock(mut);
+    size_t tail = this->tail.load(std::memory_order_relaxed);
     size_t written = 0;
     while (written < count)
     {
-      writeCondition.wait(lock, [this] { return done || CanWrite(); });
+      size_t size = 0;
+      WaitUntil(writerSleeping, [this, tail, &size] {
+        size = tail - head.load(std::memory_order_acquire);
+        return done || size < capacity;
+      });
       if (done)
       {
         throw MiKTeX::Core::BrokenPipeException();
       }
       size_t n = std::min(count - written, capacity - size);
-      size_t num1 = std::min(n, capacity - tail);
+      size_t pos = tail & (capacity - 1);
+      size_t num1 = std::min(n, capacity - pos);
       size_t num2 = n - num1;
-      memcpy(buffer + tail, (unsigned char *)data + written, num1);
-      memcpy(buffer, (unsigned char *)data + written + num1, num2);
-      tail = (tail + n) % capacity;
-      size += n;
-      readCondition.notify_one();
+      memcpy(buffer + pos, (const unsigned char*)data + written, num1);
+      memcpy(buffer, (const unsigned char*)data + written + num1, num2);
+      tail += n;
+      this->tail.store(tail, std::memory_order_release);
+      WakeUp(readerSleeping);
       written += n;
     }
   }
@@ -82,69 +119,96 @@ public:
 public:
   size_t Read(void* data, size_t count)
   {
-    std::unique_lock<std::mutex> lock(mut);
+    size_t head = this->head.load(std::memory_order_relaxed);
     size_t read = 0;
-    bool noMore = false;
-    while (read < count && !noMore)
+    while (read < count)
     {
-      readCondition.wait(lock, [this] { return done || CanRead(); });
+      bool noMore = false;
+      size_t size = 0;
+      WaitUntil(readerSleeping, [this, head, &size, &noMore] {
+        // load done before tail: all data written before Close() is then visible
+        noMore = done;
+        size = this->tail.load(std::memory_order_acquire) - head;
+        return noMore || size > 0;
+      });
+      if (size == 0)
+      {
+        break;
+      }
       size_t n = std::min(count - read, size);
-      size_t num1 = std::min(n, capacity - head);
+      size_t pos = head & (capacity - 1);
+      size_t num1 = std::min(n, capacity - pos);
       size_t num2 = n - num1;
-      memcpy((unsigned char *)data + read, buffer + head, num1);
-      memcpy((unsigned char *)data + read + num1, buffer, num2);
-      head = (head + n) % capacity;
-      size -= n;
-      writeCondition.notify_one();
+      memcpy((unsigned char*)data + read, buffer + pos, num1);
+      memcpy((unsigned char*)data + read + num1, buffer, num2);
+      head += n;
+      this->head.store(head, std::memory_order_release);
+      WakeUp(writerSleeping);
       read += n;
-      noMore = done;
     }
     return read;
   }
 
-#if 0
 private:
-  void Resize(size_t newCapacity)
+  template<typename Predicate> void WaitUntil(std::atomic_bool& sleeping, Predicate ready)
   {
-    if (done || newCapacity <= capacity)
+    for (int spin = 0; spin < SPIN_COUNT; ++spin)
     {
-      return;
+      if (ready())
+      {
+        return;
+      }
+      std::this_thread::yield();
     }
-    unsigned char* newBuffer = new unsigned char[newCapacity];
-    size_t size = GetSize();
-    size_t num1 = min(size, capacity - head);
-    size_t num2 = size - num1;
-    memcpy(newBuffer, buffer + head, num1);
-    memcpy(newBuffer + num1, buffer, num2);
-    delete[] buffer;
-    buffer = newBuffer;
-    head = 0;
-    tail = size;
+    std::unique_lock<std::mutex> lock(mut);
+    sleeping.store(true, std::memory_order_relaxed);
+    // pairs with the fence in WakeUp(): either the other side sees
+    // the flag or we see its progress
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    condition.wait(lock, ready);
+    sleeping.store(false, std::memory_order_relaxed);
   }
-#endif
 
 private:
-  bool CanWrite() const
+  void WakeUp(std::atomic_bool& sleeping) noexcept
   {
-    return size < capacity;
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleeping.load(std::memory_order_relaxed))
+    {
+      std::lock_guard<std::mutex> lock(mut);
+      condition.notify_all();
+    }
   }
 
 private:
-  bool CanRead() const
-  {
-    return size > 0;
-  }
+  static constexpr int SPIN_COUNT = 100;
 
 private:
   size_t capacity = 0;
-  size_t size = 0;
-  size_t head = 0;
-  size_t tail = 0;
-  std::atomic_bool done{ false };
+
+private:
   unsigned char* buffer = nullptr;
+
+private:
+  std::atomic_bool done{ false };
+
+private:
+  std::atomic_size_t head{ 0 };
+
+private:
+  std::atomic_size_t tail{ 0 };
+
+private:
+  std::atomic_bool readerSleeping{ false };
+
+private:
+  std::atomic_bool writerSleeping{ false };
+
+private:
   std::mutex mut;
-  std::condition_variable writeCondition;
-  std::condition_variable readCondition;
+
+private:
+  std::condition_variable condition;
 };
 
 #if defined(_MSC_VER)
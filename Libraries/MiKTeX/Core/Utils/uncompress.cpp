@@ -34,38 +34,42 @@ using namespace std;
 
 using namespace MiKTeX::Core;
 
-void Utils::UncompressFile(const PathName& pathIn, PathName& pathOut)
+unique_ptr<Stream> Utils::OpenCompressedFile(const PathName& path)
 {
-  SessionImpl::GetSession()->trace_process->WriteFormattedLine("core", T_("uncompressing %s..."), Q_(pathIn));
-  if (!File::Exists(pathIn))
+  if (path.HasExtension(".gz"))
   {
-    MIKTEX_FATAL_ERROR_2(T_("The file could not be found."), "path", pathIn.ToString());
+    return GzipStream::Create(path, true);
   }
-  PathName pathTempFileName;
-  pathTempFileName.SetToTempFile();
-  FileStream stream(File::Open(pathTempFileName, FileMode::Create, FileAccess::Write, false));
-  unique_ptr<Stream> inputStream;
-  if (pathIn.HasExtension(".gz"))
+  else if (path.HasExtension(".bz2"))
   {
-    inputStream = GzipStream::Create(pathIn, true);
+    return BZip2Stream::Create(path, true);
   }
-  else if (pathIn.HasExtension(".bz2"))
+  else if (path.HasExtension(".lzma") || path.HasExtension(".xz"))
   {
-    inputStream = BZip2Stream::Create(pathIn, true);
+    return LzmaStream::Create(path, true);
   }
-  else if (pathIn.HasExtension(".lzma") || pathIn.HasExtension(".xz"))
+  else
   {
-    inputStream = LzmaStream::Create(pathIn, true);
+    MIKTEX_FATAL_ERROR_2(T_("Could not uncompress file."), "path", path.ToString());
   }
-  else
+}
+
+void Utils::UncompressFile(const PathName& pathIn, PathName& pathOut)
+{
+  SessionImpl::GetSession()->trace_process->WriteFormattedLine("core", T_("uncompressing %s..."), Q_(pathIn));
+  if (!File::Exists(pathIn))
   {
-    MIKTEX_FATAL_ERROR_2(T_("Could not uncompress file."), "path", pathIn.ToString());
+    MIKTEX_FATAL_ERROR_2(T_("The file could not be found."), "path", pathIn.ToString());
   }
-  unsigned char buf[4096];
+  unique_ptr<Stream> inputStream = OpenCompressedFile(pathIn);
+  PathName pathTempFileName;
+  pathTempFileName.SetToTempFile();
+  FileStream stream(File::Open(pathTempFileName, FileMode::Create, FileAccess::Write, false));
+  vector<unsigned char> buf(1024 * 64);
   size_t len;
-  while ((len = inputStream->Read(buf, ARRAY_SIZE(buf))) > 0)
+  while ((len = inputStream->Read(buf.data(), buf.size())) > 0)
   {
-    stream.Write(buf, len);
+    stream.Write(buf.data(), len);
   }
   pathOut = pathTempFileName;
 }
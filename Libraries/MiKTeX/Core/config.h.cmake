@@ -24,7 +24,9 @@
 #cmakedefine HAVE_ATLBASE_H 1
 #cmakedefine HAVE_DIRENT_H 1
 #cmakedefine HAVE_INTTYPES_H 1
+#cmakedefine HAVE_LINUX_FS_H 1
 #cmakedefine HAVE_SYS_MMAN_H 1
+#cmakedefine HAVE_SYS_SENDFILE_H 1
 #cmakedefine HAVE_SYS_STATVFS_H 1
 #cmakedefine HAVE_SYS_STAT_H 1
 #cmakedefine HAVE_SYS_TIME_H 1
@@ -36,7 +38,10 @@
 
 #cmakedefine HAVE_CHOWN 1
 #cmakedefine HAVE_CONFSTR 1
+#cmakedefine HAVE_COPY_FILE_RANGE 1
+#cmakedefine HAVE_FOPENCOOKIE 1
 #cmakedefine HAVE_FORK 1
+#cmakedefine HAVE_FUNOPEN 1
 #cmakedefine HAVE_FUTIMES 1
 #cmakedefine HAVE_MMAP 1
 #cmakedefine HAVE_STATVFS 1
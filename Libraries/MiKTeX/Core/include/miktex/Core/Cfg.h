@@ -344,6 +344,17 @@ public:
   /// @eturn Returns the number of sections.  
 public:
   virtual std::size_t GetSize() const = 0;
+
+  /// @brief Reads from an INI text file through a binary snapshot.
+  ///
+  /// The snapshot holds the parser output of the INI file (and of the
+  /// files it includes). It is used as long as these files are
+  /// unchanged; otherwise the INI file is parsed and a new snapshot
+  /// is written. Signed INI files are always parsed.
+  /// @param path The path to the INI file.
+  /// @param snapshotDirectory The directory which holds the snapshot files.
+public:
+  virtual void MIKTEXTHISCALL ReadWithSnapshot(const PathName& path, const PathName& snapshotDirectory) = 0;
 };
 
 MIKTEX_CORE_END_NAMESPACE;
@@ -36,13 +36,21 @@ constexpr auto MIKTEX_CONFIG_VALUE_ALTEXTENSIONS = "${MIKTEX_CONFIG_VALUE_ALTEXT
 constexpr auto MIKTEX_CONFIG_VALUE_AUTOADMIN = "${MIKTEX_CONFIG_VALUE_AUTOADMIN}";
 constexpr auto MIKTEX_CONFIG_VALUE_AUTOINSTALL = "${MIKTEX_CONFIG_VALUE_AUTOINSTALL}";
 constexpr auto MIKTEX_CONFIG_VALUE_COMMONLINKTARGETDIRECTORY = "${MIKTEX_CONFIG_VALUE_COMMONLINKTARGETDIRECTORY}";
+constexpr auto MIKTEX_CONFIG_VALUE_COMPRESSMEMORYDUMPFILES = "${MIKTEX_CONFIG_VALUE_COMPRESSMEMORYDUMPFILES}";
 constexpr auto MIKTEX_CONFIG_VALUE_CREATEAUXDIRECTORY = "${MIKTEX_CONFIG_VALUE_CREATEAUXDIRECTORY}";
 constexpr auto MIKTEX_CONFIG_VALUE_CREATEOUTPUTDIRECTORY = "${MIKTEX_CONFIG_VALUE_CREATEOUTPUTDIRECTORY}";
 constexpr auto MIKTEX_CONFIG_VALUE_CSTYLEERRORS = "${MIKTEX_CONFIG_VALUE_CSTYLEERRORS}";
+constexpr auto MIKTEX_CONFIG_VALUE_DECOMPRESSIONBUFFERSIZE = "${MIKTEX_CONFIG_VALUE_DECOMPRESSIONBUFFERSIZE}";
 constexpr auto MIKTEX_CONFIG_VALUE_ENVVARS = "${MIKTEX_CONFIG_VALUE_ENVVARS}";
 constexpr auto MIKTEX_CONFIG_VALUE_EXTENSIONS = "${MIKTEX_CONFIG_VALUE_EXTENSIONS}";
+constexpr auto MIKTEX_CONFIG_VALUE_FINDFILECACHE = "${MIKTEX_CONFIG_VALUE_FINDFILECACHE}";
+constexpr auto MIKTEX_CONFIG_VALUE_FNDBCOMPACTIONTHRESHOLD = "${MIKTEX_CONFIG_VALUE_FNDBCOMPACTIONTHRESHOLD}";
+constexpr auto MIKTEX_CONFIG_VALUE_FNDBREVALIDATIONINTERVAL = "${MIKTEX_CONFIG_VALUE_FNDBREVALIDATIONINTERVAL}";
+constexpr auto MIKTEX_CONFIG_VALUE_FNDBSCANTHREADS = "${MIKTEX_CONFIG_VALUE_FNDBSCANTHREADS}";
+constexpr auto MIKTEX_CONFIG_VALUE_MAXPARALLELDOWNLOADS = "${MIKTEX_CONFIG_VALUE_MAXPARALLELDOWNLOADS}";
 constexpr auto MIKTEX_CONFIG_VALUE_PATHS = "${MIKTEX_CONFIG_VALUE_PATHS}";
 constexpr auto MIKTEX_CONFIG_VALUE_SHELLCOMMANDMODE = "${MIKTEX_CONFIG_VALUE_SHELLCOMMANDMODE}";
+constexpr auto MIKTEX_CONFIG_VALUE_SYNCDECOMPRESSIONTHRESHOLD = "${MIKTEX_CONFIG_VALUE_SYNCDECOMPRESSIONTHRESHOLD}";
 constexpr auto MIKTEX_CONFIG_VALUE_USERLINKTARGETDIRECTORY = "${MIKTEX_CONFIG_VALUE_USERLINKTARGETDIRECTORY}";
 
 #endif
@@ -117,6 +117,15 @@ public:
 public:
   static MIKTEXCORECEEAPI(void) SetTimes(const PathName& path, time_t creationTime, time_t lastAccessTime, time_t lastWriteTime);
 
+  /// Writes the directory entries to the storage device.
+  ///
+  /// This makes files created, renamed or removed in the directory
+  /// durable. It has no effect on Windows, where directory entries
+  /// cannot be synced.
+  /// @param path The file system path to the directory.
+public:
+  static MIKTEXCORECEEAPI(void) Sync(const PathName& path);
+
   /// Renames (moves) a directory.
   /// @param source The file system path to the source directory.
   /// @param dest The file system path to the destination directory.
@@ -40,6 +40,7 @@
 #define MIKTEX_ENV_PACKAGE_LIST_FILE MIKTEX_ENV_PREFIX_ "PKGLISTFILE"
 #define MIKTEX_ENV_REPOSITORY MIKTEX_ENV_PREFIX_ "REPOSITORY"
 #define MIKTEX_ENV_TRACE MIKTEX_ENV_PREFIX_ "TRACE"
+#define MIKTEX_ENV_TRACE_DUMP_FILE MIKTEX_ENV_PREFIX_ "TRACEDUMPFILE"
 #define MIKTEX_ENV_USER_CONFIG MIKTEX_ENV_PREFIX_ "USERCONFIG"
 #define MIKTEX_ENV_USER_DATA MIKTEX_ENV_PREFIX_ "USERDATA"
 #define MIKTEX_ENV_USER_INSTALL MIKTEX_ENV_PREFIX_ "USERINSTALL"
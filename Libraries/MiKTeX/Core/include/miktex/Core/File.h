@@ -262,6 +262,33 @@ public:
     Copy(source, dest, { FileCopyOption::ReplaceExisting });
   }
 
+  /// Copies data from one open file to another.
+  ///
+  /// If the operating system supports it, the data is copied by the
+  /// kernel (`copy_file_range()`, `sendfile()`). Otherwise, large
+  /// buffered reads and writes are used.
+  /// @param source The source stream. Data is read from the current position.
+  /// @param dest The destination stream. Data is written at the current position.
+  /// @param count The number of bytes to be copied.
+  /// @return Returns the number of bytes copied. This is less than
+  /// `count`, if the end of the source file has been reached.
+public:
+  static MIKTEXCORECEEAPI(std::size_t) CopyData(FILE* source, FILE* dest, std::size_t count);
+
+  /// Writes buffered data of a file to the storage device.
+  ///
+  /// The stream is flushed, and the operating system is asked to
+  /// write the file data (`fsync()`, `FlushFileBuffers()`).
+  /// @param file The pointer to a `FILE` object.
+public:
+  static MIKTEXCORECEEAPI(void) Sync(FILE* file);
+
+  /// Changes the size of an open file.
+  /// @param file The pointer to a `FILE` object.
+  /// @param size The new size (in bytes) of the file.
+public:
+  static MIKTEXCORECEEAPI(void) SetSize(FILE* file, std::size_t size);
+
   /// Creates a file system link.
   /// @param oldName The file system path to the existing file.
   /// @param newName The file system path to link.
@@ -75,6 +75,9 @@ public:
 public:
   static MIKTEXCORECEEAPI(bool) Create(const PathName& fndbPath, const PathName& rootPath, ICreateFndbCallback* callback, bool enableStringPooling, bool storeFileNameInfo);
 
+public:
+  static MIKTEXCORECEEAPI(bool) Update(const PathName& fndbPath, const PathName& rootPath, ICreateFndbCallback* callback);
+
 public:
   static MIKTEXCORECEEAPI(bool) Search(const PathName& fileName, const std::string& pathPattern, bool firstMatchOnly, std::vector<Record>& result);
 
@@ -87,6 +90,17 @@ public:
 public:
   static MIKTEXCORECEEAPI(bool) FileExists(const PathName& path);
 
+  // Add() and Remove() calls between BeginTransaction() and
+  // CommitTransaction() are visible to this process immediately but
+  // are written to the change files only when the transaction is
+  // committed (one locked append and one sync per FNDB).
+  // Transactions can be nested.
+public:
+  static MIKTEXCORECEEAPI(void) BeginTransaction();
+
+public:
+  static MIKTEXCORECEEAPI(void) CommitTransaction();
+
 public:
   static MIKTEXCORECEEAPI(bool) Refresh(const PathName& path, ICreateFndbCallback* callback);
 
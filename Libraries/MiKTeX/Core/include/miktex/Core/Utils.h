@@ -33,6 +33,7 @@
 
 #include <algorithm>
 #include <exception>
+#include <memory>
 #include <string>
 #include <utility>
 
@@ -43,6 +44,7 @@
 MIKTEX_CORE_BEGIN_NAMESPACE;
 
 class PathName;
+class Stream;
 
 /// Information about an entry in a font map file.
 struct FontMapEntry
@@ -132,6 +134,12 @@ public:
 public:
   static MIKTEXCORECEEAPI(void) UncompressFile(const PathName& pathIn, PathName& pathOut);
 
+  /// Opens a compressed file (.gz, .bz2, .lzma or .xz) for reading.
+  /// @param path The path name of the compressed file.
+  /// @return Returns a stream which delivers the uncompressed data.
+public:
+  static MIKTEXCORECEEAPI(std::unique_ptr<Stream>) OpenCompressedFile(const PathName& path);
+
 public:
   // FIXME: bad interface
   static MIKTEXCORECEEAPI(const char*) GetRelativizedPath(const char* lpszPath, const char* lpszRoot);
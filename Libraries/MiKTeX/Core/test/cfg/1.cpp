@@ -23,10 +23,14 @@
 
 #include <miktex/Core/Test>
 
+#include <ctime>
+
 #include <memory>
 #include <string>
 
 #include <miktex/Core/Cfg>
+#include <miktex/Core/File>
+#include <miktex/Core/MD5>
 #include <miktex/Core/StreamWriter>
 
 using namespace MiKTeX::Core;
@@ -173,6 +177,60 @@ BEGIN_TEST_FUNCTION(8);
 }
 END_TEST_FUNCTION();
 
+BEGIN_TEST_FUNCTION(9);
+{
+  StreamWriter writer("test3.ini");
+  writer.WriteLine("[sec1]");
+  writer.WriteLine("arr[]=abc");
+  writer.WriteLine("arr[]=def");
+  writer.WriteLine("path=a");
+  writer.WriteLine("path;=b");
+  writer.WriteLine("!include test3inc.ini");
+  writer.WriteLine("[sec2]");
+  writer.WriteLine("foo=bar");
+  writer.Close();
+  StreamWriter writer2("test3inc.ini");
+  writer2.WriteLine("inc=included");
+  writer2.WriteLine("!clear arr[]");
+  writer2.Close();
+  PathName snapshotDir = PathName().SetToCurrentDirectory() / "snapshots";
+  PathName snapshotFile = snapshotDir / ("cfg-" + MD5::FromChars(PathName("test3.ini").MakeAbsolute().ToString()).ToString() + ".snapshot");
+  // files which have just been written are not snapshotted
+  {
+    shared_ptr<Cfg> cfg;
+    TESTX(cfg = Cfg::Create());
+    TESTX(cfg->ReadWithSnapshot("test3.ini", snapshotDir));
+    TEST(cfg->GetValue("sec1", "inc")->AsString() == "included");
+    TEST(!File::Exists(snapshotFile));
+  }
+  time_t past = time(nullptr) - 60;
+  TESTX(File::SetTimes("test3.ini", past, past, past));
+  TESTX(File::SetTimes("test3inc.ini", past, past, past));
+  for (int n = 0; n < 2; ++n)
+  {
+    shared_ptr<Cfg> cfg;
+    TESTX(cfg = Cfg::Create());
+    TESTX(cfg->ReadWithSnapshot("test3.ini", snapshotDir));
+    vector<string> arr;
+    TEST(cfg->TryGetValueAsStringVector("sec1", "arr[]", arr));
+    TEST(arr.empty());
+    TEST(cfg->GetValue("sec1", "path")->AsString() == string("a") + PathName::PathNameDelimiter + "b");
+    TEST(cfg->GetValue("sec1", "inc")->AsString() == "included");
+    TEST(cfg->GetValue("sec2", "foo")->AsString() == "bar");
+    TEST(File::Exists(snapshotFile));
+  }
+  // same size: only the time stamp tells the difference
+  StreamWriter writer3("test3inc.ini");
+  writer3.WriteLine("inc=changed!");
+  writer3.WriteLine("!clear arr[]");
+  writer3.Close();
+  shared_ptr<Cfg> cfg;
+  TESTX(cfg = Cfg::Create());
+  TESTX(cfg->ReadWithSnapshot("test3.ini", snapshotDir));
+  TEST(cfg->GetValue("sec1", "inc")->AsString() == "changed!");
+}
+END_TEST_FUNCTION();
+
 BEGIN_TEST_PROGRAM();
 {
   CALL_TEST_FUNCTION(1);
@@ -183,6 +241,7 @@ BEGIN_TEST_PROGRAM();
   CALL_TEST_FUNCTION(6);
   CALL_TEST_FUNCTION(7);
   CALL_TEST_FUNCTION(8);
+  CALL_TEST_FUNCTION(9);
 }
 END_TEST_PROGRAM();
 
@@ -23,6 +23,8 @@
 
 #include <miktex/Core/Test>
 
+#include <vector>
+
 #include <miktex/Core/File>
 #include <miktex/Core/FileStream>
 
@@ -61,10 +63,41 @@ BEGIN_TEST_FUNCTION(2);
 }
 END_TEST_FUNCTION();
 
+BEGIN_TEST_FUNCTION(3);
+{
+  vector<unsigned char> data(3 * 1024 * 1024 + 17);
+  for (size_t idx = 0; idx < data.size(); ++idx)
+  {
+    data[idx] = static_cast<unsigned char>(idx * 7 + idx / 4099);
+  }
+  TESTX(File::WriteBytes("copy.src", data));
+  TESTX(File::Copy("copy.src", "copy.dst"));
+  TEST(File::ReadAllBytes("copy.dst") == data);
+  // copy a range between buffered streams
+  FileStream source(File::Open("copy.src", FileMode::Open, FileAccess::Read, false));
+  FileStream dest(File::Open("copy.dst", FileMode::Create, FileAccess::Write, false));
+  unsigned char head[100];
+  TEST(source.Read(head, sizeof(head)) == sizeof(head));
+  dest.Write(head, 10);
+  TEST(File::CopyData(source.GetFile(), dest.GetFile(), 1000000) == 1000000);
+  TEST(source.Read(head, 1) == 1 && head[0] == data[100 + 1000000]);
+  dest.Write(head, 1);
+  TEST(File::CopyData(source.GetFile(), dest.GetFile(), data.size()) == data.size() - 100 - 1000000 - 1);
+  source.Close();
+  dest.Close();
+  vector<unsigned char> expected(data.begin(), data.begin() + 10);
+  expected.insert(expected.end(), data.begin() + 100, data.end());
+  TEST(File::ReadAllBytes("copy.dst") == expected);
+  File::Delete("copy.src");
+  File::Delete("copy.dst");
+}
+END_TEST_FUNCTION();
+
 BEGIN_TEST_PROGRAM();
 {
   CALL_TEST_FUNCTION(1);
   CALL_TEST_FUNCTION(2);
+  CALL_TEST_FUNCTION(3);
 }
 END_TEST_PROGRAM();
 
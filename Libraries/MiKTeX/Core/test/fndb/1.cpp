@@ -31,6 +31,7 @@
 #include <miktex/Core/Fndb>
 #include <miktex/Core/PathName>
 #include <miktex/Core/Paths>
+#include <miktex/Core/Utils>
 #include <miktex/Util/StringUtil>
 
 using namespace MiKTeX::Core;
@@ -106,11 +107,108 @@ BEGIN_TEST_FUNCTION(3);
 }
 END_TEST_FUNCTION();
 
+BEGIN_TEST_FUNCTION(4);
+{
+  PathName path = pSession->GetSpecialPath(SpecialPath::InstallRoot) / "abrakadabra" / "hi.txt";
+  TEST(Fndb::FileExists(path));
+  TESTX(Fndb::Remove({ path }));
+  TEST(!Fndb::FileExists(path));
+  PathName path2 = pSession->GetSpecialPath(SpecialPath::InstallRoot) / "jk" / "lm" / "no" / "xxx" / "xyz.txt";
+  TEST(Fndb::FileExists(path2));
+  TESTX(Fndb::Remove({ path2 }));
+  TESTX(pSession->UnloadFilenameDatabase());
+  TEST(!Fndb::FileExists(path2));
+  vector<PathName> paths;
+  TEST(pSession->FindFile("xyz.txt", StringUtil::Flatten({ "%R/ab//", "%R/jk//" }, PathName::PathNameDelimiter), paths));
+  TEST(paths.size() == 1);
+  TESTX(Fndb::Add({ {path2} }));
+  TEST(Fndb::FileExists(path2));
+}
+END_TEST_FUNCTION();
+
+BEGIN_TEST_FUNCTION(5);
+{
+  Utils::SetEnvironmentString("MIKTEX_CORE_FNDBCOMPACTIONTHRESHOLD", "1");
+  TESTX(pSession->UnloadFilenameDatabase());
+  PathName installRoot = pSession->GetSpecialPath(SpecialPath::InstallRoot);
+  PathName path = installRoot / "abrakadabra" / "simsalabim.txt";
+  TESTX(Fndb::Add({ {path} }));
+  PathName changeFile = pSession->GetFilenameDatabasePathName(pSession->DeriveTEXMFRoot(installRoot));
+  changeFile.SetExtension(MIKTEX_FNDB_CHANGE_FILE_SUFFIX);
+  TEST(!File::Exists(changeFile) || File::GetSize(changeFile) == 0);
+  TEST(Fndb::FileExists(path));
+  TESTX(pSession->UnloadFilenameDatabase());
+  TEST(Fndb::FileExists(path));
+  TEST(Fndb::FileExists(installRoot / "jk" / "lm" / "no" / "xxx" / "xyz.txt"));
+  TEST(!Fndb::FileExists(installRoot / "abrakadabra" / "hi.txt"));
+}
+END_TEST_FUNCTION();
+
+BEGIN_TEST_FUNCTION(6);
+{
+  PathName installRoot = pSession->GetSpecialPath(SpecialPath::InstallRoot);
+  PathName fndbPath = pSession->GetFilenameDatabasePathName(pSession->DeriveTEXMFRoot(installRoot));
+  Utils::SetEnvironmentString("MIKTEX_CORE_FNDBSCANTHREADS", "1");
+  TEST(Fndb::Create(fndbPath, installRoot, nullptr));
+  vector<unsigned char> serial = File::ReadAllBytes(fndbPath);
+  Utils::SetEnvironmentString("MIKTEX_CORE_FNDBSCANTHREADS", "8");
+  TEST(Fndb::Create(fndbPath, installRoot, nullptr));
+  vector<unsigned char> parallel = File::ReadAllBytes(fndbPath);
+  TEST(serial == parallel);
+}
+END_TEST_FUNCTION();
+
+BEGIN_TEST_FUNCTION(7);
+{
+  PathName installRoot = pSession->GetSpecialPath(SpecialPath::InstallRoot);
+  PathName fndbPath = pSession->GetFilenameDatabasePathName(pSession->DeriveTEXMFRoot(installRoot));
+  TEST(Fndb::Update(fndbPath, installRoot, nullptr));
+  TEST(Fndb::FileExists(installRoot / "jk" / "lm" / "no" / "xxx" / "xyz.txt"));
+  PathName newFile = installRoot / "jk" / "lm" / "no" / "xxx" / "new.txt";
+  TEST(!Fndb::FileExists(newFile));
+  File::WriteBytes(newFile, { 'x' });
+  TEST(Fndb::Update(fndbPath, installRoot, nullptr));
+  TEST(Fndb::FileExists(newFile));
+  TEST(Fndb::FileExists(installRoot / "jk" / "lm" / "no" / "xxx" / "xyz.txt"));
+}
+END_TEST_FUNCTION();
+
+BEGIN_TEST_FUNCTION(8);
+{
+  Utils::SetEnvironmentString("MIKTEX_CORE_FNDBCOMPACTIONTHRESHOLD", "1000");
+  TESTX(pSession->UnloadFilenameDatabase());
+  PathName installRoot = pSession->GetSpecialPath(SpecialPath::InstallRoot);
+  PathName changeFile = pSession->GetFilenameDatabasePathName(pSession->DeriveTEXMFRoot(installRoot));
+  changeFile.SetExtension(MIKTEX_FNDB_CHANGE_FILE_SUFFIX);
+  size_t changeFileSize = File::Exists(changeFile) ? File::GetSize(changeFile) : 0;
+  PathName path1 = installRoot / "abrakadabra" / "one.txt";
+  PathName path2 = installRoot / "abrakadabra" / "two.txt";
+  TESTX(Fndb::BeginTransaction());
+  TESTX(Fndb::Add({ {path1} }));
+  TESTX(Fndb::Add({ {path2} }));
+  TESTX(Fndb::Remove({ path1 }));
+  TEST(!Fndb::FileExists(path1));
+  TEST(Fndb::FileExists(path2));
+  TEST((File::Exists(changeFile) ? File::GetSize(changeFile) : 0) == changeFileSize);
+  TEST(!pSession->UnloadFilenameDatabase());
+  TESTX(Fndb::CommitTransaction());
+  TEST(File::GetSize(changeFile) > changeFileSize);
+  TEST(pSession->UnloadFilenameDatabase());
+  TEST(!Fndb::FileExists(path1));
+  TEST(Fndb::FileExists(path2));
+}
+END_TEST_FUNCTION();
+
 BEGIN_TEST_PROGRAM();
 {
   CALL_TEST_FUNCTION(1);
   CALL_TEST_FUNCTION(2);
   CALL_TEST_FUNCTION(3);
+  CALL_TEST_FUNCTION(4);
+  CALL_TEST_FUNCTION(5);
+  CALL_TEST_FUNCTION(6);
+  CALL_TEST_FUNCTION(7);
+  CALL_TEST_FUNCTION(8);
 }
 END_TEST_PROGRAM();
 
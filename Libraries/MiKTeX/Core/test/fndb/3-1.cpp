@@ -0,0 +1,63 @@
+/* 3-1.cpp:
+
+   Copyright (C) 2019 Christian Schenk
+
+   This file is part of the MiKTeX Core Library.
+
+   The MiKTeX Core Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+
+   The MiKTeX Core Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with the MiKTeX Core Library; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#include "config.h"
+
+#include <miktex/Core/Test>
+
+#include <miktex/Core/Fndb>
+#include <miktex/Core/PathName>
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Test;
+using namespace std;
+
+BEGIN_TEST_SCRIPT("fndb-3-1");
+
+// arguments: { add|remove PATH }
+BEGIN_TEST_FUNCTION(1);
+{
+  TEST(vecArgs.size() % 2 == 0);
+  for (size_t idx = 0; idx < vecArgs.size(); idx += 2)
+  {
+    PathName path(vecArgs[idx + 1]);
+    if (vecArgs[idx] == "add")
+    {
+      TESTX(Fndb::Add({ {path} }));
+    }
+    else
+    {
+      TEST(vecArgs[idx] == "remove");
+      TESTX(Fndb::Remove({ path }));
+    }
+  }
+}
+END_TEST_FUNCTION();
+
+BEGIN_TEST_PROGRAM();
+{
+  CALL_TEST_FUNCTION(1);
+}
+END_TEST_PROGRAM();
+
+END_TEST_SCRIPT();
+
+RUN_TEST_SCRIPT();
@@ -0,0 +1,122 @@
+/* 3.cpp:
+
+   Copyright (C) 2019 Christian Schenk
+
+   This file is part of the MiKTeX Core Library.
+
+   The MiKTeX Core Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+
+   The MiKTeX Core Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with the MiKTeX Core Library; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#include "config.h"
+
+#include <miktex/Core/Test>
+
+#include <string>
+#include <vector>
+
+#include <miktex/Core/File>
+#include <miktex/Core/Fndb>
+#include <miktex/Core/PathName>
+#include <miktex/Core/Process>
+#include <miktex/Core/Utils>
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Test;
+using namespace std;
+
+BEGIN_TEST_SCRIPT("fndb-3");
+
+// lets another process add/remove FNDB records
+bool RunOtherProcess(const vector<string>& changes)
+{
+  PathName pathExe = pSession->GetMyLocation(false);
+  pathExe /= "core_fndb_test3-1" MIKTEX_EXE_FILE_SUFFIX;
+  vector<string> arguments{ pathExe.ToString() };
+  arguments.insert(arguments.end(), changes.begin(), changes.end());
+  int exitCode;
+  return Process::Run(pathExe, arguments, nullptr, &exitCode, nullptr) && exitCode == 0;
+}
+
+size_t CountRecords(const PathName& path)
+{
+  vector<Fndb::Record> result;
+  Fndb::Search(path.GetFileName(), path.GetDirectoryName().ToString(), false, result);
+  return result.size();
+}
+
+BEGIN_TEST_FUNCTION(1);
+{
+  // this process must not notice the changes of the other process
+  // before it commits its own changes
+  Utils::SetEnvironmentString("MIKTEX_CORE_FNDBREVALIDATIONINTERVAL", "3600000");
+  PathName installRoot = pSession->GetSpecialPath(SpecialPath::InstallRoot);
+  PathName fndbPath = pSession->GetFilenameDatabasePathName(pSession->DeriveTEXMFRoot(installRoot));
+  TEST(Fndb::Create(fndbPath, installRoot, nullptr));
+  TESTX(pSession->UnloadFilenameDatabase());
+}
+END_TEST_FUNCTION();
+
+BEGIN_TEST_FUNCTION(2);
+{
+  PathName installRoot = pSession->GetSpecialPath(SpecialPath::InstallRoot);
+  PathName path1 = installRoot / "interleave" / "one.txt";
+  PathName path2 = installRoot / "interleave" / "two.txt";
+  TESTX(Fndb::Add({ {path1} }));
+  TEST(Fndb::FileExists(path1));
+  TEST(RunOtherProcess({ "remove", path1.ToString(), "add", path2.ToString() }));
+  TESTX(Fndb::Remove({ path1 }));
+  TEST(!Fndb::FileExists(path1));
+  TESTX(Fndb::Add({ {path2} }));
+  TEST(CountRecords(path2) == 1);
+  TESTX(pSession->UnloadFilenameDatabase());
+  TEST(!Fndb::FileExists(path1));
+  TEST(CountRecords(path2) == 1);
+}
+END_TEST_FUNCTION();
+
+BEGIN_TEST_FUNCTION(3);
+{
+  PathName installRoot = pSession->GetSpecialPath(SpecialPath::InstallRoot);
+  PathName path2 = installRoot / "interleave" / "two.txt";
+  PathName path3 = installRoot / "interleave" / "three.txt";
+  PathName path4 = installRoot / "interleave" / "four.txt";
+  TEST(Fndb::FileExists(path2));
+  TESTX(Fndb::BeginTransaction());
+  TESTX(Fndb::Remove({ path2 }));
+  TESTX(Fndb::Add({ {path3} }));
+  TESTX(Fndb::Add({ {path4} }));
+  TEST(RunOtherProcess({ "remove", path2.ToString(), "add", path3.ToString(), "add", path4.ToString(), "remove", path4.ToString() }));
+  TESTX(Fndb::CommitTransaction());
+  TEST(!Fndb::FileExists(path2));
+  TEST(CountRecords(path3) == 1);
+  TEST(CountRecords(path4) == 1);
+  TESTX(pSession->UnloadFilenameDatabase());
+  TEST(!Fndb::FileExists(path2));
+  TEST(CountRecords(path3) == 1);
+  TEST(CountRecords(path4) == 1);
+}
+END_TEST_FUNCTION();
+
+BEGIN_TEST_PROGRAM();
+{
+  CALL_TEST_FUNCTION(1);
+  CALL_TEST_FUNCTION(2);
+  CALL_TEST_FUNCTION(3);
+}
+END_TEST_PROGRAM();
+
+END_TEST_SCRIPT();
+
+RUN_TEST_SCRIPT();
@@ -0,0 +1,153 @@
+/* 4.cpp:
+
+   Copyright (C) 2019 Christian Schenk
+
+   This file is part of the MiKTeX Core Library.
+
+   The MiKTeX Core Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+
+   The MiKTeX Core Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with the MiKTeX Core Library; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#include "config.h"
+
+#include <miktex/Core/Test>
+
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <miktex/Core/Directory>
+#include <miktex/Core/DirectoryLister>
+#include <miktex/Core/File>
+#include <miktex/Core/Fndb>
+#include <miktex/Core/PathName>
+#include <miktex/Core/Paths>
+#include <miktex/Core/Utils>
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Test;
+using namespace std;
+
+BEGIN_TEST_SCRIPT("fndb-4");
+
+vector<PathName> GetCacheFiles()
+{
+  vector<PathName> result;
+  PathName directory = pSession->GetSpecialPath(SpecialPath::UserDataRoot) / MIKTEX_PATH_FNDB_DIR;
+  if (!Directory::Exists(directory))
+  {
+    return result;
+  }
+  unique_ptr<DirectoryLister> lister = DirectoryLister::Open(directory, "findfile-*.cache");
+  DirectoryEntry entry;
+  while (lister->GetNext(entry))
+  {
+    result.push_back(directory / entry.name);
+  }
+  lister->Close();
+  return result;
+}
+
+size_t CountLines(const PathName& path)
+{
+  ifstream reader = File::CreateInputStream(path);
+  size_t count = 0;
+  for (string line; getline(reader, line); )
+  {
+    count++;
+  }
+  return count;
+}
+
+BEGIN_TEST_FUNCTION(1);
+{
+  Utils::SetEnvironmentString("MIKTEX_CORE_FINDFILECACHE", "true");
+  // check the FNDB generation on every search
+  Utils::SetEnvironmentString("MIKTEX_CORE_FNDBREVALIDATIONINTERVAL", "0");
+  PathName installRoot = pSession->GetSpecialPath(SpecialPath::InstallRoot);
+  PathName fndbPath = pSession->GetFilenameDatabasePathName(pSession->DeriveTEXMFRoot(installRoot));
+  TEST(Fndb::Create(fndbPath, installRoot, nullptr));
+  TESTX(pSession->UnloadFilenameDatabase());
+  for (const PathName& path : GetCacheFiles())
+  {
+    TESTX(File::Delete(path));
+  }
+}
+END_TEST_FUNCTION();
+
+BEGIN_TEST_FUNCTION(2);
+{
+  // hit: the search result is stored once
+  PathName path;
+  for (int n = 0; n < 3; ++n)
+  {
+    TEST(pSession->FindFile("test.tex", FileType::TEX, path));
+    TEST(PathName(path.GetFileName()) == PathName("test.tex"));
+  }
+  vector<PathName> cacheFiles = GetCacheFiles();
+  TEST(cacheFiles.size() == 1);
+  TEST(CountLines(cacheFiles[0]) == 1);
+}
+END_TEST_FUNCTION();
+
+BEGIN_TEST_FUNCTION(3);
+{
+  // miss: the negative search result is stored once
+  PathName path;
+  for (int n = 0; n < 3; ++n)
+  {
+    TEST(!pSession->FindFile("cached.tex", FileType::TEX, path));
+  }
+  vector<PathName> cacheFiles = GetCacheFiles();
+  TEST(cacheFiles.size() == 1);
+  TEST(CountLines(cacheFiles[0]) == 2);
+}
+END_TEST_FUNCTION();
+
+BEGIN_TEST_FUNCTION(4);
+{
+  // invalidation: a new FNDB generation starts with a new cache file;
+  // the time stamps must differ
+  this_thread::sleep_for(chrono::milliseconds(1100));
+  PathName installRoot = pSession->GetSpecialPath(SpecialPath::InstallRoot);
+  PathName newFile = installRoot / "tex" / "test" / "base" / "cached.tex";
+  Touch(newFile);
+  TESTX(Fndb::Add({ {newFile} }));
+  PathName path;
+  TEST(pSession->FindFile("cached.tex", FileType::TEX, path));
+  TEST(PathName(path.GetFileName()) == PathName("cached.tex"));
+  // the cache file of the old generation has been removed
+  vector<PathName> cacheFiles = GetCacheFiles();
+  TEST(cacheFiles.size() == 1);
+  TEST(CountLines(cacheFiles[0]) == 1);
+  TESTX(Fndb::Remove({ newFile }));
+  TESTX(File::Delete(newFile));
+}
+END_TEST_FUNCTION();
+
+BEGIN_TEST_PROGRAM();
+{
+  CALL_TEST_FUNCTION(1);
+  CALL_TEST_FUNCTION(2);
+  CALL_TEST_FUNCTION(3);
+  CALL_TEST_FUNCTION(4);
+}
+END_TEST_PROGRAM();
+
+END_TEST_SCRIPT();
+
+RUN_TEST_SCRIPT();
@@ -259,6 +259,36 @@ BEGIN_TEST_FUNCTION(13);
 }
 END_TEST_FUNCTION();
 
+BEGIN_TEST_FUNCTION(14);
+{
+  static_assert(std::is_nothrow_move_constructible<PathName>::value, "PathName must be nothrow move constructible");
+  PathName small("/abc/def");
+  PathName small2(small);
+  TEST(small2 == "/abc/def");
+  PathName small3(std::move(small2));
+  TEST(small3 == "/abc/def");
+  TEST(small2.Empty());
+  string s(2 * BufferSizes::MaxPath, 'x');
+  PathName large(s);
+  TEST(large.GetCapacity() > BufferSizes::MaxPath);
+  PathName large2(large);
+  TEST(large2.ToString() == s);
+  const char* data = large2.GetData();
+  PathName large3(std::move(large2));
+  TEST(large3.GetData() == data);
+  TEST(large3.ToString() == s);
+  TEST(large2.Empty());
+  large3 = small;
+  TEST(large3 == "/abc/def");
+  vector<PathName> vec;
+  for (int i = 0; i < 100; ++i)
+  {
+    vec.push_back(PathName(std::to_string(i)));
+  }
+  TEST(vec[42] == "42");
+}
+END_TEST_FUNCTION();
+
 BEGIN_TEST_PROGRAM();
 {
   CALL_TEST_FUNCTION(1);
@@ -274,6 +304,7 @@ BEGIN_TEST_PROGRAM();
   CALL_TEST_FUNCTION(11);
   CALL_TEST_FUNCTION(12);
   CALL_TEST_FUNCTION(13);
+  CALL_TEST_FUNCTION(14);
 }
 END_TEST_PROGRAM();
 
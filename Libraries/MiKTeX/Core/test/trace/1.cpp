@@ -0,0 +1,157 @@
+/* 1.cpp:
+
+   Copyright (C) 2019 Christian Schenk
+
+   This file is part of the MiKTeX Core Library.
+
+   The MiKTeX Core Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+
+   The MiKTeX Core Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with the MiKTeX Core Library; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#include "config.h"
+
+#include <miktex/Core/Test>
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <miktex/Core/File>
+#include <miktex/Core/PathName>
+#include <miktex/Core/Process>
+#include <miktex/Trace/TraceCallback>
+#include <miktex/Trace/TraceStream>
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Test;
+using namespace MiKTeX::Trace;
+using namespace std;
+
+BEGIN_TEST_SCRIPT("trace-1");
+
+const size_t BUFFER_SIZE = 4096;
+
+const int NUM_MESSAGES = 1000;
+
+class CountingCallback :
+  public TraceCallback
+{
+public:
+  void MIKTEXTHISCALL Trace(const TraceMessage& traceMessage) override
+  {
+    count++;
+  }
+public:
+  int count = 0;
+};
+
+// reads the messages of the trace stream "ringbuffer" from a dump file
+bool ReadDump(const PathName& dumpFile, vector<string>& messages)
+{
+  vector<unsigned char> dump = File::ReadAllBytes(dumpFile);
+  if (dump.size() < 16 || memcmp(dump.data(), "MIKTEXTRACERING1", 16) != 0)
+  {
+    return false;
+  }
+  size_t pos = 16;
+  while (pos < dump.size())
+  {
+    uint64_t header[3];
+    if (pos + sizeof(header) > dump.size())
+    {
+      return false;
+    }
+    memcpy(header, &dump[pos], sizeof(header));
+    pos += sizeof(header);
+    uint64_t size = header[0];
+    uint64_t oldest = header[1];
+    uint64_t written = header[2];
+    if (size == 0 || pos + size > dump.size() || oldest > written || written - oldest > size)
+    {
+      return false;
+    }
+    const unsigned char* data = &dump[pos];
+    auto copyOut = [data, size](uint64_t at, uint64_t count) {
+      string s;
+      for (uint64_t i = 0; i < count; ++i)
+      {
+        s += static_cast<char>(data[(at + i) % size]);
+      }
+      return s;
+    };
+    for (uint64_t at = oldest; at < written; )
+    {
+      string recordHeader = copyOut(at, 14);
+      uint32_t length;
+      memcpy(&length, recordHeader.data(), 4);
+      uint8_t nameLength = recordHeader[12];
+      uint8_t facilityLength = recordHeader[13];
+      if (length < 14u + nameLength + facilityLength || at + length > written)
+      {
+        return false;
+      }
+      string name = copyOut(at + 14, nameLength);
+      if (name == "ringbuffer")
+      {
+        messages.push_back(copyOut(at + 14 + nameLength + facilityLength, length - 14 - nameLength - facilityLength));
+      }
+      at += length;
+    }
+    pos += size;
+  }
+  return true;
+}
+
+BEGIN_TEST_FUNCTION(1);
+{
+  TraceStream::SetOptions(vector<string>{ "ringbuffer" });
+  TraceStream::EnableRingBuffer("trace-1.dump", BUFFER_SIZE);
+  CountingCallback callback;
+  unique_ptr<TraceStream> trace = TraceStream::Open("ringbuffer", &callback);
+  for (int i = 0; i < NUM_MESSAGES; ++i)
+  {
+    trace->WriteLine("test", std::to_string(i));
+  }
+  // trace callbacks are still called
+  TEST(callback.count == NUM_MESSAGES);
+  trace->Close();
+  TraceStream::DumpRingBuffer();
+  PathName dumpFile("trace-1.dump." + std::to_string(Process::GetCurrentProcess()->GetSystemId()));
+  TEST(File::Exists(dumpFile));
+  vector<string> messages;
+  TEST(ReadDump(dumpFile, messages));
+  // the buffer has wrapped: only the most recent messages are left
+  TEST(!messages.empty());
+  TEST(messages.size() < static_cast<size_t>(NUM_MESSAGES));
+  TEST(messages.back() == std::to_string(NUM_MESSAGES - 1));
+  int first = std::stoi(messages.front());
+  for (size_t idx = 0; idx < messages.size(); ++idx)
+  {
+    TEST(messages[idx] == std::to_string(first + idx));
+  }
+  File::Delete(dumpFile);
+}
+END_TEST_FUNCTION();
+
+BEGIN_TEST_PROGRAM();
+{
+  CALL_TEST_FUNCTION(1);
+}
+END_TEST_PROGRAM();
+
+END_TEST_SCRIPT();
+
+RUN_TEST_SCRIPT();
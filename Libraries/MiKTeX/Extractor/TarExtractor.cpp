@@ -309,6 +309,10 @@ void TarExtractor::Extract(Stream* streamIn_, const PathName& destDir, bool make
     streamIn = streamIn_;
     totalBytesRead = 0;
 
+    // file data can be copied without reading it, if the archive is
+    // not compressed
+    fileStreamIn = dynamic_cast<FileStream*>(streamIn);
+
     traceStream->WriteLine(TRACE_FACILITY, fmt::format(T_("extracting to {0} ({1})"), Q_(destDir), (makeDirectories ? T_("make directories") : T_("don't make directories"))));
 
     size_t len;
@@ -408,6 +412,15 @@ void TarExtractor::Extract(Stream* streamIn_, const PathName& destDir, bool make
       // extract the file
       FileStream streamOut(File::Open(path, FileMode::Create, FileAccess::Write, false));
       size_t bytesRead = 0;
+      if (fileStreamIn != nullptr)
+      {
+        bytesRead = File::CopyData(fileStreamIn->GetFile(), streamOut.GetFile(), size);
+        totalBytesRead += bytesRead;
+        if (bytesRead != size)
+        {
+          MIKTEX_UNEXPECTED();
+        }
+      }
       while (bytesRead < size)
       {
         size_t remaining = size - bytesRead;
@@ -24,6 +24,7 @@
 #if !defined(BF702FE409EC4B9592640F4FD967F75B)
 #define BF702FE409EC4B9592640F4FD967F75B
 
+#include <miktex/Core/FileStream>
 #include <miktex/Trace/TraceStream>
 
 #include "miktex/Extractor/Extractor"
@@ -73,6 +74,10 @@ protected:
 protected:
   MiKTeX::Core::Stream* streamIn = nullptr;
 
+  // streamIn, if it is a FileStream
+protected:
+  MiKTeX::Core::FileStream* fileStreamIn = nullptr;
+
 protected:
   void Skip(size_t bytes);
 
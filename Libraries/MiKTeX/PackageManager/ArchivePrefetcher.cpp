@@ -0,0 +1,192 @@
+/* ArchivePrefetcher.cpp: get archive files ready for installation
+
+   Copyright (C) 2019 Christian Schenk
+
+   This file is part of MiKTeX Package Manager.
+
+   MiKTeX Package Manager is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+
+   MiKTeX Package Manager is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with MiKTeX Package Manager; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#include "config.h"
+
+#include <chrono>
+
+#include <miktex/Core/Exceptions>
+#include <miktex/Core/File>
+#include <miktex/Core/FileStream>
+
+#include "internal.h"
+
+#include "ArchivePrefetcher.h"
+
+using namespace std;
+using namespace std::chrono_literals;
+
+using namespace MiKTeX::Core;
+
+using namespace MiKTeX::Packages::D6AAD62216146D44B580E92711724B78;
+
+ArchivePrefetcher::ArchivePrefetcher(vector<Job>&& jobs, unsigned numThreads, vector<shared_ptr<WebSession>>&& webSessions, ProgressCallback onProgress) :
+  jobs(std::move(jobs)),
+  promises(this->jobs.size()),
+  maxAhead(2 * static_cast<size_t>(numThreads)),
+  webSessions(std::move(webSessions)),
+  onProgress(onProgress)
+{
+  MIKTEX_ASSERT(numThreads > 0);
+  MIKTEX_ASSERT(this->webSessions.empty() || this->webSessions.size() >= numThreads);
+  for (size_t idx = 0; idx < this->jobs.size(); ++idx)
+  {
+    futures.push_back(promises[idx].get_future());
+    pending[this->jobs[idx].packageId] = idx;
+  }
+  numThreads = static_cast<unsigned>(std::min(static_cast<size_t>(numThreads), this->jobs.size()));
+  for (unsigned n = 0; n < numThreads; ++n)
+  {
+    // a web session cannot be shared between threads
+    WebSession* webSession = this->webSessions.empty() ? nullptr : this->webSessions[n].get();
+    threads.push_back(thread(&ArchivePrefetcher::WorkerThread, this, webSession));
+  }
+}
+
+ArchivePrefetcher::~ArchivePrefetcher()
+{
+  try
+  {
+    Stop();
+  }
+  catch (const exception&)
+  {
+  }
+}
+
+bool ArchivePrefetcher::IsPending(const string& packageId)
+{
+  lock_guard<mutex> lockGuard(mut);
+  return pending.find(packageId) != pending.end();
+}
+
+unique_ptr<ArchivePrefetcher::Archive> ArchivePrefetcher::PickUp(const string& packageId)
+{
+  size_t idx;
+  {
+    lock_guard<mutex> lockGuard(mut);
+    auto it = pending.find(packageId);
+    if (it == pending.end())
+    {
+      MIKTEX_UNEXPECTED();
+    }
+    idx = it->second;
+    pending.erase(it);
+    // make room for the next jobs; the picked up job is always within
+    // the window, even if archive files are picked up out of order
+    pickedUp = std::max(pickedUp, idx + 1);
+  }
+  cond.notify_all();
+  while (futures[idx].wait_for(200ms) != future_status::ready)
+  {
+    onProgress();
+  }
+  onProgress();
+  return futures[idx].get();
+}
+
+void ArchivePrefetcher::Stop()
+{
+  stopping = true;
+  cond.notify_all();
+  for (thread& t : threads)
+  {
+    if (t.joinable())
+    {
+      t.join();
+    }
+  }
+  threads.clear();
+  for (shared_ptr<WebSession>& webSession : webSessions)
+  {
+    webSession->Dispose();
+  }
+  webSessions.clear();
+}
+
+void ArchivePrefetcher::WorkerThread(WebSession* webSession)
+{
+  while (true)
+  {
+    size_t idx;
+    {
+      unique_lock<mutex> lock(mut);
+      cond.wait(lock, [this]() { return stopping || next >= jobs.size() || next < pickedUp + maxAhead; });
+      if (stopping || next >= jobs.size())
+      {
+        break;
+      }
+      idx = next++;
+    }
+    try
+    {
+      promises[idx].set_value(Prefetch(jobs[idx], webSession));
+    }
+    catch (...)
+    {
+      promises[idx].set_exception(current_exception());
+    }
+  }
+}
+
+unique_ptr<ArchivePrefetcher::Archive> ArchivePrefetcher::Prefetch(Job& job, WebSession* webSession)
+{
+  unique_ptr<Archive> archive = make_unique<Archive>();
+  archive->path = job.path;
+  archive->temporaryFile = std::move(job.temporaryFile);
+  if (!job.url.empty())
+  {
+    MIKTEX_ASSERT(webSession != nullptr);
+    Download(job.url, archive->path, webSession, *archive);
+  }
+  archive->exists = File::Exists(archive->path);
+  if (archive->exists)
+  {
+    archive->digest = MD5::FromFile(archive->path);
+  }
+  return archive;
+}
+
+void ArchivePrefetcher::Download(const string& url, const PathName& dest, WebSession* webSession, Archive& archive)
+{
+  unique_ptr<WebFile> webFile(webSession->OpenUrl(url));
+  FileStream destStream(File::Open(dest, FileMode::Create, FileAccess::Write, false));
+  // remove the partially downloaded file on error
+  unique_ptr<TemporaryFile> downloadedFile = TemporaryFile::Create(dest);
+  const size_t bufsize = 32 * 1024;
+  unique_ptr<char[]> buf(new char[bufsize]);
+  size_t n;
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  while ((n = webFile->Read(buf.get(), bufsize)) > 0)
+  {
+    if (stopping)
+    {
+      throw OperationCancelledException();
+    }
+    destStream.Write(buf.get(), n);
+    archive.received += n;
+    bytesReceived += n;
+  }
+  destStream.Close();
+  webFile->Close();
+  archive.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+  downloadedFile->Keep();
+}
@@ -0,0 +1,195 @@
+/* ArchivePrefetcher.h:                                 -*- C++ -*-
+
+   Copyright (C) 2019 Christian Schenk
+
+   This file is part of MiKTeX Package Manager.
+
+   MiKTeX Package Manager is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+
+   MiKTeX Package Manager is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with MiKTeX Package Manager; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#pragma once
+
+#if !defined(D3A4D1F0B6C94E2E8F2C9A6B7E5D4C31)
+#define D3A4D1F0B6C94E2E8F2C9A6B7E5D4C31
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <miktex/Core/MD5>
+#include <miktex/Core/PathName>
+#include <miktex/Core/TemporaryFile>
+
+#include "WebSession.h"
+
+MPM_INTERNAL_BEGIN_NAMESPACE;
+
+/// @brief Gets package archive files ready for installation.
+///
+/// A bounded pool of threads downloads (remote repository) the
+/// archive files and calculates their digests in the order in which
+/// the packages will be processed. The installer picks them up one by
+/// one; the pool stays at most a few archive files ahead of the
+/// installer.
+///
+/// The worker threads neither use the MiKTeX session nor call back
+/// into the installer: web sessions and temporary files are created
+/// by the installer thread; the progress is reported on the thread
+/// which waits in `PickUp()`.
+class ArchivePrefetcher
+{
+public:
+  /// @brief An archive file to be prefetched.
+  struct Job
+  {
+    /// The package ID.
+    std::string packageId;
+    /// The download URL; empty, if the archive file is a local file.
+    std::string url;
+    /// The local archive file; if `url` is not empty: the download
+    /// destination.
+    MiKTeX::Core::PathName path;
+    /// The temporary download destination, if any (handed over to
+    /// the archive).
+    std::unique_ptr<MiKTeX::Core::TemporaryFile> temporaryFile;
+  };
+
+public:
+  /// @brief A prefetched archive file.
+  struct Archive
+  {
+    /// The path to the archive file.
+    MiKTeX::Core::PathName path;
+    /// The downloaded temporary file (removed when the archive is
+    /// destroyed).
+    std::unique_ptr<MiKTeX::Core::TemporaryFile> temporaryFile;
+    /// Indicates whether the archive file exists.
+    bool exists = false;
+    /// The MD5 digest of the archive file, if it exists.
+    MiKTeX::Core::MD5 digest;
+    /// The number of bytes downloaded.
+    std::size_t received = 0;
+    /// The download time (in seconds).
+    double seconds = 0;
+  };
+
+public:
+  typedef std::function<void()> ProgressCallback;
+
+  /// @brief Starts the worker threads.
+  /// @param jobs The archive files to be prefetched.
+  /// @param numThreads The number of worker threads.
+  /// @param webSessions One initialized web session per worker
+  /// thread; empty, if no archive file has to be downloaded.
+  /// @param onProgress Called periodically by `PickUp()`.
+public:
+  ArchivePrefetcher(std::vector<Job>&& jobs, unsigned numThreads, std::vector<std::shared_ptr<WebSession>>&& webSessions, ProgressCallback onProgress);
+
+public:
+  ArchivePrefetcher(const ArchivePrefetcher& other) = delete;
+
+public:
+  ArchivePrefetcher& operator=(const ArchivePrefetcher& other) = delete;
+
+public:
+  virtual ~ArchivePrefetcher();
+
+  /// @brief Checks whether an archive file is being prefetched.
+  /// @param packageId The package ID.
+  /// @return Returns `true`, if the archive file has not been picked up yet.
+public:
+  bool IsPending(const std::string& packageId);
+
+  /// @brief Waits for an archive file and picks it up.
+  ///
+  /// Exceptions thrown while preparing the archive file are rethrown.
+  /// @param packageId The package ID.
+  /// @return Returns the archive file.
+public:
+  std::unique_ptr<Archive> PickUp(const std::string& packageId);
+
+  /// Cancels downloads in progress and waits for the worker threads.
+public:
+  void Stop();
+
+  /// @brief Gets the number of bytes downloaded so far by all worker threads.
+public:
+  std::size_t GetBytesReceived() const
+  {
+    return bytesReceived;
+  }
+
+private:
+  void WorkerThread(WebSession* webSession);
+
+private:
+  std::unique_ptr<Archive> Prefetch(Job& job, WebSession* webSession);
+
+private:
+  void Download(const std::string& url, const MiKTeX::Core::PathName& dest, WebSession* webSession, Archive& archive);
+
+private:
+  std::vector<Job> jobs;
+
+private:
+  std::vector<std::promise<std::unique_ptr<Archive>>> promises;
+
+private:
+  std::vector<std::future<std::unique_ptr<Archive>>> futures;
+
+private:
+  std::unordered_map<std::string, std::size_t> pending;
+
+private:
+  std::size_t next = 0;
+
+private:
+  std::size_t pickedUp = 0;
+
+private:
+  std::size_t maxAhead;
+
+private:
+  std::atomic_bool stopping{ false };
+
+private:
+  std::atomic_size_t bytesReceived{ 0 };
+
+private:
+  std::mutex mut;
+
+private:
+  std::condition_variable cond;
+
+private:
+  std::vector<std::thread> threads;
+
+private:
+  std::vector<std::shared_ptr<WebSession>> webSessions;
+
+private:
+  ProgressCallback onProgress;
+};
+
+MPM_INTERNAL_END_NAMESPACE;
+
+#endif
@@ -110,6 +110,11 @@ string BuildUserAgentString()
 
 void CurlWebSession::Initialize()
 {
+  if (pCurl != nullptr)
+  {
+    return;
+  }
+
   curlVersionInfo = curl_version_info(CURLVERSION_NOW);
 
   trace_curl->WriteFormattedLine(TRACE_FACILITY, T_("initializing cURL library version %s"), curlVersionInfo->version);
@@ -177,8 +177,8 @@ public:
 public:
   void SetCustomHeaders(const std::unordered_map<std::string, std::string>& headers) override;
 
-private:
-  void Initialize();
+public:
+  void Initialize() override;
 
 private:
   static int ProgressCallback(void* pv, double dltotal, double dlnow, double ultotal, double ulnow);
@@ -0,0 +1,179 @@
+/* FileDigestCache.cpp: remember file digests
+
+   Copyright (C) 2019 Christian Schenk
+
+   This file is part of MiKTeX Package Manager.
+
+   MiKTeX Package Manager is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+
+   MiKTeX Package Manager is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with MiKTeX Package Manager; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#include "config.h"
+
+#if defined(MIKTEX_UNIX)
+#include <sys/stat.h>
+#endif
+
+#include <cstdlib>
+#include <ctime>
+
+#include <fstream>
+
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+
+#include <miktex/Core/Directory>
+#include <miktex/Core/Exceptions>
+#include <miktex/Core/File>
+#include <miktex/Util/StringUtil>
+
+#include "internal.h"
+
+#include "FileDigestCache.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Trace;
+using namespace MiKTeX::Util;
+
+using namespace MiKTeX::Packages::D6AAD62216146D44B580E92711724B78;
+
+FileDigestCache::FileDigestCache(const PathName& cacheFile, TraceStream* trace) :
+  cacheFile(cacheFile),
+  trace(trace)
+{
+}
+
+FileDigestCache::FileStamp FileDigestCache::GetFileStamp(const PathName& path)
+{
+  FileStamp stamp;
+#if defined(MIKTEX_UNIX)
+  struct stat statbuf;
+  if (stat(path.GetData(), &statbuf) != 0)
+  {
+    MIKTEX_FATAL_CRT_ERROR_2("stat", "path", path.ToString());
+  }
+  stamp.inode = statbuf.st_ino;
+  stamp.size = statbuf.st_size;
+  stamp.lastWriteTime = statbuf.st_mtime;
+#else
+  stamp.size = File::GetSize(path);
+  stamp.lastWriteTime = File::GetLastWriteTime(path);
+#endif
+  return stamp;
+}
+
+MD5 FileDigestCache::GetDigest(const PathName& path)
+{
+  string key = path.ToString();
+  FileStamp stamp = GetFileStamp(path);
+  {
+    lock_guard<mutex> lockGuard(mut);
+    if (!loaded)
+    {
+      Load();
+    }
+    auto it = entries.find(key);
+    if (it != entries.end() && it->second.stamp == stamp)
+    {
+      return it->second.digest;
+    }
+  }
+  MD5 digest = MD5::FromFile(path);
+  // a file which has just been written might be changed again without
+  // changing its size and last write time
+  if (stamp.lastWriteTime < static_cast<int64_t>(time(nullptr)) - 1)
+  {
+    lock_guard<mutex> lockGuard(mut);
+    Entry& entry = entries[key];
+    entry.stamp = stamp;
+    entry.digest = digest;
+    modified = true;
+  }
+  return digest;
+}
+
+void FileDigestCache::Load()
+{
+  loaded = true;
+  entries.clear();
+  if (!File::Exists(cacheFile))
+  {
+    return;
+  }
+  try
+  {
+    ifstream reader = File::CreateInputStream(cacheFile);
+    // inode TAB size TAB lastWriteTime TAB digest TAB path
+    for (string line; std::getline(reader, line); )
+    {
+      vector<string> fields = StringUtil::Split(line, '\t');
+      if (fields.size() != 5 || fields[3].length() != 32)
+      {
+        continue;
+      }
+      Entry entry;
+      entry.stamp.inode = std::strtoull(fields[0].c_str(), nullptr, 10);
+      entry.stamp.size = std::strtoull(fields[1].c_str(), nullptr, 10);
+      entry.stamp.lastWriteTime = std::strtoll(fields[2].c_str(), nullptr, 10);
+      entry.digest = MD5::Parse(fields[3]);
+      entries[fields[4]] = entry;
+    }
+    reader.close();
+    trace->WriteLine(TRACE_FACILITY, fmt::format(T_("loaded {0} entries from file digest cache {1}"), entries.size(), Q_(cacheFile)));
+  }
+  catch (const exception&)
+  {
+    entries.clear();
+  }
+}
+
+void FileDigestCache::Save()
+{
+  lock_guard<mutex> lockGuard(mut);
+  if (!modified)
+  {
+    return;
+  }
+  // other processes might be reading the existing cache file
+  try
+  {
+    PathName dir(cacheFile);
+    dir.RemoveFileSpec();
+    if (!Directory::Exists(dir))
+    {
+      Directory::Create(dir);
+    }
+    PathName tempFile;
+    tempFile.SetToTempFile(dir);
+    ofstream writer = File::CreateOutputStream(tempFile);
+    for (const auto& kv : entries)
+    {
+      writer
+        << kv.second.stamp.inode << '\t'
+        << kv.second.stamp.size << '\t'
+        << kv.second.stamp.lastWriteTime << '\t'
+        << kv.second.digest.ToString() << '\t'
+        << kv.first << '\n';
+    }
+    writer.close();
+    File::Move(tempFile, cacheFile, { FileMoveOption::ReplaceExisting });
+    modified = false;
+  }
+  catch (const MiKTeXException& e)
+  {
+    trace->WriteLine(TRACE_FACILITY, fmt::format(T_("file digest cache {0} cannot be written: {1}"), Q_(cacheFile), e.GetErrorMessage()));
+  }
+}
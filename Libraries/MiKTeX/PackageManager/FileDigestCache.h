@@ -0,0 +1,110 @@
+/* FileDigestCache.h:                                   -*- C++ -*-
+
+   Copyright (C) 2019 Christian Schenk
+
+   This file is part of MiKTeX Package Manager.
+
+   MiKTeX Package Manager is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+
+   MiKTeX Package Manager is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with MiKTeX Package Manager; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#pragma once
+
+#if !defined(E2B7C9D14A6F4C3B8E0D5A1F7C2B9E64)
+#define E2B7C9D14A6F4C3B8E0D5A1F7C2B9E64
+
+#include <cstdint>
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <miktex/Core/MD5>
+#include <miktex/Core/PathName>
+
+#include <miktex/Trace/TraceStream>
+
+MPM_INTERNAL_BEGIN_NAMESPACE;
+
+/// @brief Remembers the MD5 digests of files.
+///
+/// A cached digest is used as long as the file identity (inode, if
+/// available), the size and the last write time of the file are
+/// unchanged. The cache is kept in a text file; methods can be called
+/// from multiple threads.
+class FileDigestCache
+{
+public:
+  FileDigestCache(const MiKTeX::Core::PathName& cacheFile, MiKTeX::Trace::TraceStream* trace);
+
+  /// @brief Gets the digest of a file.
+  ///
+  /// The file is digested, if the cached digest (if any) is outdated.
+  /// @param path The path to the file.
+  /// @return Returns the MD5 digest.
+public:
+  MiKTeX::Core::MD5 GetDigest(const MiKTeX::Core::PathName& path);
+
+  /// Writes the cache file, if new digests have been calculated.
+public:
+  void Save();
+
+private:
+  struct FileStamp
+  {
+    std::uint64_t inode = 0;
+    std::uint64_t size = 0;
+    std::int64_t lastWriteTime = 0;
+    bool operator==(const FileStamp& rhs) const
+    {
+      return inode == rhs.inode && size == rhs.size && lastWriteTime == rhs.lastWriteTime;
+    }
+  };
+
+private:
+  struct Entry
+  {
+    FileStamp stamp;
+    MiKTeX::Core::MD5 digest;
+  };
+
+private:
+  static FileStamp GetFileStamp(const MiKTeX::Core::PathName& path);
+
+private:
+  void Load();
+
+private:
+  MiKTeX::Core::PathName cacheFile;
+
+private:
+  MiKTeX::Trace::TraceStream* trace;
+
+private:
+  std::mutex mut;
+
+private:
+  std::unordered_map<std::string, Entry> entries;
+
+private:
+  bool loaded = false;
+
+private:
+  bool modified = false;
+};
+
+MPM_INTERNAL_END_NAMESPACE;
+
+#endif
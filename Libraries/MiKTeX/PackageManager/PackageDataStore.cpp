@@ -64,10 +64,11 @@ void PackageDataStore::LoadAllPackageManifests(const PathName& packageManifestsP
     return;
   }
 
-  unique_ptr<Cfg> cfg = Cfg::Create();
-  cfg->Read(packageManifestsPath);
+  // the INI file is not ours (e.g., it has been extracted into a
+  // temporary directory): compile it into memory
+  Load(packageManifestsPath, false);
 
-  Load(*cfg);
+  LoadPackageManifests();
 
   loadedAllPackageManifests = true;
 }
@@ -80,6 +81,8 @@ void PackageDataStore::SaveVarData()
 void PackageDataStore::Clear()
 {
   packageTable.clear();
+  undecodedFiles.clear();
+  manifestsDbs.clear();
   installedFileInfoTable.clear();
   loadedAllPackageManifests = false;
   comboCfg.Clear();
@@ -95,6 +98,7 @@ tuple<bool, PackageInfo> PackageDataStore::TryGetPackage(const string& packageId
   }
   else
   {
+    NeedFiles(it->second);
     return make_tuple(true, it->second);
   }
 }
@@ -135,13 +139,13 @@ void PackageDataStore::SetReleaseState(const string& packageId, RepositoryReleas
 PackageDataStore::iterator PackageDataStore::begin()
 {
   Load();
-  return iterator(packageTable.begin());
+  return iterator(this, packageTable.begin());
 }
 
 PackageDataStore::iterator PackageDataStore::end()
 {
   Load();
-  return iterator(packageTable.end());
+  return iterator(this, packageTable.end());
 }
 
 void PackageDataStore::DefinePackage(const PackageInfo& packageInfo)
@@ -230,6 +234,7 @@ void PackageDataStore::NeedPackageManifestsIni()
       count++;
     }
     cfgExisting->Write(existingPackageManifestsIni);
+    PackageManifestsDb::Invalidate(existingPackageManifestsIni);
     trace_mpm->WriteLine(TRACE_FACILITY, fmt::format("successfully migrated {} package manifest files", count));
   }
 }
@@ -243,58 +248,67 @@ void PackageDataStore::Load()
   }
   unique_ptr<StopWatch> stopWatch = StopWatch::Start(trace_stopwatch.get(), TRACE_FACILITY, "loading all package manifests");
   NeedPackageManifestsIni();
-  unique_ptr<Cfg> cfg = Cfg::Create();
   if (!session->IsAdminMode())
   {
     PathName userPath = session->GetSpecialPath(SpecialPath::UserInstallRoot) / MIKTEX_PATH_PACKAGE_MANIFESTS_INI;
     if (File::Exists(userPath))
     {
-      cfg->Read(userPath);
+      Load(userPath, true);
     }
   }
   PathName commonPath = session->GetSpecialPath(SpecialPath::CommonInstallRoot) / MIKTEX_PATH_PACKAGE_MANIFESTS_INI;
   if ((session->IsAdminMode() || session->GetSpecialPath(SpecialPath::UserInstallRoot).Canonicalize() != session->GetSpecialPath(SpecialPath::CommonInstallRoot).Canonicalize()) && File::Exists(commonPath))
   {
-    cfg->SetOptions({ Cfg::Option::NoOverwriteKeys });
-    cfg->Read(commonPath);
+    Load(commonPath, true);
   }
-  Load(*cfg);
+  LoadPackageManifests();
   loadedAllPackageManifests = true;
 }
 
-void PackageDataStore::Load(Cfg& cfg)
+void PackageDataStore::Load(const PathName& packageManifestsPath, bool persistent)
+{
+  manifestsDbs.push_back(PackageManifestsDb::Open(packageManifestsPath, persistent, trace_mpm.get()));
+}
+
+void PackageDataStore::LoadPackageManifests()
 {
   unsigned count = 0;
-  for (const auto& key : cfg)
+  for (const auto& db : manifestsDbs)
   {
-    // ignore redefinition
-    if (packageTable.find(key->GetName()) != packageTable.end())
+    for (size_t idx = 0; idx < db->GetSize(); ++idx)
     {
-      continue;
-    }
+      // ignore redefinition
+      if (packageTable.find(db->GetPackageId(idx)) != packageTable.end())
+      {
+        continue;
+      }
 
-    PackageInfo packageInfo = PackageManager::GetPackageManifest(cfg, key->GetName(), TEXMF_PREFIX_DIRECTORY);
+      // the file lists are decoded on demand
+      PackageInfo packageInfo = db->GetPackage(idx, false);
 
 #if IGNORE_OTHER_SYSTEMS
-    string targetSystems = packageInfo.targetSystem;
-    if (targetSystems != "" && !StringUtil::Contains(targetSystems.c_str(), MIKTEX_SYSTEM_TAG))
-    {
-      trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("{0}: ignoring {1} package"), packageInfo.id, targetSystems));
-      continue;
-    }
+      string targetSystems = packageInfo.targetSystem;
+      if (targetSystems != "" && !StringUtil::Contains(targetSystems.c_str(), MIKTEX_SYSTEM_TAG))
+      {
+        trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("{0}: ignoring {1} package"), packageInfo.id, targetSystems));
+        continue;
+      }
 #endif
 
-    count += 1;
+      count += 1;
 
-    // insert into database
-    DefinePackage(packageInfo);
+      // insert into database
+      DefinePackage(packageInfo);
+      undecodedFiles[packageInfo.id] = { db.get(), idx };
 
-    // increment file ref counts, if package is installed
-    if (packageInfo.IsInstalled())
-    {
-      IncrementFileRefCounts(packageInfo.runFiles);
-      IncrementFileRefCounts(packageInfo.docFiles);
-      IncrementFileRefCounts(packageInfo.sourceFiles);
+      // increment file ref counts, if package is installed
+      if (packageInfo.IsInstalled())
+      {
+        db->GetFiles(idx, packageInfo);
+        IncrementFileRefCounts(packageInfo.runFiles);
+        IncrementFileRefCounts(packageInfo.docFiles);
+        IncrementFileRefCounts(packageInfo.sourceFiles);
+      }
     }
   }
 
@@ -329,6 +343,8 @@ void PackageDataStore::Load(Cfg& cfg)
     }
     if (timeInstalledMin > 0)
     {
+      // pure containers are recognized by their file lists
+      NeedFiles(pkg);
       if (pkg.IsPureContainer() || (pkg.IsInstalled() && pkg.timeInstalled < timeInstalledMax))
       {
         pkg.timeInstalled = timeInstalledMax;
@@ -396,9 +412,24 @@ PackageInfo& PackageDataStore::operator[](const string& packageId)
   {
     MIKTEX_FATAL_ERROR_2(T_("The requested package is unknown."), "name", packageId);
   }
+  NeedFiles(it->second);
   return it->second;
 }
 
+void PackageDataStore::NeedFiles(PackageInfo& packageInfo)
+{
+  if (undecodedFiles.empty())
+  {
+    return;
+  }
+  auto it = undecodedFiles.find(packageInfo.id);
+  if (it != undecodedFiles.end())
+  {
+    it->second.db->GetFiles(it->second.idx, packageInfo);
+    undecodedFiles.erase(it);
+  }
+}
+
 time_t PackageDataStore::GetUserTimeInstalled(const string& packageId)
 {
   LoadVarData();
@@ -30,6 +30,7 @@
 #include <string>
 #include <tuple>
 #include <unordered_map>
+#include <vector>
 
 #include <miktex/Core/PathName>
 #include <miktex/Core/Session>
@@ -40,6 +41,7 @@
 #include <miktex/PackageManager/PackageManager>
 
 #include "ComboCfg.h"
+#include "PackageManifestsDb.h"
 
 MPM_INTERNAL_BEGIN_NAMESPACE;
 
@@ -47,6 +49,7 @@ MPM_INTERNAL_BEGIN_NAMESPACE;
 ///
 /// The record data is retrieved from two sources:
 /// - `miktex/config/package-manifests.ini`: immutable package manifests
+///   (read through the compiled `miktex/config/package-manifests.db`)
 /// - `miktex/config/packages.ini`: mutable package data such as installation timestamps
 class PackageDataStore
 {
@@ -131,13 +134,15 @@ public:
   class iterator
   {
   public:
-    iterator(PackageDefinitionTable::iterator it) :
+    iterator(PackageDataStore* dataStore, PackageDefinitionTable::iterator it) :
+      dataStore(dataStore),
       it(it)
     {
     }
   public:
     MiKTeX::Packages::PackageInfo& operator*()
     {
+      dataStore->NeedFiles(it->second);
       return it->second;
     }
   public:
@@ -156,6 +161,8 @@ public:
     {
       return it != rhs.it;
     }
+  private:
+    PackageDataStore* dataStore;
   private:
     PackageDefinitionTable::iterator it;
   };
@@ -204,7 +211,13 @@ private:
   void Load();
 
 private:
-  void Load(MiKTeX::Core::Cfg& cfg);
+  void Load(const MiKTeX::Core::PathName& packageManifestsPath, bool persistent);
+
+private:
+  void LoadPackageManifests();
+
+private:
+  void NeedFiles(MiKTeX::Packages::PackageInfo& packageInfo);
 
 private:
   void LoadVarData();
@@ -248,6 +261,21 @@ private:
 private:
   ComboCfg comboCfg;
 
+  // compiled package manifests, in order of precedence
+private:
+  std::vector<std::unique_ptr<PackageManifestsDb>> manifestsDbs;
+
+private:
+  struct UndecodedFiles
+  {
+    const PackageManifestsDb* db;
+    std::size_t idx;
+  };
+
+  // packages whose file lists have not been decoded yet
+private:
+  std::unordered_map<std::string, UndecodedFiles, MiKTeX::Core::hash_icase, MiKTeX::Core::equal_icase> undecodedFiles;
+
 private:
   PackageDefinitionTable packageTable;
 
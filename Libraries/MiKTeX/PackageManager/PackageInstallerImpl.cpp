@@ -26,6 +26,7 @@
 #include <fmt/format.h>
 #include <fmt/ostream.h>
 
+#include <miktex/Core/ConfigNames>
 #include <miktex/Core/Directory>
 #include <miktex/Core/DirectoryLister>
 #include <miktex/Core/FileStream>
@@ -45,6 +46,7 @@
 
 #include "internal.h"
 #include "PackageInstallerImpl.h"
+#include "PackageManifestsDb.h"
 #include "TpmParser.h"
 
 using namespace std;
@@ -59,6 +61,8 @@ using namespace MiKTeX::Packages::D6AAD62216146D44B580E92711724B78;
 
 constexpr const char* LF = "\n";
 
+constexpr int DEFAULT_MAX_PARALLEL_DOWNLOADS = 4;
+
 template<typename T1, typename T2> double Divide(T1 a, T2 b)
 {
   return static_cast<double>(a) / static_cast<double>(b);
@@ -190,32 +194,19 @@ void PackageInstallerImpl::Download(const string& url, const PathName& dest, siz
   char buf[bufsize];
   size_t n;
   size_t received = 0;
-  clock_t start = clock();
-  clock_t start1 = start;
-  size_t received1 = 0;
+  // wall-clock time: archive files may be downloaded concurrently
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
   while ((n = webFile->Read(buf, sizeof(buf))) > 0)
   {
-    clock_t end1 = clock();
-
     destStream.Write(buf, n);
 
     received += n;
-    received1 += n;
 
     // update progress info
     {
       lock_guard<mutex> lockGuard(progressIndicatorMutex);
       progressInfo.cbPackageDownloadCompleted += n;
-      progressInfo.cbDownloadCompleted += n;
-      if (end1 > start1 + 1 * CLOCKS_PER_SEC)
-      {
-        progressInfo.bytesPerSecond = static_cast<unsigned long>(Divide(received1, Divide(end1 - start1, CLOCKS_PER_SEC)));
-        start1 = end1;
-        received1 = 0;
-      }
-      double timePassed = clock() - timeStarted;
-      double timeTotal = ((timePassed / progressInfo.cbDownloadCompleted) * progressInfo.cbDownloadTotal);
-      progressInfo.timeRemaining = static_cast<unsigned long>((timeTotal - timePassed) / CLOCKS_PER_SEC);
+      UpdateDownloadProgress(n);
     }
 
     Notify();
@@ -225,16 +216,9 @@ void PackageInstallerImpl::Download(const string& url, const PathName& dest, siz
   destStream.Close();
   webFile->Close();
 
-  clock_t end = clock();
-
-  if (start == end)
-  {
-    ++end;
-  }
-
   // report statistics
   double mb = Divide(received, 1000000);
-  double seconds = Divide(end - start, CLOCKS_PER_SEC);
+  double seconds = std::max(chrono::duration<double>(chrono::steady_clock::now() - start).count(), 0.001);
   trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("downloaded {0:.2f} MB in {1:.2f} seconds"), mb, seconds));
   ReportLine(fmt::format(T_("{0:.2f} MB, {1:.2f} Mbit/s"), mb, Divide(8 * mb, seconds)));
 
@@ -247,6 +231,28 @@ void PackageInstallerImpl::Download(const string& url, const PathName& dest, siz
   downloadedFile->Keep();
 }
 
+// accounts for n received bytes; the transfer rate is the rate of all
+// concurrent downloads; the caller holds progressIndicatorMutex
+void PackageInstallerImpl::UpdateDownloadProgress(size_t n)
+{
+  progressInfo.cbDownloadCompleted += n;
+  chrono::steady_clock::time_point now = chrono::steady_clock::now();
+  if (downloadRate.received == 0)
+  {
+    downloadRate.start = now;
+  }
+  downloadRate.received += n;
+  double elapsed = chrono::duration<double>(now - downloadRate.start).count();
+  if (elapsed > 1.0)
+  {
+    progressInfo.bytesPerSecond = static_cast<unsigned long>(Divide(downloadRate.received, elapsed));
+    downloadRate.received = 0;
+  }
+  double timePassed = clock() - timeStarted;
+  double timeTotal = ((timePassed / progressInfo.cbDownloadCompleted) * progressInfo.cbDownloadTotal);
+  progressInfo.timeRemaining = static_cast<unsigned long>((timeTotal - timePassed) / CLOCKS_PER_SEC);
+}
+
 void PackageInstallerImpl::OnBeginFileExtraction(const string& fileName, size_t uncompressedSize)
 {
   UNUSED_ALWAYS(uncompressedSize);
@@ -882,14 +888,7 @@ void PackageInstallerImpl::MyCopyFile(const PathName& source, const PathName& de
   FileStream fromStream(File::Open(source, FileMode::Open, FileAccess::Read, false));
 
   // copy the file
-  char buffer[4096];
-  size_t n;
-  size = 0;
-  while ((n = fromStream.Read(buffer, 4096)) > 0)
-  {
-    toStream.Write(buffer, n);
-    size += n;
-  }
+  size = File::CopyData(fromStream.GetFile(), toStream.GetFile(), File::GetSize(source));
 
   fromStream.Close();
   toStream.Close();
@@ -1062,9 +1061,23 @@ void PackageInstallerImpl::InstallPackage(const string& packageId, Cfg& packageM
   PathName pathArchiveFile;
   ArchiveFileType aft = repositoryManifest.GetArchiveFileType(packageId);
   unique_ptr<TemporaryFile> temporaryFile;
+  unique_ptr<ArchivePrefetcher::Archive> archive;
 
   // get hold of the archive file
-  if (repositoryType == RepositoryType::Remote
+  if (prefetcher != nullptr && prefetcher->IsPending(packageId))
+  {
+    // downloaded and digested in the background
+    archive = PickUpArchive(packageId, 0);
+    pathArchiveFile = archive->path;
+
+    // check to see whether the digest is good
+    if (!CheckArchiveFile(packageId, *archive, false))
+    {
+      LoadRepositoryManifest(true);
+      CheckArchiveFile(packageId, *archive, true);
+    }
+  }
+  else if (repositoryType == RepositoryType::Remote
     || repositoryType == RepositoryType::Local)
   {
     PathName packageFileName = packageId;
@@ -1196,11 +1209,20 @@ void PackageInstallerImpl::DownloadPackage(const string& packageId)
   PathName pathArchiveFile = packageId;
   pathArchiveFile.AppendExtension(MiKTeX::Extractor::Extractor::GetFileNameExtension(aft));
 
-  // download the archive file
-  Download(pathArchiveFile, expectedSize);
+  if (prefetcher != nullptr && prefetcher->IsPending(packageId))
+  {
+    // downloaded in the background
+    unique_ptr<ArchivePrefetcher::Archive> archive = PickUpArchive(packageId, expectedSize);
+    CheckArchiveFile(packageId, *archive, true);
+  }
+  else
+  {
+    // download the archive file
+    Download(pathArchiveFile, expectedSize);
 
-  // check to see whether the archive file is ok
-  CheckArchiveFile(packageId, downloadDirectory / pathArchiveFile, true);
+    // check to see whether the archive file is ok
+    CheckArchiveFile(packageId, downloadDirectory / pathArchiveFile, true);
+  }
 
   // notify client: end of package download
   Notify(Notification::DownloadPackageEnd);
@@ -1307,6 +1329,120 @@ bool PackageInstallerImpl::CheckArchiveFile(const std::string& packageId, const
   return ok;
 }
 
+bool PackageInstallerImpl::CheckArchiveFile(const std::string& packageId, const ArchivePrefetcher::Archive& archive, bool mustBeOk)
+{
+  if (!archive.exists)
+  {
+    MIKTEX_FATAL_ERROR_2(FatalError(ERROR_MISSING_PACKAGE), "package", packageId, "archiveFile", archive.path.ToString());
+  }
+  MD5 digest1 = repositoryManifest.GetArchiveFileDigest(packageId);
+  bool ok = (digest1 == archive.digest);
+  if (!ok && mustBeOk)
+  {
+    MIKTEX_FATAL_ERROR_2(FatalError(ERROR_CORRUPTED_PACKAGE), "package", packageId, "arhiveFile", archive.path.ToString(), "expectedMD5", digest1.ToString(), "actualMD5", archive.digest.ToString());
+  }
+  return ok;
+}
+
+void PackageInstallerImpl::StartPrefetcher(const vector<string>& packages, bool downloadOnly)
+{
+  int maxParallelDownloads = session->GetConfigValue(MIKTEX_CONFIG_SECTION_MPM, MIKTEX_CONFIG_VALUE_MAXPARALLELDOWNLOADS, DEFAULT_MAX_PARALLEL_DOWNLOADS).GetInt();
+  if (maxParallelDownloads <= 1 || packages.size() <= 1)
+  {
+    return;
+  }
+  // the worker threads must not use the session: temporary files and
+  // web sessions are created here
+  vector<ArchivePrefetcher::Job> jobs;
+  for (const string& packageId : packages)
+  {
+    ArchiveFileType aft = repositoryManifest.GetArchiveFileType(packageId);
+    PathName packageFileName = packageId;
+    packageFileName.AppendExtension(MiKTeX::Extractor::Extractor::GetFileNameExtension(aft));
+    ArchivePrefetcher::Job job;
+    job.packageId = packageId;
+    if (repositoryType == RepositoryType::Remote)
+    {
+      job.url = MakeUrl(packageFileName.ToString());
+      if (downloadOnly)
+      {
+        job.path = downloadDirectory / packageFileName;
+      }
+      else
+      {
+        job.temporaryFile = TemporaryFile::Create();
+        job.path = job.temporaryFile->GetPathName();
+      }
+    }
+    else
+    {
+      MIKTEX_ASSERT(repositoryType == RepositoryType::Local);
+      job.path = repository / packageFileName;
+    }
+    jobs.push_back(std::move(job));
+  }
+  vector<shared_ptr<WebSession>> webSessions;
+  if (repositoryType == RepositoryType::Remote)
+  {
+    for (int n = 0; n < maxParallelDownloads; ++n)
+    {
+      shared_ptr<WebSession> webSession = WebSession::Create(nullptr);
+      webSession->Initialize();
+      webSessions.push_back(webSession);
+    }
+  }
+  trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("prefetching {0} archive files ({1} threads)"), jobs.size(), maxParallelDownloads));
+  prefetchedBytes = 0;
+  prefetcher = make_unique<ArchivePrefetcher>(std::move(jobs), static_cast<unsigned>(maxParallelDownloads), std::move(webSessions), [this]() { OnPrefetchProgress(); });
+}
+
+void PackageInstallerImpl::StopPrefetcher()
+{
+  if (prefetcher != nullptr)
+  {
+    prefetcher->Stop();
+    prefetcher = nullptr;
+  }
+}
+
+unique_ptr<ArchivePrefetcher::Archive> PackageInstallerImpl::PickUpArchive(const string& packageId, size_t expectedSize)
+{
+  unique_ptr<ArchivePrefetcher::Archive> archive = prefetcher->PickUp(packageId);
+  {
+    lock_guard<mutex> lockGuard(progressIndicatorMutex);
+    progressInfo.cbPackageDownloadCompleted = progressInfo.cbPackageDownloadTotal;
+  }
+  Notify();
+  if (archive->received > 0)
+  {
+    double mb = Divide(archive->received, 1000000);
+    double seconds = std::max(archive->seconds, 0.001);
+    trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("downloaded {0:.2f} MB in {1:.2f} seconds"), mb, seconds));
+    ReportLine(fmt::format(T_("{0}: {1:.2f} MB, {2:.2f} Mbit/s"), packageId, mb, Divide(8 * mb, seconds)));
+  }
+  if (expectedSize > 0 && expectedSize != archive->received)
+  {
+    File::Delete(archive->path);
+    MIKTEX_FATAL_ERROR_2(FatalError(ERROR_SIZE_MISMATCH), "dest", archive->path.ToString(), "expectecSize", std::to_string(expectedSize), "received", std::to_string(archive->received));
+  }
+  return archive;
+}
+
+// called by the installer thread while it waits for an archive file
+void PackageInstallerImpl::OnPrefetchProgress()
+{
+  size_t received = prefetcher->GetBytesReceived();
+  {
+    lock_guard<mutex> lockGuard(progressIndicatorMutex);
+    if (received > prefetchedBytes)
+    {
+      UpdateDownloadProgress(received - prefetchedBytes);
+      prefetchedBytes = received;
+    }
+  }
+  Notify();
+}
+
 #if defined(MIKTEX_WINDOWS) && USE_LOCAL_SERVER
 
 void PackageInstallerImpl::ConnectToServer()
@@ -1756,40 +1892,69 @@ void PackageInstallerImpl::InstallRemove(Role role)
     packageManifests->Read(packageManifestsIni);
   }
 
-  // install packages
-  for (const string& p : toBeInstalled)
+  // batch the file name database updates of all packages
+  Fndb::BeginTransaction();
+  try
   {
-    InstallPackage(p, *packageManifests);
-  }
+    // download archive files in the background; packages are
+    // installed one after another
+    if (repositoryType == RepositoryType::Remote || repositoryType == RepositoryType::Local)
+    {
+      StartPrefetcher(toBeInstalled, false);
+    }
 
-  // remove packages
-  for (const string& p : toBeRemoved)
-  {
-    RemovePackage(p, *packageManifests);
-  }
+    // install packages
+    try
+    {
+      for (const string& p : toBeInstalled)
+      {
+        InstallPackage(p, *packageManifests);
+      }
+    }
+    catch (const exception&)
+    {
+      StopPrefetcher();
+      throw;
+    }
+    StopPrefetcher();
 
-  if (role == Role::Updater)
-  {
-    session->SetConfigValue(
-      MIKTEX_REGKEY_PACKAGE_MANAGER,
-      session->IsAdminMode() ? MIKTEX_REGVAL_LAST_ADMIN_UPDATE : MIKTEX_REGVAL_LAST_USER_UPDATE,
-      std::to_string(time(nullptr)));
-  }
+    // remove packages
+    for (const string& p : toBeRemoved)
+    {
+      RemovePackage(p, *packageManifests);
+    }
 
-  // check dependencies (install missing required packages)
-  tmp.clear();
-  for (const string& p : toBeInstalled)
-  {
-    CheckDependencies(tmp, p, false, 0);
+    if (role == Role::Updater)
+    {
+      session->SetConfigValue(
+        MIKTEX_REGKEY_PACKAGE_MANAGER,
+        session->IsAdminMode() ? MIKTEX_REGVAL_LAST_ADMIN_UPDATE : MIKTEX_REGVAL_LAST_USER_UPDATE,
+        std::to_string(time(nullptr)));
+    }
+
+    // check dependencies (install missing required packages)
+    tmp.clear();
+    for (const string& p : toBeInstalled)
+    {
+      CheckDependencies(tmp, p, false, 0);
+    }
+    for (const string& p : tmp)
+    {
+      InstallPackage(p, *packageManifests);
+    }
   }
-  for (const string& p : tmp)
+  catch (const exception&)
   {
-    InstallPackage(p, *packageManifests);
+    // the files of the packages processed so far are in place
+    Fndb::CommitTransaction();
+    throw;
   }
+  Fndb::CommitTransaction();
 
   if (File::Exists(packageManifestsIni))
   {
     packageManifests->Write(packageManifestsIni);
+    PackageManifestsDb::Invalidate(packageManifestsIni);
   }
 
   packageManifests = nullptr;
@@ -1985,10 +2150,20 @@ void PackageInstallerImpl::Download()
   Download(MIKTEX_PACKAGE_MANIFESTS_ARCHIVE_FILE_NAME);
 
   // download archive files
-  for (const string& p : toBeInstalled)
+  StartPrefetcher(toBeInstalled, true);
+  try
+  {
+    for (const string& p : toBeInstalled)
+    {
+      DownloadPackage(p);
+    }
+  }
+  catch (const exception&)
   {
-    DownloadPackage(p);
+    StopPrefetcher();
+    throw;
   }
+  StopPrefetcher();
 }
 
 void PackageInstallerImpl::DownloadAsync()
@@ -2087,6 +2262,7 @@ void PackageInstallerImpl::CleanUpUserDatabase()
   }
 
   userManifests->Write(userManifestsPath);
+  PackageManifestsDb::Invalidate(userManifestsPath);
 }
 
 void PackageInstallerImpl::HandleObsoletePackageManifests(Cfg& existingManifests, const Cfg& newManifests)
@@ -2246,6 +2422,7 @@ void PackageInstallerImpl::UpdateDb()
 
   // write package-manifests.ini
   existingManifests->Write(existingPackageManifestsIni);
+  PackageManifestsDb::Invalidate(existingPackageManifestsIni);
 
   ReportLine(fmt::format(T_("installed {0} package manifests"), count));
 
@@ -22,6 +22,7 @@
 #if !defined(BF24CACAD93E4429BB9357433BBA2B22)
 #define BF24CACAD93E4429BB9357433BBA2B22
 
+#include <chrono>
 #include <memory>
 #include <mutex>
 #include <set>
@@ -33,6 +34,7 @@
 #include <miktex/Extractor/Extractor>
 #include <miktex/Trace/Trace>
 
+#include "ArchivePrefetcher.h"
 #include "PackageManagerImpl.h"
 #include "RepositoryManifest.h"
 
@@ -354,6 +356,35 @@ private:
 private:
   void Download(const std::string& url, const MiKTeX::Core::PathName& dest, std::size_t expectedSize = 0);
 
+private:
+  void UpdateDownloadProgress(std::size_t n);
+
+private:
+  struct
+  {
+    std::chrono::steady_clock::time_point start;
+    std::size_t received = 0;
+  } downloadRate;
+
+private:
+  std::unique_ptr<ArchivePrefetcher> prefetcher;
+
+private:
+  void StartPrefetcher(const std::vector<std::string>& packages, bool downloadOnly);
+
+private:
+  void StopPrefetcher();
+
+private:
+  std::unique_ptr<ArchivePrefetcher::Archive> PickUpArchive(const std::string& packageId, std::size_t expectedSize);
+
+private:
+  void OnPrefetchProgress();
+
+  // bytes downloaded by the prefetcher which have been accounted for
+private:
+  std::size_t prefetchedBytes = 0;
+
 private:
   void Download(const MiKTeX::Core::PathName& fileName, std::size_t expectedSize = 0);
 
@@ -390,6 +421,9 @@ private:
 private:
   bool CheckArchiveFile(const std::string& packageId, const MiKTeX::Core::PathName& archiveFileName, bool mustBeOk);
 
+private:
+  bool CheckArchiveFile(const std::string& packageId, const ArchivePrefetcher::Archive& archive, bool mustBeOk);
+
 private:
   void CheckDependencies(std::set<std::string>& packages, const std::string& packageId, bool force, int level);
 
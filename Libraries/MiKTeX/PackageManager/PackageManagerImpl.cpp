@@ -22,9 +22,12 @@
 #include "config.h"
 
 #include <algorithm>
+#include <atomic>
 #include <fstream>
 #include <locale>
+#include <mutex>
 #include <stack>
+#include <thread>
 #include <unordered_set>
 
 #include <fmt/format.h>
@@ -1092,96 +1095,207 @@ void PackageManagerImpl::OnProgress()
 {
 }
 
-bool PackageManagerImpl::TryGetFileDigest(const PathName& prefix, const string& fileName, bool& haveDigest, MD5& digest)
+PathName PackageManagerImpl::GetInstallRoot(const PackageInfo& packageInfo)
 {
-  string unprefixed;
-  if (!StripTeXMFPrefix(fileName, unprefixed))
-  {
-    return true;
-  }
-  PathName path = prefix;
-  path /= unprefixed;
-  if (!File::Exists(path))
+  if (!session->IsAdminMode() && IsValidTimeT(packageInfo.timeInstalledByUser))
   {
-    trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("package verification failed: file {0} does not exist"), Q_(path)));
-    return false;
+    return session->GetSpecialPath(SpecialPath::UserInstallRoot);
   }
-  if (path.HasExtension(MIKTEX_PACKAGE_MANIFEST_FILE_SUFFIX))
+  return session->GetSpecialPath(SpecialPath::CommonInstallRoot);
+}
+
+bool PackageManagerImpl::TryVerifyInstalledPackage(const string& packageId)
+{
+  return TryVerifyInstalledPackages({ packageId }, nullptr);
+}
+
+bool PackageManagerImpl::TryVerifyInstalledPackages(const vector<string>& packageIds, function<void(const string& packageId, bool ok)> onVerified)
+{
+  enum class FileState { Pending, NoDigest, HaveDigest, Missing };
+
+  struct Package
+  {
+    PackageInfo packageInfo;
+    PathName prefix;
+    vector<string> files;
+    vector<PathName> paths;
+    vector<FileState> states;
+    vector<MD5> digests;
+    atomic<size_t> remaining{ 0 };
+    atomic<bool> failed{ false };
+  };
+
+  struct Job
   {
-    haveDigest = false;
-  }
-  else
+    size_t packageIdx;
+    size_t fileIdx;
+  };
+
+  if (fileDigestCache == nullptr)
   {
-    digest = MD5::FromFile(path);
-    haveDigest = true;
+    fileDigestCache = make_unique<FileDigestCache>(session->GetSpecialPath(SpecialPath::DataRoot) / MIKTEX_PATH_FNDB_DIR / "file-digests.cache", trace_mpm.get());
   }
-  return true;
-}
 
-bool PackageManagerImpl::TryCollectFileDigests(const PathName& prefix, const vector<string>& files, FileDigestTable& fileDigests)
-{
-  for (const string& fileName : files)
+  atomic<bool> allOk{ true };
+  mutex callbackMutex;
+
+  auto finish = [&](Package& package)
   {
-    bool haveDigest;
-    MD5 digest;
-    if (!TryGetFileDigest(prefix, fileName, haveDigest, digest))
+    bool ok = !package.failed;
+    if (ok)
     {
-      return false;
+      FileDigestTable fileDigests;
+      for (size_t idx = 0; idx < package.files.size(); ++idx)
+      {
+        if (package.states[idx] == FileState::HaveDigest)
+        {
+          fileDigests[package.files[idx]] = package.digests[idx];
+        }
+      }
+      MD5Builder md5Builder;
+      for (const pair<string, MD5> p : fileDigests)
+      {
+        PathName path(p.first);
+        // we must dosify the path name for backward compatibility
+        path.ConvertToDos();
+        md5Builder.Update(path.GetData(), path.GetLength());
+        md5Builder.Update(p.second.data(), p.second.size());
+      }
+      ok = md5Builder.Final() == package.packageInfo.digest;
+      if (!ok)
+      {
+        trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("package {0} verification failed: some files have been modified"), Q_(package.packageInfo.id)));
+        trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("expected digest: {0}"), package.packageInfo.digest));
+        trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("computed digest: {0}"), md5Builder.GetMD5()));
+      }
     }
-    if (haveDigest)
+    if (!ok)
     {
-      fileDigests[fileName] = digest;
+      allOk = false;
     }
-  }
-  return true;
-}
-
-bool PackageManagerImpl::TryVerifyInstalledPackage(const string& packageId)
-{
-  PackageInfo packageInfo = GetPackageInfo(packageId);
+    if (onVerified)
+    {
+      lock_guard<mutex> lockGuard(callbackMutex);
+      onVerified(package.packageInfo.id, ok);
+    }
+  };
 
-  PathName prefix;
+  vector<unique_ptr<Package>> packages;
+  vector<Job> jobs;
 
-  if (!session->IsAdminMode() && IsValidTimeT(packageInfo.timeInstalledByUser))
+  for (const string& packageId : packageIds)
   {
-    prefix = session->GetSpecialPath(SpecialPath::UserInstallRoot);
+    unique_ptr<Package> package = make_unique<Package>();
+    package->packageInfo = GetPackageInfo(packageId);
+    package->prefix = GetInstallRoot(package->packageInfo);
+    for (const vector<string>* files : { &package->packageInfo.runFiles, &package->packageInfo.docFiles, &package->packageInfo.sourceFiles })
+    {
+      for (const string& fileName : *files)
+      {
+        string unprefixed;
+        if (!StripTeXMFPrefix(fileName, unprefixed))
+        {
+          continue;
+        }
+        jobs.push_back(Job{ packages.size(), package->files.size() });
+        package->files.push_back(fileName);
+        package->paths.push_back(package->prefix / unprefixed);
+      }
+    }
+    package->states.resize(package->files.size(), FileState::Pending);
+    package->digests.resize(package->files.size());
+    package->remaining = package->files.size();
+    packages.push_back(std::move(package));
   }
 
-  if (prefix.Empty())
+  for (unique_ptr<Package>& package : packages)
   {
-    prefix = session->GetSpecialPath(SpecialPath::CommonInstallRoot);
+    if (package->files.empty())
+    {
+      finish(*package);
+    }
   }
 
-  FileDigestTable fileDigests;
+  atomic<size_t> nextJob{ 0 };
+  atomic<bool> stopping{ false };
+  mutex errorMutex;
+  exception_ptr error;
 
-  if (!TryCollectFileDigests(prefix, packageInfo.runFiles, fileDigests)
-    || !TryCollectFileDigests(prefix, packageInfo.docFiles, fileDigests)
-    || !TryCollectFileDigests(prefix, packageInfo.sourceFiles, fileDigests))
+  auto worker = [&]()
   {
-    return false;
-  }
+    try
+    {
+      size_t jobIdx;
+      while (!stopping && (jobIdx = nextJob++) < jobs.size())
+      {
+        const Job& job = jobs[jobIdx];
+        Package& package = *packages[job.packageIdx];
+        // no need to digest the remaining files of a broken package
+        if (!package.failed)
+        {
+          const PathName& path = package.paths[job.fileIdx];
+          if (!File::Exists(path))
+          {
+            trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("package verification failed: file {0} does not exist"), Q_(path)));
+            package.states[job.fileIdx] = FileState::Missing;
+            package.failed = true;
+          }
+          else if (path.HasExtension(MIKTEX_PACKAGE_MANIFEST_FILE_SUFFIX))
+          {
+            package.states[job.fileIdx] = FileState::NoDigest;
+          }
+          else
+          {
+            package.digests[job.fileIdx] = fileDigestCache->GetDigest(path);
+            package.states[job.fileIdx] = FileState::HaveDigest;
+          }
+        }
+        // the last worker to complete a file of the package reports the result
+        if (--package.remaining == 0)
+        {
+          finish(package);
+        }
+      }
+    }
+    catch (...)
+    {
+      lock_guard<mutex> lockGuard(errorMutex);
+      if (error == nullptr)
+      {
+        error = current_exception();
+      }
+      stopping = true;
+    }
+  };
 
-  MD5Builder md5Builder;
+  unsigned numThreads = std::max(thread::hardware_concurrency(), 1u);
+  numThreads = static_cast<unsigned>(std::min(static_cast<size_t>(numThreads), jobs.size()));
 
-  for (const pair<string, MD5> p : fileDigests)
+  if (numThreads > 1)
+  {
+    vector<thread> threads;
+    for (unsigned n = 0; n < numThreads; ++n)
+    {
+      threads.push_back(thread(worker));
+    }
+    for (thread& t : threads)
+    {
+      t.join();
+    }
+  }
+  else
   {
-    PathName path(p.first);
-    // we must dosify the path name for backward compatibility
-    path.ConvertToDos();
-    md5Builder.Update(path.GetData(), path.GetLength());
-    md5Builder.Update(p.second.data(), p.second.size());
+    worker();
   }
 
-  bool ok = md5Builder.Final() == packageInfo.digest;
+  fileDigestCache->Save();
 
-  if (!ok)
+  if (error != nullptr)
   {
-    trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("package {0} verification failed: some files have been modified"), Q_(packageId)));
-    trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("expected digest: {0}"), packageInfo.digest));
-    trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("computed digest: {0}"), md5Builder.GetMD5()));
+    rethrow_exception(error);
   }
 
-  return ok;
+  return allOk;
 }
 
 string PackageManagerImpl::GetContainerPath(const string& packageId, bool useDisplayNames)
@@ -22,6 +22,7 @@
 #if !defined(D76F495437014794AC4EF6832E8EEE52)
 #define D76F495437014794AC4EF6832E8EEE52
 
+#include <functional>
 #include <map>
 #include <string>
 
@@ -32,6 +33,7 @@
 
 #include "internal.h"
 
+#include "FileDigestCache.h"
 #include "PackageDataStore.h"
 #include "PackageRepositoryDataStore.h"
 #include "WebSession.h"
@@ -133,6 +135,9 @@ public:
 public:
   bool MIKTEXTHISCALL TryVerifyInstalledPackage(const std::string& packageId) override;
 
+public:
+  bool MIKTEXTHISCALL TryVerifyInstalledPackages(const std::vector<std::string>& packageIds, std::function<void(const std::string& packageId, bool ok)> onVerified) override;
+
 public:
   std::string MIKTEXTHISCALL GetContainerPath(const std::string& packageId, bool useDisplayNames) override;
 
@@ -146,10 +151,10 @@ public:
   void ClearAll();
 
 private:
-  bool TryGetFileDigest(const MiKTeX::Core::PathName& prefix, const std::string& fileName, bool& haveDigest, MiKTeX::Core::MD5& digest);
+  MiKTeX::Core::PathName GetInstallRoot(const MiKTeX::Packages::PackageInfo& packageInfo);
 
 private:
-  bool TryCollectFileDigests(const MiKTeX::Core::PathName& prefix, const std::vector<std::string>& files, FileDigestTable& fileDigests);
+  std::unique_ptr<FileDigestCache> fileDigestCache;
 
 private:
   void Dispose();
@@ -0,0 +1,362 @@
+/* PackageManifestsDb.cpp: compiled package manifests
+
+   Copyright (C) 2019 Christian Schenk
+
+   This file is part of MiKTeX Package Manager.
+
+   MiKTeX Package Manager is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+
+   MiKTeX Package Manager is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with MiKTeX Package Manager; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#include "config.h"
+
+#include <cstring>
+
+#include <algorithm>
+#include <unordered_map>
+
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+
+#include <miktex/Core/Exceptions>
+#include <miktex/Core/File>
+#include <miktex/Core/less_icase_dos>
+#include <miktex/PackageManager/PackageManager>
+
+#include "internal.h"
+
+#include "PackageManifestsDb.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Packages;
+using namespace MiKTeX::Trace;
+
+using namespace MiKTeX::Packages::D6AAD62216146D44B580E92711724B78;
+
+namespace {
+  class StringPool
+  {
+  public:
+    StringPool()
+    {
+      Add("");
+    }
+  public:
+    PmdbByteOffset Add(const string& s)
+    {
+      auto it = offsets.find(s);
+      if (it != offsets.end())
+      {
+        return it->second;
+      }
+      PmdbByteOffset fo = static_cast<PmdbByteOffset>(pool.size());
+      pool.insert(pool.end(), s.begin(), s.end());
+      pool.push_back(0);
+      offsets[s] = fo;
+      return fo;
+    }
+  public:
+    vector<uint8_t> pool;
+  private:
+    unordered_map<string, PmdbByteOffset> offsets;
+  };
+}
+
+PackageManifestsDb::~PackageManifestsDb()
+{
+  try
+  {
+    if (mmap != nullptr && mmap->GetPtr() != nullptr)
+    {
+      mmap->Close();
+    }
+  }
+  catch (const exception&)
+  {
+  }
+}
+
+PathName PackageManifestsDb::GetDbPath(const PathName& iniPath)
+{
+  PathName dbPath(iniPath);
+  dbPath.SetExtension(".db");
+  return dbPath;
+}
+
+unique_ptr<PackageManifestsDb> PackageManifestsDb::Open(const PathName& iniPath, bool persistent, TraceStream* trace)
+{
+  uint64_t iniSize = File::GetSize(iniPath);
+  int64_t iniLastWriteTime = File::GetLastWriteTime(iniPath);
+  PathName dbPath = GetDbPath(iniPath);
+  unique_ptr<PackageManifestsDb> db(new PackageManifestsDb());
+  if (persistent && File::Exists(dbPath))
+  {
+    try
+    {
+      db->mmap = unique_ptr<MemoryMappedFile>(MemoryMappedFile::Create());
+      const void* ptr = db->mmap->Open(dbPath, false);
+      if (db->Attach(ptr, db->mmap->GetSize()) && db->header->iniSize == iniSize && db->header->iniLastWriteTime == iniLastWriteTime)
+      {
+        trace->WriteLine(TRACE_FACILITY, fmt::format(T_("using compiled package manifests {0}"), Q_(dbPath)));
+        return db;
+      }
+      db->mmap->Close();
+      db->mmap = nullptr;
+      trace->WriteLine(TRACE_FACILITY, fmt::format(T_("{0} is out of date"), Q_(dbPath)));
+    }
+    catch (const MiKTeXException& e)
+    {
+      trace->WriteLine(TRACE_FACILITY, fmt::format(T_("cannot open {0}: {1}"), Q_(dbPath), e.GetErrorMessage()));
+      db->mmap = nullptr;
+    }
+  }
+  trace->WriteLine(TRACE_FACILITY, fmt::format(T_("compiling package manifests {0}"), Q_(iniPath)));
+  unique_ptr<Cfg> cfg = Cfg::Create();
+  cfg->Read(iniPath);
+  db->buffer = Compile(*cfg, iniSize, iniLastWriteTime);
+  if (!db->Attach(db->buffer.data(), db->buffer.size()))
+  {
+    MIKTEX_UNEXPECTED();
+  }
+  if (!persistent)
+  {
+    return db;
+  }
+  // write to a temporary file first: other processes might be reading
+  // the existing database
+  try
+  {
+    PathName dbDir(dbPath);
+    dbDir.RemoveFileSpec();
+    PathName tempPath;
+    tempPath.SetToTempFile(dbDir);
+    File::WriteBytes(tempPath, db->buffer);
+    File::Move(tempPath, dbPath, { FileMoveOption::ReplaceExisting });
+  }
+  catch (const MiKTeXException& e)
+  {
+    // keep the compiled package manifests in memory
+    trace->WriteLine(TRACE_FACILITY, fmt::format(T_("cannot write {0}: {1}"), Q_(dbPath), e.GetErrorMessage()));
+  }
+  return db;
+}
+
+void PackageManifestsDb::Invalidate(const PathName& iniPath)
+{
+  PathName dbPath = GetDbPath(iniPath);
+  if (!File::Exists(dbPath))
+  {
+    return;
+  }
+  try
+  {
+    File::Delete(dbPath);
+  }
+  catch (const MiKTeXException&)
+  {
+    // the database might be in use (Windows); it will be recompiled
+    // because the INI file has changed
+  }
+}
+
+vector<uint8_t> PackageManifestsDb::Compile(Cfg& cfg, uint64_t iniSize, int64_t iniLastWriteTime)
+{
+  vector<PackageInfo> packages;
+  for (const auto& key : cfg)
+  {
+    packages.push_back(PackageManager::GetPackageManifest(cfg, key->GetName(), TEXMF_PREFIX_DIRECTORY));
+  }
+  less_icase_dos less;
+  sort(packages.begin(), packages.end(), [&less](const PackageInfo& a, const PackageInfo& b) { return less(a.id, b.id); });
+  StringPool strings;
+  vector<PmdbWord> lists;
+  auto addList = [&strings, &lists](const vector<string>& v) {
+    PackageManifestsDbList list;
+    list.first = static_cast<PmdbWord>(lists.size());
+    list.count = static_cast<PmdbWord>(v.size());
+    for (const string& s : v)
+    {
+      lists.push_back(strings.Add(s));
+    }
+    return list;
+  };
+  vector<PackageManifestsDbRecord> records(packages.size());
+  for (size_t idx = 0; idx < packages.size(); ++idx)
+  {
+    const PackageInfo& packageInfo = packages[idx];
+    PackageManifestsDbRecord& record = records[idx];
+    memset(&record, 0, sizeof(record));
+    record.id = strings.Add(packageInfo.id);
+    record.displayName = strings.Add(packageInfo.displayName);
+    record.creator = strings.Add(packageInfo.creator);
+    record.title = strings.Add(packageInfo.title);
+    record.version = strings.Add(packageInfo.version);
+    record.targetSystem = strings.Add(packageInfo.targetSystem);
+    record.description = strings.Add(packageInfo.description);
+    record.ctanPath = strings.Add(packageInfo.ctanPath);
+    record.copyrightOwner = strings.Add(packageInfo.copyrightOwner);
+    record.copyrightYear = strings.Add(packageInfo.copyrightYear);
+    record.licenseType = strings.Add(packageInfo.licenseType);
+    record.requiredPackages = addList(packageInfo.requiredPackages);
+    record.runFiles = addList(packageInfo.runFiles);
+    record.docFiles = addList(packageInfo.docFiles);
+    record.sourceFiles = addList(packageInfo.sourceFiles);
+    record.sizeRunFiles = packageInfo.sizeRunFiles;
+    record.sizeDocFiles = packageInfo.sizeDocFiles;
+    record.sizeSourceFiles = packageInfo.sizeSourceFiles;
+    record.timePackaged = packageInfo.timePackaged;
+    memcpy(record.digest, packageInfo.digest.data(), sizeof(record.digest));
+  }
+  PackageManifestsDbHeader header;
+  memset(&header, 0, sizeof(header));
+  header.signature = PackageManifestsDbHeader::Signature;
+  header.version = PackageManifestsDbHeader::Version;
+  header.iniSize = iniSize;
+  header.iniLastWriteTime = iniLastWriteTime;
+  header.numPackages = static_cast<PmdbWord>(records.size());
+  uint64_t foPackages = sizeof(header);
+  uint64_t foLists = foPackages + records.size() * sizeof(PackageManifestsDbRecord);
+  uint64_t foStrings = foLists + lists.size() * sizeof(PmdbWord);
+  uint64_t size = foStrings + strings.pool.size();
+  if (size > UINT32_MAX)
+  {
+    MIKTEX_FATAL_ERROR_2(T_("Too many package manifests."), "size", std::to_string(size));
+  }
+  header.foPackages = static_cast<PmdbByteOffset>(foPackages);
+  header.foLists = static_cast<PmdbByteOffset>(foLists);
+  header.foStrings = static_cast<PmdbByteOffset>(foStrings);
+  header.size = static_cast<PmdbWord>(size);
+  vector<uint8_t> result(size);
+  memcpy(&result[0], &header, sizeof(header));
+  if (!records.empty())
+  {
+    memcpy(&result[foPackages], records.data(), records.size() * sizeof(PackageManifestsDbRecord));
+  }
+  if (!lists.empty())
+  {
+    memcpy(&result[foLists], lists.data(), lists.size() * sizeof(PmdbWord));
+  }
+  memcpy(&result[foStrings], strings.pool.data(), strings.pool.size());
+  return result;
+}
+
+bool PackageManifestsDb::Attach(const void* ptr, size_t size)
+{
+  const PackageManifestsDbHeader* header = reinterpret_cast<const PackageManifestsDbHeader*>(ptr);
+  if (ptr == nullptr
+    || size < sizeof(*header)
+    || header->signature != PackageManifestsDbHeader::Signature
+    || header->version != PackageManifestsDbHeader::Version
+    || header->size != size
+    || header->foPackages < sizeof(*header)
+    || header->foPackages % alignof(PackageManifestsDbRecord) != 0
+    || header->foPackages + static_cast<uint64_t>(header->numPackages) * sizeof(PackageManifestsDbRecord) > header->foLists
+    || header->foLists > header->foStrings
+    || (header->foStrings - header->foLists) % sizeof(PmdbWord) != 0
+    || header->foStrings >= size
+    || reinterpret_cast<const uint8_t*>(ptr)[size - 1] != 0)
+  {
+    return false;
+  }
+  const uint8_t* data = reinterpret_cast<const uint8_t*>(ptr);
+  // the string pool ends with a null byte: any offset into the pool
+  // denotes a null-terminated string
+  size_t stringPoolSize = size - header->foStrings;
+  const PmdbWord* lists = reinterpret_cast<const PmdbWord*>(data + header->foLists);
+  size_t numListElements = (header->foStrings - header->foLists) / sizeof(PmdbWord);
+  for (size_t idx = 0; idx < numListElements; ++idx)
+  {
+    if (lists[idx] >= stringPoolSize)
+    {
+      return false;
+    }
+  }
+  auto isValidList = [numListElements](const PackageManifestsDbList& list) {
+    return list.first <= numListElements && list.count <= numListElements - list.first;
+  };
+  const PackageManifestsDbRecord* records = reinterpret_cast<const PackageManifestsDbRecord*>(data + header->foPackages);
+  for (size_t idx = 0; idx < header->numPackages; ++idx)
+  {
+    const PackageManifestsDbRecord& record = records[idx];
+    for (PmdbByteOffset fo : { record.id, record.displayName, record.creator, record.title, record.version, record.targetSystem, record.description, record.ctanPath, record.copyrightOwner, record.copyrightYear, record.licenseType })
+    {
+      if (fo >= stringPoolSize)
+      {
+        return false;
+      }
+    }
+    if (!isValidList(record.requiredPackages)
+      || !isValidList(record.runFiles)
+      || !isValidList(record.docFiles)
+      || !isValidList(record.sourceFiles))
+    {
+      return false;
+    }
+  }
+  this->data = data;
+  this->header = header;
+  return true;
+}
+
+vector<string> PackageManifestsDb::GetList(const PackageManifestsDbList& list) const
+{
+  const PmdbWord* fo = reinterpret_cast<const PmdbWord*>(data + header->foLists) + list.first;
+  vector<string> result;
+  result.reserve(list.count);
+  for (PmdbWord n = 0; n < list.count; ++n)
+  {
+    result.push_back(GetString(fo[n]));
+  }
+  return result;
+}
+
+PackageInfo PackageManifestsDb::GetPackage(size_t idx, bool withFiles) const
+{
+  MIKTEX_ASSERT(idx < GetSize());
+  const PackageManifestsDbRecord& record = GetRecord(idx);
+  PackageInfo packageInfo;
+  packageInfo.id = GetString(record.id);
+  packageInfo.displayName = GetString(record.displayName);
+  packageInfo.creator = GetString(record.creator);
+  packageInfo.title = GetString(record.title);
+  packageInfo.version = GetString(record.version);
+  packageInfo.targetSystem = GetString(record.targetSystem);
+  packageInfo.description = GetString(record.description);
+  packageInfo.ctanPath = GetString(record.ctanPath);
+  packageInfo.copyrightOwner = GetString(record.copyrightOwner);
+  packageInfo.copyrightYear = GetString(record.copyrightYear);
+  packageInfo.licenseType = GetString(record.licenseType);
+  packageInfo.requiredPackages = GetList(record.requiredPackages);
+  packageInfo.sizeRunFiles = static_cast<size_t>(record.sizeRunFiles);
+  packageInfo.sizeDocFiles = static_cast<size_t>(record.sizeDocFiles);
+  packageInfo.sizeSourceFiles = static_cast<size_t>(record.sizeSourceFiles);
+  packageInfo.timePackaged = static_cast<time_t>(record.timePackaged);
+  memcpy(packageInfo.digest.data(), record.digest, sizeof(record.digest));
+  if (withFiles)
+  {
+    GetFiles(idx, packageInfo);
+  }
+  return packageInfo;
+}
+
+void PackageManifestsDb::GetFiles(size_t idx, PackageInfo& packageInfo) const
+{
+  MIKTEX_ASSERT(idx < GetSize());
+  const PackageManifestsDbRecord& record = GetRecord(idx);
+  packageInfo.runFiles = GetList(record.runFiles);
+  packageInfo.docFiles = GetList(record.docFiles);
+  packageInfo.sourceFiles = GetList(record.sourceFiles);
+}
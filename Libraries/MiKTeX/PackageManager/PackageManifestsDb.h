@@ -0,0 +1,246 @@
+/* PackageManifestsDb.h:                                -*- C++ -*-
+
+   Copyright (C) 2019 Christian Schenk
+
+   This file is part of MiKTeX Package Manager.
+
+   MiKTeX Package Manager is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+
+   MiKTeX Package Manager is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with MiKTeX Package Manager; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#pragma once
+
+#if !defined(A6F1E2C47D3B4E0A9C5D8B7F2E1A0C93)
+#define A6F1E2C47D3B4E0A9C5D8B7F2E1A0C93
+
+#include <cstddef>
+#include <cstdint>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <miktex/Core/Cfg>
+#include <miktex/Core/MemoryMappedFile>
+#include <miktex/Core/PathName>
+
+#include <miktex/PackageManager/PackageManager>
+
+#include <miktex/Trace/TraceStream>
+
+MPM_INTERNAL_BEGIN_NAMESPACE;
+
+typedef std::uint32_t PmdbWord;
+typedef PmdbWord PmdbByteOffset;
+
+// Layout of a compiled package manifests file (host byte order):
+//
+//   header
+//   package records, sorted by package ID (case-insensitive)
+//   lists: arrays of string pool offsets (files, required packages)
+//   string pool: null-terminated strings
+struct PackageManifestsDbHeader
+{
+  static const PmdbWord Signature = 0x42444d50; // 'PMDB' (the x86 way)
+  static const PmdbWord Version = 1;
+
+  // signature of the file
+  PmdbWord signature;
+
+  // format version number
+  PmdbWord version;
+
+  // size of the INI file the database was compiled from
+  std::uint64_t iniSize;
+
+  // last write time of the INI file
+  std::int64_t iniLastWriteTime;
+
+  // number of package records
+  PmdbWord numPackages;
+
+  // pointer to the first package record
+  PmdbByteOffset foPackages;
+
+  // pointer to the lists
+  PmdbByteOffset foLists;
+
+  // pointer to the string pool
+  PmdbByteOffset foStrings;
+
+  // size (in bytes) of the database; includes header size
+  PmdbWord size;
+
+  PmdbWord reserved;
+};
+
+struct PackageManifestsDbList
+{
+  // index of the first list element
+  PmdbWord first;
+
+  // number of list elements
+  PmdbWord count;
+};
+
+struct PackageManifestsDbRecord
+{
+  // string pool offsets
+  PmdbByteOffset id;
+  PmdbByteOffset displayName;
+  PmdbByteOffset creator;
+  PmdbByteOffset title;
+  PmdbByteOffset version;
+  PmdbByteOffset targetSystem;
+  PmdbByteOffset description;
+  PmdbByteOffset ctanPath;
+  PmdbByteOffset copyrightOwner;
+  PmdbByteOffset copyrightYear;
+  PmdbByteOffset licenseType;
+
+  PackageManifestsDbList requiredPackages;
+  PackageManifestsDbList runFiles;
+  PackageManifestsDbList docFiles;
+  PackageManifestsDbList sourceFiles;
+
+  PmdbWord reserved;
+
+  std::uint64_t sizeRunFiles;
+  std::uint64_t sizeDocFiles;
+  std::uint64_t sizeSourceFiles;
+  std::int64_t timePackaged;
+  std::uint8_t digest[16];
+};
+
+/// @brief Compiled (binary) package manifests.
+///
+/// The database is compiled from a package manifests INI file
+/// (`package-manifests.ini`) and stored next to it
+/// (`package-manifests.db`). It is recompiled when the INI file
+/// changes. The package data store decodes all package records when
+/// it is loaded; file lists are decoded on demand.
+///
+/// A mapped database is validated before it is used: every offset
+/// (records, lists and strings) must lie within the mapping.
+class PackageManifestsDb
+{
+public:
+  PackageManifestsDb(const PackageManifestsDb& other) = delete;
+
+public:
+  PackageManifestsDb& operator=(const PackageManifestsDb& other) = delete;
+
+public:
+  ~PackageManifestsDb();
+
+  /// @brief Opens the compiled package manifests.
+  ///
+  /// If `persistent` is `true`, the database is (re-)compiled, if it
+  /// does not exist or if it is out of date. If the database cannot be
+  /// written, the compiled package manifests are kept in memory.
+  ///
+  /// If `persistent` is `false`, the package manifests are compiled
+  /// into memory; nothing is written next to the INI file. This should
+  /// be used for INI files the caller does not own (e.g., files
+  /// extracted into a temporary directory).
+  /// @param iniPath Path to the package manifests INI file.
+  /// @param persistent Indicates whether the database is stored next
+  /// to the INI file.
+  /// @param trace The trace stream.
+  /// @return Returns the database.
+public:
+  static std::unique_ptr<PackageManifestsDb> Open(const MiKTeX::Core::PathName& iniPath, bool persistent, MiKTeX::Trace::TraceStream* trace);
+
+  /// @brief Removes the compiled package manifests.
+  ///
+  /// This should be called after the INI file has been changed.
+  /// @param iniPath Path to the package manifests INI file.
+public:
+  static void Invalidate(const MiKTeX::Core::PathName& iniPath);
+
+  /// @brief Compiles package manifests.
+  /// @param cfg The package manifests.
+  /// @param iniSize The size of the INI file.
+  /// @param iniLastWriteTime The last write time of the INI file.
+  /// @return Returns the compiled package manifests.
+public:
+  static std::vector<std::uint8_t> Compile(MiKTeX::Core::Cfg& cfg, std::uint64_t iniSize, std::int64_t iniLastWriteTime);
+
+  /// Gets the number of package records.
+public:
+  std::size_t GetSize() const
+  {
+    return header->numPackages;
+  }
+
+  /// Gets the package ID of a package record.
+public:
+  const char* GetPackageId(std::size_t idx) const
+  {
+    return GetString(GetRecord(idx).id);
+  }
+
+  /// @brief Decodes a package record.
+  /// @param idx The index of the package record.
+  /// @param withFiles Indicates whether the file lists should be decoded.
+  /// @return Returns the package record.
+public:
+  MiKTeX::Packages::PackageInfo GetPackage(std::size_t idx, bool withFiles) const;
+
+  /// @brief Decodes the file lists of a package record.
+  /// @param idx The index of the package record.
+  /// @param[out] packageInfo The package record to be completed.
+public:
+  void GetFiles(std::size_t idx, MiKTeX::Packages::PackageInfo& packageInfo) const;
+
+private:
+  PackageManifestsDb() = default;
+
+private:
+  static MiKTeX::Core::PathName GetDbPath(const MiKTeX::Core::PathName& iniPath);
+
+private:
+  bool Attach(const void* ptr, std::size_t size);
+
+private:
+  const PackageManifestsDbRecord& GetRecord(std::size_t idx) const
+  {
+    return reinterpret_cast<const PackageManifestsDbRecord*>(data + header->foPackages)[idx];
+  }
+
+private:
+  const char* GetString(PmdbByteOffset fo) const
+  {
+    return reinterpret_cast<const char*>(data + header->foStrings + fo);
+  }
+
+private:
+  std::vector<std::string> GetList(const PackageManifestsDbList& list) const;
+
+private:
+  const std::uint8_t* data = nullptr;
+
+private:
+  const PackageManifestsDbHeader* header = nullptr;
+
+private:
+  std::unique_ptr<MiKTeX::Core::MemoryMappedFile> mmap;
+
+private:
+  std::vector<std::uint8_t> buffer;
+};
+
+MPM_INTERNAL_END_NAMESPACE;
+
+#endif
@@ -41,6 +41,10 @@ class MIKTEXNOVTABLE WebSession
 public:
   virtual ~WebSession() = 0;
 
+  // reads the configuration; implicitly called by OpenUrl()
+public:
+  virtual void Initialize() = 0;
+
 public:
   virtual std::unique_ptr<WebFile> OpenUrl(const std::string& url) = 0;
 
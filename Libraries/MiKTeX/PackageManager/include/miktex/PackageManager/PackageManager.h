@@ -30,6 +30,7 @@
 
 #include <ctime>
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
@@ -173,6 +174,18 @@ public:
 public:
   virtual bool MIKTEXTHISCALL TryVerifyInstalledPackage(const std::string& packageId) = 0;
 
+  /// @brief Verifies installed packages.
+  ///
+  /// The files of the packages are digested by multiple threads.
+  /// Digests of unchanged files are taken from a cache.
+  ///
+  /// @param packageIds Identifies the packages.
+  /// @param onVerified Optional function to be called when a package
+  /// has been verified. Calls are serialized.
+  /// @return Returns `true`, if all packages are correctly installed.
+public:
+  virtual bool MIKTEXTHISCALL TryVerifyInstalledPackages(const std::vector<std::string>& packageIds, std::function<void(const std::string& packageId, bool ok)> onVerified) = 0;
+
   /// Builds the container path of a package.
   /// @param packageId Identifies the package.
   /// @param useDisplayNames Indicates whether to use user friendly names.
@@ -84,6 +84,15 @@ protected:
 protected:
   unsigned flags = 0;
 
+protected:
+  const unsigned char* view = nullptr;
+
+protected:
+  std::size_t viewSize = 0;
+
+protected:
+  std::size_t viewPosition = 0;
+
 public:
   void AssertValid() const
   {
@@ -99,6 +108,7 @@ public:
     AssertValid();
     FILE* file = this->file;
     this->file = nullptr;
+    DetachView();
     if ((flags & NotOwner) != 0)
     {
       std::shared_ptr<MiKTeX::Core::Session> session = MiKTeX::Core::Session::Get();
@@ -115,6 +125,31 @@ public:
       flags |= NotOwner;
     }
     this->file = file;
+    DetachView();
+  }
+
+  /// Lets read operations take the file contents from memory. The
+  /// file stream is not used for reading until the view is detached.
+public:
+  void AttachView(const void* data, std::size_t size)
+  {
+    view = reinterpret_cast<const unsigned char*>(data);
+    viewSize = size;
+    viewPosition = 0;
+  }
+
+public:
+  void DetachView()
+  {
+    view = nullptr;
+    viewSize = 0;
+    viewPosition = 0;
+  }
+
+public:
+  bool HasView() const
+  {
+    return view != nullptr;
   }
 
 public:
@@ -127,6 +162,7 @@ public:
   FILE*& fileref()
   {
     flags = 0;
+    DetachView();
     return file;
   }
 
@@ -197,6 +233,11 @@ public:
 public:
   bool Eof()
   {
+    if (HasView())
+    {
+      return !IsPascalFileIO() && viewPosition >= viewSize;
+    }
+
     if (feof(file) != 0)
     {
       return true;
@@ -231,6 +272,11 @@ protected:
   {
     AssertValid();
     MIKTEX_ASSERT_BUFFER(buf, n);
+    if (HasView())
+    {
+      ReadView(buf, n * sizeof(ElementType));
+      return;
+    }
     if (feof(*this) != 0)
     {
       MIKTEX_FATAL_ERROR(MIKTEXTEXT("Read operation failed."));
@@ -245,6 +291,33 @@ protected:
     }
   }
 
+protected:
+  void ReadView(void* buf, std::size_t size)
+  {
+    if (size > viewSize - viewPosition)
+    {
+      viewPosition = viewSize;
+      MIKTEX_FATAL_ERROR(MIKTEXTEXT("Read operation failed."));
+    }
+    memcpy(buf, view + viewPosition, size);
+    viewPosition += size;
+  }
+
+  /// Reads bytes without affecting the Pascal file buffer.
+public:
+  void ReadRaw(void* buf, std::size_t size)
+  {
+    AssertValid();
+    if (HasView())
+    {
+      ReadView(buf, size);
+    }
+    else if (fread(buf, 1, size, *this) != size)
+    {
+      MIKTEX_FATAL_CRT_ERROR("fread");
+    }
+  }
+
 public:
   void Read(ElementType* buf, std::size_t n)
   {
@@ -267,6 +340,7 @@ public:
   {
     AssertValid();
     rewind(*this);
+    viewPosition = 0;
     Read();
   }
 
@@ -292,7 +366,16 @@ public:
   void Seek(long offset, int origin)
   {
     AssertValid();
-    if (fseek(*this, offset, origin) != 0)
+    if (HasView())
+    {
+      std::size_t base = origin == SEEK_SET ? 0 : origin == SEEK_CUR ? viewPosition : viewSize;
+      if ((offset < 0 && static_cast<std::size_t>(-offset) > base) || (offset > 0 && static_cast<std::size_t>(offset) > viewSize - base))
+      {
+        MIKTEX_FATAL_ERROR(MIKTEXTEXT("Seek operation failed."));
+      }
+      viewPosition = base + offset;
+    }
+    else if (fseek(*this, offset, origin) != 0)
     {
       MIKTEX_FATAL_CRT_ERROR("fseek");
     }
@@ -778,6 +861,11 @@ template<class T> inline void get(T& f)
 #if 1 // optimization?
 template<> inline void get<BufferedFile<C4P_unsigned8>>(BufferedFile<C4P_unsigned8>& f)
 {
+  if (f.HasView())
+  {
+    f.Read();
+    return;
+  }
   *f = getc(f);
   if (static_cast<int>(*f) == EOF)
   {
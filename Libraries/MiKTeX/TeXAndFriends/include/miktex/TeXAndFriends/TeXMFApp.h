@@ -278,9 +278,25 @@ public:
     }
     f.Attach(file, true);
     f.PascalFileIO(false);
+    std::size_t viewSize;
+    const void* view = GetMemoryDumpFileView(viewSize);
+    if (view != nullptr)
+    {
+      f.AttachView(view, viewSize);
+    }
     return true;
   }
 
+  /// @brief Gets the memory view of the memory dump file.
+  ///
+  /// The memory dump file is mapped into memory when it is opened.
+  /// The view remains valid until the next memory dump file is opened.
+  /// @param[out] size The size (in bytes) of the view.
+  /// @return Returns a pointer to the view, or `nullptr`, if the file
+  /// could not be mapped.
+public:
+  MIKTEXMFTHISAPI(const void*) GetMemoryDumpFileView(std::size_t& size) const;
+
 public:
   template<typename FILE_, typename ELETYPE_> void Dump(FILE_& f, const ELETYPE_& e, std::size_t n)
   {
@@ -300,10 +316,7 @@ public:
   template<typename FILE_, typename ELETYPE_> void Undump(FILE_& f, ELETYPE_& e, std::size_t n)
   {
     f.PascalFileIO(false);
-    if (fread(&e, sizeof(e), n, static_cast<FILE*>(f)) != n)
-    {
-      MIKTEX_FATAL_CRT_ERROR("fread");
-    }
+    f.ReadRaw(&e, sizeof(e) * n);
   }
 
 public:
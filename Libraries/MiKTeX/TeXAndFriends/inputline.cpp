@@ -117,6 +117,14 @@ public:
   TriState allowInput = TriState::Undetermined;
 public:
   TriState allowOutput = TriState::Undetermined;
+public:
+  bool haveEngineIdentity = false;
+public:
+  bool isXeTeX = false;
+public:
+  bool isOmega = false;
+public:
+  bool isBibTeX = false;
 };
 
 WebAppInputLine::WebAppInputLine() :
@@ -133,6 +141,7 @@ void WebAppInputLine::Init(vector<char*>& args)
   WebApp::Init(args);
   pimpl->shellCommandMode = ShellCommandMode::Forbidden;
   pimpl->enablePipes = false;
+  pimpl->haveEngineIdentity = false;
 }
 
 void WebAppInputLine::Finalize()
@@ -656,10 +665,44 @@ void WebAppInputLine::BufferSizeExceeded() const
   }
 }
 
+class StreamLock
+{
+public:
+  StreamLock(FILE* file) :
+    file(file)
+  {
+#if defined(MIKTEX_WINDOWS)
+    _lock_file(file);
+#else
+    flockfile(file);
+#endif
+  }
+public:
+  ~StreamLock()
+  {
+#if defined(MIKTEX_WINDOWS)
+    _unlock_file(file);
+#else
+    funlockfile(file);
+#endif
+  }
+public:
+  StreamLock(const StreamLock& other) = delete;
+public:
+  StreamLock& operator=(const StreamLock& other) = delete;
+private:
+  FILE* file;
+};
+
+// the caller must hold the stream lock
 inline int GetCharacter(FILE* file)
 {
   MIKTEX_ASSERT(file != nullptr);
-  int ch = getc(file);
+#if defined(MIKTEX_WINDOWS)
+  int ch = _getc_nolock(file);
+#else
+  int ch = getc_unlocked(file);
+#endif
   if (ch == EOF)
   {
     if (ferror(file) != 0)
@@ -670,68 +713,40 @@ inline int GetCharacter(FILE* file)
   return ch;
 }
 
-bool WebAppInputLine::InputLine(C4P_text& f, C4P_boolean bypassEndOfLine) const
+// the caller must hold the stream lock
+inline void UngetCharacter(int ch, FILE* file)
 {
-  f.AssertValid();
-
-  if (AmI("xetex"))
-  {
-    MIKTEX_UNEXPECTED();
-  }
-
-#if defined(PASCAL_TEXT_IO)
-  MIKTEX_UNEXPECTED();
-#endif
-
-  if (feof(f) != 0)
-  {
-    return false;
-  }
-
-  IInputOutput* inputOutput = GetInputOutput();
-
-  const C4P_signed32 first = inputOutput->first();
-  C4P_signed32& last = inputOutput->last();
-  const C4P_signed32 bufsize = inputOutput->bufsize();
-
-  const char* xord = nullptr;
-#if defined(WITH_OMEGA)
-  if (!AmI("omega"))
+#if defined(MIKTEX_WINDOWS)
+  _ungetc_nolock(ch, file);
+#else
+  ungetc(ch, file);
 #endif
-  {
-    xord = GetCharacterConverter()->xord();
-  }
+}
 
-  char *buffer = nullptr;
-#if defined(WITH_OMEGA)
-  char16_t* buffer16 = nullptr;
-  if (AmI("omega"))
-  {
-    buffer16 = inputOutput->buffer16();
-  }
-  else
-#endif
-  {
-    buffer = inputOutput->buffer();
-  }
+// reads the characters of a line into buffer[first..last); returns
+// false, if the end of the file has been reached; ch receives the
+// character which terminated the line
+template<typename CharType> bool ReadLine(FILE* file, CharType* buffer, C4P_signed32 first, C4P_signed32& last, C4P_signed32 bufsize, int& ch)
+{
+  StreamLock lock(file);
 
   last = first;
 
-  int ch = GetCharacter(f);
+  ch = GetCharacter(file);
   if (ch == EOF)
   {
     return false;
   }
   if (ch == '\r')
   {
-    ch = GetCharacter(f);
+    ch = GetCharacter(file);
     if (ch == EOF)
     {
       return false;
     }
     if (ch != '\n')
     {
-      ungetc(ch, f);
+      UngetCharacter(ch, file);
       ch = '\n';
     }
   }
@@ -741,30 +756,21 @@ bool WebAppInputLine::InputLine(C4P_text& f, C4P_boolean bypassEndOfLine) const
     return true;
   }
 
-#if defined(WITH_OMEGA)
-  if (AmI("omega"))
-  {
-    buffer16[last] = ch;
-  }
-  else
-#endif
-  {
-    buffer[last] = xord[ch & 0xff];
-  }
+  buffer[last] = static_cast<CharType>(ch);
   last += 1;
 
-  while ((ch = GetCharacter(f)) != EOF && last < bufsize)
+  while ((ch = GetCharacter(file)) != EOF && last < bufsize)
   {
     if (ch == '\r')
     {
-      ch = GetCharacter(f);
+      ch = GetCharacter(file);
       if (ch == EOF)
       {
         break;
       }
       if (ch != '\n')
       {
-        ungetc(ch, f);
+        UngetCharacter(ch, file);
         ch = '\n';
       }
     }
@@ -772,17 +778,77 @@ bool WebAppInputLine::InputLine(C4P_text& f, C4P_boolean bypassEndOfLine) const
     {
       break;
     }
+    buffer[last] = static_cast<CharType>(ch);
+    last += 1;
+  }
+
+  return true;
+}
+
+bool WebAppInputLine::InputLine(C4P_text& f, C4P_boolean bypassEndOfLine) const
+{
+  f.AssertValid();
+
+  if (!pimpl->haveEngineIdentity)
+  {
+    pimpl->isXeTeX = AmI("xetex");
 #if defined(WITH_OMEGA)
-    if (AmI("omega"))
+    pimpl->isOmega = AmI("omega");
+#endif
+    pimpl->isBibTeX = AmI("bibtex");
+    pimpl->haveEngineIdentity = true;
+  }
+
+  if (pimpl->isXeTeX)
+  {
+    MIKTEX_UNEXPECTED();
+  }
+
+#if defined(PASCAL_TEXT_IO)
+  MIKTEX_UNEXPECTED();
+#endif
+
+  if (feof(f) != 0)
+  {
+    return false;
+  }
+
+  IInputOutput* inputOutput = GetInputOutput();
+
+  const C4P_signed32 first = inputOutput->first();
+  C4P_signed32& last = inputOutput->last();
+  const C4P_signed32 bufsize = inputOutput->bufsize();
+
+  int ch;
+
+#if defined(WITH_OMEGA)
+  char16_t* buffer16 = nullptr;
+  if (pimpl->isOmega)
+  {
+    buffer16 = inputOutput->buffer16();
+    if (!ReadLine(f, buffer16, first, last, bufsize, ch))
     {
-      buffer16[last] = ch;
+      return false;
     }
-    else
+  }
+  else
 #endif
+  {
+    char* buffer = inputOutput->buffer();
+    if (!ReadLine(f, buffer, first, last, bufsize, ch))
+    {
+      return false;
+    }
+    const char* xord = GetCharacterConverter()->xord();
+    for (C4P_signed32 idx = first; idx < last; ++idx)
     {
-      buffer[last] = xord[ch & 0xff];
+      buffer[idx] = xord[static_cast<unsigned char>(buffer[idx])];
     }
-    last += 1;
+  }
+
+  if (ch == '\n' && last == first)
+  {
+    return true;
   }
 
   if (ch != '\n' && ch != EOF)
@@ -790,7 +856,7 @@ bool WebAppInputLine::InputLine(C4P_text& f, C4P_boolean bypassEndOfLine) const
     BufferSizeExceeded();
   }
 
-  if (!AmI("bibtex") && last >= inputOutput->maxbufstack())
+  if (!pimpl->isBibTeX && last >= inputOutput->maxbufstack())
   {
     inputOutput->maxbufstack() = last + 1;
     if (inputOutput->maxbufstack() >= bufsize)
@@ -800,7 +866,7 @@ bool WebAppInputLine::InputLine(C4P_text& f, C4P_boolean bypassEndOfLine) const
   }
 
 #if defined(WITH_OMEGA)
-  if (AmI("omega"))
+  if (pimpl->isOmega)
   {
     while (last > first && (buffer16[last - 1] == u' ' || buffer16[last - 1] == u'\r'))
     {
@@ -810,6 +876,7 @@ bool WebAppInputLine::InputLine(C4P_text& f, C4P_boolean bypassEndOfLine) const
   else
 #endif
   {
+    char* buffer = inputOutput->buffer();
     while (last > first && (buffer[last - 1] == ' ' || buffer[last - 1] == '\r'))
     {
       last -= 1;
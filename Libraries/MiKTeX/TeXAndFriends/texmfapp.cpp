@@ -19,8 +19,11 @@
    Software Foundation, 59 Temple Place - Suite 330, Boston, MA
    02111-1307, USA. */
 
+#include <zlib.h>
+
 #include <miktex/Core/ConfigNames>
 #include <miktex/Core/Directory>
+#include <miktex/Core/MemoryMappedFile>
 #include <miktex/Core/Paths>
 #include <miktex/Core/StreamReader>
 
@@ -40,6 +43,8 @@ public:
   unique_ptr<TraceStream> trace_time;
 public:
   clock_t clockStart;
+public:
+  time_t jobStartTime;
 public:
   bool timeStatistics;
 public:
@@ -70,6 +75,10 @@ public:
   ITeXMFMemoryHandler* memoryHandler = nullptr;
 public:
   UserParams userParams;
+public:
+  unique_ptr<MemoryMappedFile> memoryDumpFileView;
+public:
+  vector<unsigned char> uncompressedMemoryDumpFile;
 };
 
 TeXMFApp::TeXMFApp() :
@@ -153,6 +162,9 @@ void TeXMFApp::Finalize()
   }
   pimpl->memoryDumpFileName = "";
   pimpl->jobName = "";
+  pimpl->memoryDumpFileView = nullptr;
+  pimpl->uncompressedMemoryDumpFile.clear();
+  pimpl->uncompressedMemoryDumpFile.shrink_to_fit();
   WebAppInputLine::Finalize();
 }
 
@@ -172,23 +184,120 @@ void TeXMFApp::OnTeXMFStartJob()
   pimpl->parseFirstLine = session->GetConfigValue("", MIKTEX_REGVAL_PARSE_FIRST_LINE, AmITeX()).GetBool();
   pimpl->showFileLineErrorMessages = session->GetConfigValue(MIKTEX_CONFIG_SECTION_TEXANDFRIENDS, MIKTEX_CONFIG_VALUE_CSTYLEERRORS).GetBool();
   pimpl->clockStart = clock();
+  pimpl->jobStartTime = time(nullptr);
 }
 
-void TeXMFApp::OnTeXMFFinishJob()
+constexpr size_t GZIP_HEADER_SIZE = 10;
+
+static bool IsGzipped(const void* data, size_t size)
 {
-  if (pimpl->recordFileNames)
+  const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+  return size >= GZIP_HEADER_SIZE && bytes[0] == 0x1f && bytes[1] == 0x8b && bytes[2] == Z_DEFLATED;
+}
+
+static vector<unsigned char> Gunzip(const void* data, size_t size)
+{
+  const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+  vector<unsigned char> result;
+  // the gzip trailer contains the uncompressed size (modulo 2^32); it
+  // comes from the file, so it only serves as a hint for the first
+  // allocation
+  uint32_t expectedSize = bytes[size - 4] | (bytes[size - 3] << 8) | (bytes[size - 2] << 16) | (static_cast<uint32_t>(bytes[size - 1]) << 24);
+  result.resize(std::min(std::max(static_cast<size_t>(expectedSize), size), 8 * size));
+  z_stream zs;
+  memset(&zs, 0, sizeof(zs));
+  if (inflateInit2(&zs, 15 + 16) != Z_OK)
+  {
+    MIKTEX_UNEXPECTED();
+  }
+  zs.next_in = const_cast<Bytef*>(bytes);
+  zs.avail_in = static_cast<uInt>(size);
+  int ret;
+  do
   {
-    string fileName;
-    if (pimpl->jobName.length() > 2 && pimpl->jobName.front() == '"' && pimpl->jobName.back() == '"')
+    if (zs.total_out == result.size())
     {
-      fileName = pimpl->jobName.substr(1, pimpl->jobName.length() - 2);
+      result.resize(2 * result.size());
     }
-    else
+    zs.next_out = &result[zs.total_out];
+    zs.avail_out = static_cast<uInt>(result.size() - zs.total_out);
+    ret = inflate(&zs, Z_NO_FLUSH);
+  } while (ret == Z_OK);
+  result.resize(zs.total_out);
+  inflateEnd(&zs);
+  if (ret != Z_STREAM_END)
+  {
+    MIKTEX_FATAL_ERROR_2(T_("The memory dump file is corrupted."), "ret", std::to_string(ret));
+  }
+  if (static_cast<uint32_t>(result.size()) != expectedSize)
+  {
+    MIKTEX_FATAL_ERROR_2(T_("The memory dump file is corrupted."), "size", std::to_string(result.size()), "expectedSize", std::to_string(expectedSize));
+  }
+  return result;
+}
+
+static void GzipFile(const PathName& path)
+{
+  vector<unsigned char> data = File::ReadAllBytes(path);
+  if (IsGzipped(data.data(), data.size()))
+  {
+    return;
+  }
+  z_stream zs;
+  memset(&zs, 0, sizeof(zs));
+  if (deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+  {
+    MIKTEX_UNEXPECTED();
+  }
+  vector<unsigned char> compressed(deflateBound(&zs, static_cast<uLong>(data.size())));
+  zs.next_in = data.data();
+  zs.avail_in = static_cast<uInt>(data.size());
+  zs.next_out = compressed.data();
+  zs.avail_out = static_cast<uInt>(compressed.size());
+  int ret = deflate(&zs, Z_FINISH);
+  compressed.resize(zs.total_out);
+  deflateEnd(&zs);
+  if (ret != Z_STREAM_END)
+  {
+    MIKTEX_UNEXPECTED();
+  }
+  PathName dir(path);
+  dir.RemoveFileSpec();
+  PathName tempFile;
+  tempFile.SetToTempFile(dir.Empty() ? PathName().SetToCurrentDirectory() : dir);
+  File::WriteBytes(tempFile, compressed);
+  File::Move(tempFile, path, { FileMoveOption::ReplaceExisting });
+}
+
+void TeXMFApp::OnTeXMFFinishJob()
+{
+  string fileName;
+  if (pimpl->jobName.length() > 2 && pimpl->jobName.front() == '"' && pimpl->jobName.back() == '"')
+  {
+    fileName = pimpl->jobName.substr(1, pimpl->jobName.length() - 2);
+  }
+  else
+  {
+    fileName = pimpl->jobName;
+  }
+  shared_ptr<Session> session = GetSession();
+  if (pimpl->recordFileNames)
+  {
+    session->SetRecorderPath(PathName(GetOutputDirectory(), fileName).AppendExtension(".fls"));
+  }
+  if (IsInitProgram() && !fileName.empty() && session->GetConfigValue(MIKTEX_CONFIG_SECTION_TEXANDFRIENDS, MIKTEX_CONFIG_VALUE_COMPRESSMEMORYDUMPFILES).GetBool())
+  {
+    PathName dumpFile = PathName(GetOutputDirectory(), fileName).AppendExtension(GetMemoryDumpFileExtension());
+    // only compress a dump file written by this job: a failed run
+    // leaves a stale file from an earlier run behind
+    IInitFinalize* initFinalize = GetInitFinalize();
+    const C4P::C4P_signed8 fatalErrorStop = 3;
+    bool succeeded = initFinalize == nullptr || initFinalize->history() < fatalErrorStop;
+    if (succeeded && File::Exists(dumpFile) && File::GetLastWriteTime(dumpFile) >= pimpl->jobStartTime)
     {
-      fileName = pimpl->jobName;
+      LogInfo("compressing memory dump file "s + Q_(dumpFile));
+      GzipFile(dumpFile);
     }
-    shared_ptr<Session> session = GetSession();
-    session->SetRecorderPath(PathName(GetOutputDirectory(), fileName).AppendExtension(".fls"));
   }
   if (pimpl->timeStatistics)
   {
@@ -699,6 +808,52 @@ bool TeXMFApp::OpenMemoryDumpFile(const PathName& fileName_, FILE** ppFile, void
     }
   }
 
+  // map the file, so that the undump operations do not need to go
+  // through the stream; the pages are shared by all processes loading
+  // the same file
+  if (pimpl->memoryDumpFileView != nullptr)
+  {
+    pimpl->memoryDumpFileView->Close();
+  }
+  pimpl->memoryDumpFileView = nullptr;
+  pimpl->uncompressedMemoryDumpFile.clear();
+  if (pBuf == nullptr)
+  {
+    try
+    {
+      unique_ptr<MemoryMappedFile> view(MemoryMappedFile::Create());
+      view->Open(path, false);
+      pimpl->memoryDumpFileView = std::move(view);
+    }
+    catch (const MiKTeXException& e)
+    {
+      LogWarn("memory dump file cannot be mapped: " + e.GetErrorMessage());
+    }
+    // compressed memory dump files are uncompressed at once; the
+    // undump operations then read from the uncompressed data
+    if (pimpl->memoryDumpFileView != nullptr)
+    {
+      const void* data = pimpl->memoryDumpFileView->GetPtr();
+      size_t size = pimpl->memoryDumpFileView->GetSize();
+      if (IsGzipped(data, size))
+      {
+        pimpl->uncompressedMemoryDumpFile = Gunzip(data, size);
+        pimpl->memoryDumpFileView->Close();
+        pimpl->memoryDumpFileView = nullptr;
+      }
+    }
+    else
+    {
+      unsigned char header[GZIP_HEADER_SIZE];
+      if (stream.Read(header, sizeof(header)) == sizeof(header) && IsGzipped(header, sizeof(header)))
+      {
+        vector<unsigned char> data = File::ReadAllBytes(path);
+        pimpl->uncompressedMemoryDumpFile = Gunzip(data.data(), data.size());
+      }
+      stream.Seek(0, SeekOrigin::Begin);
+    }
+  }
+
   session->PushAppName(dumpName);
 
   *ppFile = stream.Detach();
@@ -706,6 +861,22 @@ bool TeXMFApp::OpenMemoryDumpFile(const PathName& fileName_, FILE** ppFile, void
   return true;
 }
 
+const void* TeXMFApp::GetMemoryDumpFileView(size_t& size) const
+{
+  if (!pimpl->uncompressedMemoryDumpFile.empty())
+  {
+    size = pimpl->uncompressedMemoryDumpFile.size();
+    return pimpl->uncompressedMemoryDumpFile.data();
+  }
+  if (pimpl->memoryDumpFileView == nullptr)
+  {
+    size = 0;
+    return nullptr;
+  }
+  size = pimpl->memoryDumpFileView->GetSize();
+  return pimpl->memoryDumpFileView->GetPtr();
+}
+
 void TeXMFApp::ProcessCommandLineOptions()
 {
   if (StringUtil::Contains(GetInitProgramName().c_str(), Utils::GetExeName().c_str()))
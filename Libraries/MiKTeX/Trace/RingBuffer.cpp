@@ -0,0 +1,235 @@
+/* RingBuffer.cpp: in-memory trace buffers
+
+   Copyright (C) 2018 Christian Schenk
+
+   This file is part of the MiKTeX Trace Library.
+
+   The MiKTeX Trace Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+
+   The MiKTeX Trace Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with the MiKTeX Trace Library; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#if defined(MIKTEX_TRACE_SHARED)
+#  define MIKTEXTRACEEXPORT MIKTEXDLLEXPORT
+#else
+#  define MIKTEXTRACEEXPORT
+#endif
+
+#include <miktex/Util/StringUtil>
+
+#define DE9EF9059C8744B48A68345CD5A8A2C8
+#include <miktex/Trace/config.h>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#if defined(MIKTEX_WINDOWS)
+#include <io.h>
+#include <process.h>
+#else
+#include <signal.h>
+#include <unistd.h>
+#endif
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+
+#include "RingBuffer.h"
+
+using namespace MiKTeX::Util;
+using namespace std;
+
+struct ThreadBuffer
+{
+  ThreadBuffer* next = nullptr;
+  atomic_bool inUse{ true };
+  uint64_t size = 0;
+  atomic<uint64_t> oldest{ 0 };
+  atomic<uint64_t> written{ 0 };
+  unsigned char* data = nullptr;
+};
+
+// releases the buffer of a terminating thread, so that it can be
+// reused by another thread; the contents are kept
+class ThreadBufferHolder
+{
+public:
+  ~ThreadBufferHolder()
+  {
+    if (buffer != nullptr)
+    {
+      buffer->inUse = false;
+    }
+  }
+
+public:
+  ThreadBuffer* buffer = nullptr;
+};
+
+constexpr size_t HEADER_LENGTH = 4 + 8 + 1 + 1;
+constexpr size_t MIN_BUFFER_SIZE = 1024 * 4;
+
+atomic_bool RingBuffer::enabled{ false };
+
+// buffers are never freed: the dump may be written at any time
+static atomic<ThreadBuffer*> buffers{ nullptr };
+static size_t bufferSize = 0;
+static thread_local ThreadBufferHolder threadBuffer;
+
+#if defined(MIKTEX_WINDOWS)
+static wstring dumpFileName;
+#else
+static string dumpFileName;
+#endif
+
+static ThreadBuffer* AcquireBuffer()
+{
+  for (ThreadBuffer* buffer = buffers.load(); buffer != nullptr; buffer = buffer->next)
+  {
+    bool inUse = false;
+    if (buffer->inUse.compare_exchange_strong(inUse, true))
+    {
+      return buffer;
+    }
+  }
+  ThreadBuffer* buffer = new ThreadBuffer();
+  buffer->size = bufferSize;
+  buffer->data = new unsigned char[bufferSize];
+  buffer->next = buffers.load();
+  while (!buffers.compare_exchange_weak(buffer->next, buffer))
+  {
+  }
+  return buffer;
+}
+
+static void CopyIn(ThreadBuffer* buffer, uint64_t pos, const void* data, size_t count)
+{
+  size_t offset = pos % buffer->size;
+  size_t num1 = std::min(count, static_cast<size_t>(buffer->size - offset));
+  memcpy(buffer->data + offset, data, num1);
+  memcpy(buffer->data, static_cast<const unsigned char*>(data) + num1, count - num1);
+}
+
+static void CopyOut(const ThreadBuffer* buffer, uint64_t pos, void* data, size_t count)
+{
+  size_t offset = pos % buffer->size;
+  size_t num1 = std::min(count, static_cast<size_t>(buffer->size - offset));
+  memcpy(data, buffer->data + offset, num1);
+  memcpy(static_cast<unsigned char*>(data) + num1, buffer->data, count - num1);
+}
+
+#if !defined(MIKTEX_WINDOWS)
+static void OnSignal(int sig)
+{
+  RingBuffer::Dump();
+}
+#endif
+
+static void OnExit()
+{
+  RingBuffer::Dump();
+}
+
+void RingBuffer::Enable(const string& dumpFileName, size_t sizePerThread)
+{
+  static once_flag initialized;
+  call_once(initialized, [&]() {
+    // concurrent processes must not truncate each other's dump
+#if defined(MIKTEX_WINDOWS)
+    ::dumpFileName = StringUtil::UTF8ToWideChar(dumpFileName + "." + std::to_string(_getpid()));
+#else
+    ::dumpFileName = dumpFileName + "." + std::to_string(getpid());
+#endif
+    bufferSize = std::max(sizePerThread, MIN_BUFFER_SIZE);
+    atexit(OnExit);
+#if !defined(MIKTEX_WINDOWS)
+    struct sigaction action;
+    if (sigaction(SIGUSR1, nullptr, &action) == 0 && action.sa_handler == SIG_DFL)
+    {
+      memset(&action, 0, sizeof(action));
+      action.sa_handler = OnSignal;
+      sigemptyset(&action.sa_mask);
+      action.sa_flags = SA_RESTART;
+      sigaction(SIGUSR1, &action, nullptr);
+    }
+#endif
+    enabled = true;
+  });
+}
+
+void RingBuffer::Write(const string& name, const string& facility, const string& message)
+{
+  if (threadBuffer.buffer == nullptr)
+  {
+    threadBuffer.buffer = AcquireBuffer();
+  }
+  ThreadBuffer* buffer = threadBuffer.buffer;
+  uint8_t nameLength = static_cast<uint8_t>(std::min(name.length(), static_cast<size_t>(UINT8_MAX)));
+  uint8_t facilityLength = static_cast<uint8_t>(std::min(facility.length(), static_cast<size_t>(UINT8_MAX)));
+  size_t messageLength = std::min(message.length(), static_cast<size_t>(buffer->size - HEADER_LENGTH - nameLength - facilityLength));
+  uint32_t length = static_cast<uint32_t>(HEADER_LENGTH + nameLength + facilityLength + messageLength);
+  uint64_t written = buffer->written.load(memory_order_relaxed);
+  uint64_t oldest = buffer->oldest.load(memory_order_relaxed);
+  while (written + length - oldest > buffer->size)
+  {
+    uint32_t oldLength;
+    CopyOut(buffer, oldest, &oldLength, sizeof(oldLength));
+    oldest += oldLength;
+  }
+  buffer->oldest.store(oldest, memory_order_release);
+  uint64_t time = chrono::duration_cast<chrono::microseconds>(chrono::system_clock::now().time_since_epoch()).count();
+  unsigned char header[HEADER_LENGTH];
+  memcpy(header, &length, 4);
+  memcpy(header + 4, &time, 8);
+  header[12] = nameLength;
+  header[13] = facilityLength;
+  CopyIn(buffer, written, header, HEADER_LENGTH);
+  written += HEADER_LENGTH;
+  CopyIn(buffer, written, name.c_str(), nameLength);
+  written += nameLength;
+  CopyIn(buffer, written, facility.c_str(), facilityLength);
+  written += facilityLength;
+  CopyIn(buffer, written, message.c_str(), messageLength);
+  written += messageLength;
+  buffer->written.store(written, memory_order_release);
+}
+
+// only uses async-signal-safe functions
+void RingBuffer::Dump() noexcept
+{
+  static const char magic[] = "MIKTEXTRACERING1";
+#if defined(MIKTEX_WINDOWS)
+  int fd = _wopen(dumpFileName.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+  int fd = open(dumpFileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+#endif
+  if (fd < 0)
+  {
+    return;
+  }
+  bool ok = write(fd, magic, 16) == 16;
+  for (const ThreadBuffer* buffer = buffers.load(); ok && buffer != nullptr; buffer = buffer->next)
+  {
+    uint64_t header[3];
+    header[0] = buffer->size;
+    header[2] = buffer->written.load(memory_order_acquire);
+    header[1] = buffer->oldest.load(memory_order_acquire);
+    ok = write(fd, header, sizeof(header)) == sizeof(header)
+      && write(fd, buffer->data, static_cast<unsigned>(buffer->size)) == static_cast<int>(buffer->size);
+  }
+  close(fd);
+}
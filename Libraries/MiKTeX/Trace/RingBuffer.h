@@ -0,0 +1,71 @@
+/* RingBuffer.h: in-memory trace buffers
+
+   Copyright (C) 2018 Christian Schenk
+
+   This file is part of the MiKTeX Trace Library.
+
+   The MiKTeX Trace Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+
+   The MiKTeX Trace Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with the MiKTeX Trace Library; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#pragma once
+
+#include <cstddef>
+
+#include <atomic>
+#include <string>
+
+// Trace messages are kept in per-thread ring buffers.  Only the owning
+// thread writes to a buffer, so writing needs neither locks nor
+// atomic read-modify-write operations.  The buffers are written to
+// the dump file (the given name plus "." and the process ID) when the
+// process exits or (Unix) receives SIGUSR1.
+//
+// Dump file layout (all integers in host byte order):
+//
+//   "MIKTEXTRACERING1"                 16 bytes
+//   for each thread buffer:
+//     uint64_t size                    size of the buffer
+//     uint64_t oldest                  position of the oldest record
+//     uint64_t written                 position after the newest record
+//     size bytes                       buffer contents
+//
+// Positions grow monotonically and are taken modulo size.  A record
+// consists of
+//
+//   uint32_t length                    length of the whole record
+//   uint64_t time                      microseconds since the epoch
+//   uint8_t nameLength                 length of the trace stream name
+//   uint8_t facilityLength             length of the facility
+//   name, facility, message            (not null-terminated)
+class RingBuffer
+{
+public:
+  static void Enable(const std::string& dumpFileName, std::size_t sizePerThread);
+
+public:
+  static bool IsEnabled()
+  {
+    return enabled.load(std::memory_order_relaxed);
+  }
+
+public:
+  static void Write(const std::string& name, const std::string& facility, const std::string& message);
+
+public:
+  static void Dump() noexcept;
+
+private:
+  static std::atomic_bool enabled;
+};
@@ -47,6 +47,8 @@
 #include <unordered_map>
 #include <vector>
 
+#include "RingBuffer.h"
+
 using namespace MiKTeX::Trace;
 using namespace MiKTeX::Util;
 using namespace std;
@@ -165,10 +167,20 @@ vector<string> TraceStreamImpl::options;
 
 void TraceStreamImpl::Logger(const string& facility, const string& message, bool appendNewline)
 {
+  // the ring buffer replaces the legacy logger; trace callbacks (e.g.,
+  // for the error stream) are still called
+  bool haveRingBuffer = RingBuffer::IsEnabled();
+  if (haveRingBuffer)
+  {
+    RingBuffer::Write(info->name, facility, message);
+  }
 #if ENABLE_LEGACY_TRACING
   if (info->callbacks.size() == 0)
   {
-    LegacyLogger(facility, message, appendNewline);
+    if (!haveRingBuffer)
+    {
+      LegacyLogger(facility, message, appendNewline);
+    }
     return;
   }
 #endif
@@ -180,6 +192,20 @@ void TraceStreamImpl::Logger(const string& facility, const string& message, bool
 
 #if ENABLE_LEGACY_TRACING
 
+#if defined(MIKTEX_WINDOWS)
+static string GetModuleName()
+{
+  wchar_t szPath[_MAX_PATH];
+  if (GetModuleFileNameW(nullptr, szPath, _MAX_PATH) == 0)
+  {
+    return "";
+  }
+  wchar_t szName[_MAX_PATH];
+  _wsplitpath_s(szPath, nullptr, 0, nullptr, 0, szName, _MAX_PATH, nullptr, 0);
+  return StringUtil::WideCharToUTF8(szName);
+}
+#endif
+
 void TraceStreamImpl::LegacyLogger(const string& facility, const string& message, bool appendNewline)
 {
   string str;
@@ -187,17 +213,8 @@ void TraceStreamImpl::LegacyLogger(const string& facility, const string& message
   str += std::to_string(clock());
   str += " [";
 #if defined(MIKTEX_WINDOWS)
-  wchar_t szPath[_MAX_PATH];
-  if (GetModuleFileNameW(nullptr, szPath, _MAX_PATH) != 0)
-  {
-    wchar_t szName[_MAX_PATH];
-#if 0
-    PathName(szPath).GetFileNameWithoutExtension(szName);
-#else
-    _wsplitpath_s(szPath, nullptr, 0, nullptr, 0, szName, _MAX_PATH, nullptr, 0);
-#endif
-    str += StringUtil::WideCharToUTF8(szName);
-  }
+  static const string moduleName = GetModuleName();
+  str += moduleName;
 #endif
   str += '.';
   if (!facility.empty())
@@ -322,6 +339,19 @@ void TraceStreamImpl::VTrace(const string& facility, const string& format, va_li
   FormatV(facility, true, format, arglist);
 }
 
+void TraceStream::EnableRingBuffer(const string& dumpFileName, size_t sizePerThread)
+{
+  RingBuffer::Enable(dumpFileName, sizePerThread);
+}
+
+void TraceStream::DumpRingBuffer()
+{
+  if (RingBuffer::IsEnabled())
+  {
+    RingBuffer::Dump();
+  }
+}
+
 unique_ptr<TraceStream> TraceStream::Open(const string& name, TraceCallback* callback)
 {
   lock_guard<mutex> lockGuard(TraceStreamImpl::traceStreamsMutex);
@@ -366,5 +396,5 @@ void TraceStreamImpl::Close()
 
 bool TraceStreamImpl::IsEnabled(const string& facility)
 {
-  return this->info->isEnabled || find(this->info->enabledFor.begin(), this->info->enabledFor.end(), facility) != this->info->enabledFor.end();
+  return this->info->isEnabled || (!this->info->enabledFor.empty() && find(this->info->enabledFor.begin(), this->info->enabledFor.end(), facility) != this->info->enabledFor.end());
 }
@@ -26,6 +26,8 @@
 
 #include "config.h"
 
+#include <cstddef>
+
 #include <memory>
 #include <string>
 #include <vector>
@@ -59,6 +61,20 @@ public:
 public:
   static MIKTEXTRACECEEAPI(void) SetOptions(const std::vector<std::string>& options);
 
+  /// Keeps trace messages in per-thread in-memory ring buffers instead
+  /// of writing them out. Trace callbacks are still called. The buffers
+  /// are written to a binary dump file when the process exits or (Unix)
+  /// receives SIGUSR1.
+  /// @param dumpFileName The path name of the dump file; a dot and the
+  /// process ID are appended.
+  /// @param sizePerThread The size (in bytes) of each ring buffer.
+public:
+  static MIKTEXTRACECEEAPI(void) EnableRingBuffer(const std::string& dumpFileName, std::size_t sizePerThread);
+
+  /// Writes the ring buffers to the dump file now.
+public:
+  static MIKTEXTRACECEEAPI(void) DumpRingBuffer();
+
 public:
   static MIKTEXTRACECEEAPI(void) SetOptions(const std::string& options);
 
@@ -84,4 +100,16 @@ public:
 
 MIKTEX_TRACE_END_NAMESPACE;
 
+/// Writes a line to a trace stream. The text is only evaluated if the
+/// trace stream is enabled for the facility.
+#define MIKTEX_TRACE_WRITE_LINE(traceStream, facility, text)      \
+  do                                                              \
+  {                                                               \
+    if ((traceStream)->IsEnabled(facility))                       \
+    {                                                             \
+      (traceStream)->WriteLine(facility, text);                   \
+    }                                                             \
+  }                                                               \
+  while (false)
+
 #endif
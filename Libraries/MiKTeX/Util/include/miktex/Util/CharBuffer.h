@@ -40,20 +40,24 @@ MIKTEX_UTIL_BEGIN_NAMESPACE;
 template<typename CharType, int BUFSIZE = 512> class CharBuffer
 {
 public:
-  CharBuffer() = default;
+  CharBuffer()
+  {
+    Clear();
+  }
 
 public:
   CharBuffer(const CharBuffer& other)
   {
+    Clear();
     Set(other);
   }
 
 public:
-  CharBuffer(CharBuffer&& other)
+  CharBuffer(CharBuffer&& other) noexcept
   {
     if (other.buffer == other.smallBuffer)
     {
-      memcpy(this->smallBuffer, other.smallBuffer, BUFSIZE);
+      memcpy(this->smallBuffer, other.smallBuffer, other.GetUsedSize() * sizeof(CharType));
       this->buffer = this->smallBuffer;
     }
     else
@@ -74,14 +78,14 @@ public:
   }
 
 public:
-  CharBuffer& operator=(CharBuffer&& other)
+  CharBuffer& operator=(CharBuffer&& other) noexcept
   {
     if (this != &other)
     {
       Reset();
       if (other.buffer == other.smallBuffer)
       {
-        memcpy(this->smallBuffer, other.smallBuffer, BUFSIZE);
+        memcpy(this->smallBuffer, other.smallBuffer, other.GetUsedSize() * sizeof(CharType));
         this->buffer = this->smallBuffer;
       }
       else
@@ -156,8 +160,9 @@ public:
   {
     if (this != &other)
     {
-      Reserve(other.capacity);
-      memcpy(this->buffer, other.buffer, other.capacity * sizeof(CharType));
+      std::size_t n = other.GetUsedSize();
+      Reserve(n);
+      memcpy(this->buffer, other.buffer, n * sizeof(CharType));
     }
   }
 
@@ -259,7 +264,7 @@ public:
     if (newSize > BUFSIZE && newSize > capacity)
     {
       CharType* newBuffer = new CharType[newSize];
-      memcpy(newBuffer, buffer, capacity * sizeof(CharType));
+      memcpy(newBuffer, buffer, GetUsedSize() * sizeof(CharType));
       if (buffer != smallBuffer)
       {
         delete[] buffer;
@@ -306,6 +311,15 @@ public:
     return capacity;
   }
 
+  // number of characters to be copied, including the terminating null
+  // character if there is one
+private:
+  std::size_t GetUsedSize() const
+  {
+    std::size_t len = GetLength();
+    return len < capacity ? len + 1 : capacity;
+  }
+
 public:
   const CharType& operator[](std::size_t idx) const
   {
@@ -355,8 +369,9 @@ public:
     return *this;
   }
 
+  // not initialized: only the used part is ever read
 private:
-  CharType smallBuffer[BUFSIZE] = { 0 };
+  CharType smallBuffer[BUFSIZE];
 
 private:
   CharType* buffer = smallBuffer;
@@ -387,6 +387,7 @@ void DrawPages(void)
       page_flags = 0;
       dvi_pos=NextPPage(dvi,dvi_pos);
     }
+    FinishImage();
     Message(BE_NONQUIET,"\n");
     ClearPpList();
   }
@@ -55,6 +55,8 @@ static unsigned char fgetc_follow(FILE* fp)
   int got=fgetc(fp),nsleep=1;
 
   while(followmode && got==EOF) {
+    /* Report the last page while waiting for the next */
+    FinishImage();
     USLEEP(nsleep/1310); /* After a few trials, poll every 65536/1310=50 usec */
     clearerr(fp);
     got=fgetc(fp);
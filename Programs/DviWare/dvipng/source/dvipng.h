@@ -205,6 +205,7 @@ bool    MmapFile (char *filename,struct filemmap *fmmap);
 void    UnMmapFile(struct filemmap* fmmap);
 
 void    Message(int, const char *fmt, ...);
+void    HoldMessages(bool);
 void    Warning(const char *fmt, ...);
 void    Fatal(const char *fmt, ...);
 
@@ -345,6 +346,7 @@ void      DestroyImage(void);
 void      DrawCommand(unsigned char*, void* /* dvi/vf */);
 void      DrawPages(void);
 void      WriteImage(char*, int);
+void      FinishImage(void);
 void      LoadPK(int32_t, register struct char_entry *);
 int32_t   SetChar(int32_t);
 dviunits  SetGlyph(struct char_entry *ptr, int32_t hh,int32_t vv);
@@ -409,6 +411,7 @@ EXTERN struct internal_state {
 #define BG_TRANSPARENT_ALPHA         (1<<17)
 #define FORCE_PALETTE                (1<<18)
 #define NO_RAW_PS                    (1<<19)
+#define PIPELINE_OUTPUT              (1<<20)
 EXTERN uint32_t option_flags INIT(BE_NONQUIET | USE_FREETYPE);
 
 #define PAGE_GAVE_WARN               1
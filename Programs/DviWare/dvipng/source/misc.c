@@ -43,6 +43,11 @@
 
 static char *programname;
 
+/* Messages held back while an image is written in the background */
+static bool holdmessages=false;
+static char *heldmessages=NULL;
+static size_t heldlength=0, heldsize=0;
+
 /*-->DecodeArgs*/
 /*********************************************************************/
 /***************************** DecodeArgs ****************************/
@@ -381,6 +386,14 @@ bool DecodeArgs(int argc, char ** argv)
 	    option_flags &= ~MODE_PICKY;
 	    Message(PARSE_STDIN,"Images output even for pages with warnings\n");
 	  }
+	} else if (strncmp(p,"ipeline",7)==0) {
+	  if (p[7] != '0') {
+	    option_flags |= PIPELINE_OUTPUT;
+	    Message(PARSE_STDIN,"Images written while rendering the next page\n");
+	  } else {
+	    option_flags &= ~PIPELINE_OUTPUT;
+	    Message(PARSE_STDIN,"Images written before rendering the next page\n");
+	  }
 	} else if (strncmp(p,"alette",6)==0) {
 	  if (p[6] != '0') {
 	    option_flags |= FORCE_PALETTE;
@@ -623,6 +636,7 @@ or <http://www.gnu.org/licenses/>.");
     fprintf(stdout,"  --palette*   Force palette output\n");
 #endif
     fprintf(stdout,"  --picky      When a warning occurs, don't output image\n");
+    fprintf(stdout,"  --pipeline*  Write image while rendering the next page\n");
 #ifdef HAVE_GDIMAGEGIF
     fprintf(stdout,"  --png        Output PNG images (dvipng default)\n");
 #endif
@@ -711,6 +725,7 @@ void Fatal (const char *fmt, ...)
 {
   va_list args;
 
+  FinishImage();
   va_start(args, fmt);
   fflush(stdout);
   fprintf(stderr, "\n");
@@ -739,6 +754,8 @@ void Warning(const char *fmt, ...)
   va_start(args, fmt);
 
   if ( option_flags & BE_NONQUIET ) {
+    /* Keep the order of warnings and messages */
+    FinishImage();
     fflush(stdout);
     fprintf(stderr, "%s warning: ", programname);
     vfprintf(stderr, fmt, args);
@@ -757,11 +774,52 @@ void Message(int activeflags, const char *fmt, ...)
 
   va_start(args, fmt);
   if ( option_flags & activeflags ) {
-    vfprintf(stdout, fmt, args);
+    if (holdmessages) {
+      va_list argscopy;
+      int length;
+
+      va_copy(argscopy, args);
+      length=vsnprintf(NULL, 0, fmt, argscopy);
+      va_end(argscopy);
+      if (length>0) {
+	if (heldlength+length+1 > heldsize) {
+	  size_t newsize=2*(heldlength+length+1);
+	  char *newmessages=realloc(heldmessages,newsize);
+	  if (newmessages==NULL) {
+	    /* Output what has been kept so far, then stop holding */
+	    HoldMessages(false);
+	    va_end(args);
+	    Fatal("cannot allocate memory for messages");
+	  }
+	  heldmessages=newmessages;
+	  heldsize=newsize;
+	}
+	vsnprintf(heldmessages+heldlength, length+1, fmt, args);
+	heldlength+=length;
+      }
+    } else
+      vfprintf(stdout, fmt, args);
   }
   va_end(args);
 }
 
+/*-->HoldMessages*/
+/**********************************************************************/
+/***************************  HoldMessages  ***************************/
+/**********************************************************************/
+void HoldMessages(bool hold)
+/* While an image is written in the background, messages are kept in
+   memory. They are output when the image is complete, so that the
+   "]" after a page number still means that its image exists. */
+{
+  holdmessages=hold;
+  if (!hold && heldlength>0) {
+    fwrite(heldmessages, 1, heldlength, stdout);
+    fflush(stdout);
+    heldlength=0;
+  }
+}
+
 
 bool MmapFile (char *filename,struct filemmap *fmmap)
 {
@@ -24,6 +24,12 @@
 
 #include "dvipng.h"
 #include <math.h>
+#ifdef WIN32
+#include <windows.h>
+#include <process.h>
+#else
+#include <pthread.h>
+#endif
 
 #ifndef HAVE_GDIMAGECREATETRUECOLOR
 #define gdImageColorAllocateAlpha(i,r,g,b,a) gdImageColorAllocate(i,r,g,b)
@@ -96,10 +102,83 @@ static void ChangeColor(gdImagePtr imagep,int x1,int y1,
   }
 }
 
+/* The image being written in the background */
+static struct {
+  gdImagePtr imagep;
+  FILE*      outfp;
+  bool       gif;
+  bool       pending;
+#ifdef WIN32
+  HANDLE     thread;
+#else
+  pthread_t  thread;
+#endif
+} writer;
+
+static void EncodeImage(gdImagePtr imagep, FILE* outfp, bool gif)
+{
+#ifdef HAVE_GDIMAGEGIF
+  if (gif)
+    gdImageGif(imagep,outfp);
+  else
+#endif
+    gdImagePngEx(imagep,outfp,compression);
+  fclose(outfp);
+  gdImageDestroy(imagep);
+}
+
+#ifdef WIN32
+static unsigned __stdcall WriterThread(void* arg)
+#else
+static void* WriterThread(void* arg)
+#endif
+/* Encode and write the image, in parallel with the rendering of
+   the next page */
+{
+  (void)arg;
+  EncodeImage(writer.imagep,writer.outfp,writer.gif);
+  return 0;
+}
+
+static bool StartWriter(gdImagePtr imagep, FILE* outfp, bool gif)
+{
+  writer.imagep=imagep;
+  writer.outfp=outfp;
+  writer.gif=gif;
+#ifdef WIN32
+  writer.thread=(HANDLE)_beginthreadex(NULL,0,WriterThread,NULL,0,NULL);
+  writer.pending = writer.thread!=0;
+#else
+  writer.pending = pthread_create(&writer.thread,NULL,WriterThread,NULL)==0;
+#endif
+  return writer.pending;
+}
+
+void FinishImage(void)
+/* Wait for the image being written, if any, and output the messages
+   held back in the meantime */
+{
+  if (!writer.pending)
+    return;
+  writer.pending=false;
+#ifdef WIN32
+  WaitForSingleObject(writer.thread,INFINITE);
+  CloseHandle(writer.thread);
+#else
+  pthread_join(writer.thread,NULL);
+#endif
+  HoldMessages(false);
+}
+
 void WriteImage(char *pngname, int pagenum)
 {
   char* pos, *freeme=NULL;
   FILE* outfp=NULL;
+  bool gif=false;
+
+  /* Only one image is written at a time, also when the file name is
+     the same for all pages */
+  FinishImage();
 
   /* Set transparent background. Maybe alpha is not available or
      perhaps we are producing GIFs, so test for BG_TRANSPARENT_ALPHA
@@ -164,21 +243,27 @@ void WriteImage(char *pngname, int pagenum)
   if ((outfp = fopen(pngname,"wb")) == NULL)
       Fatal("cannot open output file %s",pngname);
 #ifdef HAVE_GDIMAGEGIF
-  if (option_flags & GIF_OUTPUT)
-    gdImageGif(page_imagep,outfp);
-  else
+  gif = (option_flags & GIF_OUTPUT) != 0;
 #endif
-    gdImagePngEx(page_imagep,outfp,compression);
-  fclose(outfp);
+  if (option_flags & PIPELINE_OUTPUT && StartWriter(page_imagep,outfp,gif)) {
+    /* The image now belongs to the writer. Messages are held back
+       until it is complete, so that a page is reported done only
+       when its file exists */
+    page_imagep=NULL;
+    HoldMessages(true);
+  } else {
+    EncodeImage(page_imagep,outfp,gif);
+    page_imagep=NULL;
+  }
   DEBUG_PRINT(DEBUG_DVI,("\n  WROTE:   \t%s\n",pngname));
   if (freeme)
     free(freeme);
-  DestroyImage();
 }
 
 void DestroyImage(void)
 {
-  gdImageDestroy(page_imagep);
+  if (page_imagep)
+    gdImageDestroy(page_imagep);
   page_imagep=NULL;
 }
 
@@ -205,6 +290,62 @@ void Gamma(double gamma)
   }
 }
 
+#ifdef HAVE_GDIMAGECREATETRUECOLOR
+static int BlendTrueColor(int bgColor, int pixelgrey)
+/* Same blending as in SetGlyph, for truecolor pixels */
+{
+  int alpha = gdAlphaMax-pixelgrey;
+  int dst_alpha = gdTrueColorGetAlpha(bgColor);
+  int dst_weight = (gdAlphaMax - dst_alpha) * alpha / gdAlphaMax;
+  int tot_weight = pixelgrey + dst_weight;
+
+  return(gdTrueColorAlpha((cstack[csp].red*pixelgrey
+			   + gdTrueColorGetRed(bgColor)*dst_weight)/tot_weight,
+			  (cstack[csp].green*pixelgrey
+			   + gdTrueColorGetGreen(bgColor)*dst_weight)/tot_weight,
+			  (cstack[csp].blue*pixelgrey
+			   + gdTrueColorGetBlue(bgColor)*dst_weight)/tot_weight,
+			  alpha*dst_alpha/gdAlphaMax));
+}
+
+static void SetGlyphTrueColor(struct char_entry *ptr, int32_t hh,int32_t vv)
+/* Truecolor images (without libgd alpha blending) store pixels as
+   plain ints. Blend the glyph directly into the pixel rows instead of
+   going through gdImageGetPixel/gdImageSetPixel for each pixel. The
+   result is identical to the generic code in SetGlyph. */
+{
+  int x,y,xmin,xmax,ymin,ymax;
+  int bgColor,pixelgrey;
+  unsigned char *data;
+  int *row;
+
+  /* Clip the glyph against the clipping rectangle of the image, as
+     gdImageSetPixel does */
+  xmin = page_imagep->cx1-hh > 0 ? page_imagep->cx1-hh : 0;
+  xmax = page_imagep->cx2-hh < ptr->w-1 ? page_imagep->cx2-hh : ptr->w-1;
+  ymin = page_imagep->cy1-vv > 0 ? page_imagep->cy1-vv : 0;
+  ymax = page_imagep->cy2-vv < ptr->h-1 ? page_imagep->cy2-vv : ptr->h-1;
+  for( y=ymin; y<=ymax; y++) {
+    data = ptr->data + y*ptr->w;
+    row = page_imagep->tpixels[vv + y] + hh;
+    for( x=xmin; x<=xmax; x++) {
+      if (data[x]>0) {
+	pixelgrey=gammatable[(int)data[x]/2];
+	bgColor=row[x];
+	if (ColorCache[0]!=bgColor || ColorCache[pixelgrey]==-1) {
+	  DEBUG_PRINT(DEBUG_GLYPH,("\n  GAMMA GREYSCALE: %d -> %d ",
+				   data[x]/2,pixelgrey));
+	  row[x]=BlendTrueColor(bgColor,pixelgrey);
+	  if (ColorCache[0]==bgColor)
+	    ColorCache[pixelgrey]=row[x];
+	} else
+	  row[x]=ColorCache[pixelgrey];
+      }
+    }
+  }
+}
+#endif
+
 dviunits SetGlyph(struct char_entry *ptr, int32_t hh,int32_t vv)
 /* gdImageChar can only do monochrome glyphs */
 {
@@ -225,6 +366,12 @@ dviunits SetGlyph(struct char_entry *ptr, int32_t hh,int32_t vv)
       ColorCache[x]=-1;
     ColorCache[gdAlphaMax]=pixelcolor;
   }
+#ifdef HAVE_GDIMAGECREATETRUECOLOR
+  if (gdImageTrueColor(page_imagep) && !page_imagep->alphaBlendingFlag) {
+    SetGlyphTrueColor(ptr,hh,vv);
+    return(ptr->tfmw);
+  }
+#endif
   for( y=0; y<ptr->h; y++) {
     for( x=0; x<ptr->w; x++) {
       if (ptr->data[pos]>0) {
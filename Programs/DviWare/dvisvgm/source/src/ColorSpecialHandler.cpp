@@ -18,6 +18,7 @@
 ** along with this program; if not, see <http://www.gnu.org/licenses/>. **
 *************************************************************************/
 
+#include <algorithm>
 #include <cstring>
 #include <sstream>
 #include <vector>
@@ -91,20 +92,47 @@ Color ColorSpecialHandler::readColor (istream &is) {
 }
 
 
-bool ColorSpecialHandler::process (const string&, istream &is, SpecialActions &actions) {
-	string cmd;
-	is >> cmd;
+/** Applies a color command to a color stack.
+ *  @param[in] cmd the color command (push, pop, or a color model)
+ *  @param[in] is stream to read the color parameters from
+ *  @param[in,out] colorStack the color stack to be changed */
+void ColorSpecialHandler::execute (const string &cmd, istream &is, stack<Color> &colorStack) {
 	if (cmd == "push")               // color push <model> <params>
-		_colorStack.push(readColor(is));
+		colorStack.push(readColor(is));
 	else if (cmd == "pop") {
-		if (!_colorStack.empty())     // color pop
-			_colorStack.pop();
+		if (!colorStack.empty())      // color pop
+			colorStack.pop();
 	}
 	else {                           // color <model> <params>
-		while (!_colorStack.empty())
-			_colorStack.pop();
-		_colorStack.push(readColor(cmd, is));
+		while (!colorStack.empty())
+			colorStack.pop();
+		colorStack.push(readColor(cmd, is));
 	}
+}
+
+
+/** Records the state of the color stack at the end of each page while
+ *  preprocessing the DVI file. We need it in order to start a page with the
+ *  correct colors even if the preceding pages are not converted. */
+void ColorSpecialHandler::preprocess (const string&, istream &is, SpecialActions &actions) {
+	string cmd;
+	is >> cmd;
+	unsigned pageno = actions.getCurrentPageNumber();
+	stack<Color> colorStack;
+	if (!_pageColorStacks.empty())
+		colorStack = _pageColorStacks.back().second;
+	execute(cmd, is, colorStack);
+	if (!_pageColorStacks.empty() && _pageColorStacks.back().first == pageno)
+		_pageColorStacks.back().second = std::move(colorStack);
+	else
+		_pageColorStacks.emplace_back(PageColorStack(pageno, std::move(colorStack)));
+}
+
+
+bool ColorSpecialHandler::process (const string&, istream &is, SpecialActions &actions) {
+	string cmd;
+	is >> cmd;
+	execute(cmd, is, _colorStack);
 	if (_colorStack.empty())
 		actions.setColor(Color::BLACK);
 	else
@@ -113,6 +141,25 @@ bool ColorSpecialHandler::process (const string&, istream &is, SpecialActions &a
 }
 
 
+void ColorSpecialHandler::dviBeginPage (unsigned pageno, SpecialActions &actions) {
+	// Restore the color stack left by the preceding page. If all pages are
+	// converted in sequence, the stack is already in this state. Otherwise,
+	// e.g. if only a selected page range is converted, the color changes of
+	// the skipped pages must still affect the colors of the current page.
+	if (_pageColorStacks.empty())
+		return;
+	auto it = lower_bound(_pageColorStacks.begin(), _pageColorStacks.end(), pageno,
+		[](const PageColorStack &pcs, unsigned pageno) {return pcs.first < pageno;});
+	stack<Color> colorStack;
+	if (it != _pageColorStacks.begin())
+		colorStack = (--it)->second;
+	_colorStack = std::move(colorStack);
+	Color color = _colorStack.empty() ? Color::BLACK : _colorStack.top();
+	if (actions.getColor() != color)
+		actions.setColor(color);
+}
+
+
 vector<const char*> ColorSpecialHandler::prefixes() const {
 	vector<const char*> pfx {"color"};
 	return pfx;
@@ -30,6 +30,7 @@
 
 class ColorSpecialHandler : public SpecialHandler {
 	public:
+		void preprocess (const std::string &prefix, std::istream &is, SpecialActions &actions) override;
 		bool process (const std::string &prefix, std::istream &is, SpecialActions &actions) override;
 		static Color readColor (std::istream &is);
 		static Color readColor (const std::string &model, std::istream &is);
@@ -37,8 +38,14 @@ class ColorSpecialHandler : public SpecialHandler {
 		const char* info () const override {return "complete support of color specials";}
 		std::vector<const char*> prefixes() const override;
 
+	protected:
+		void dviBeginPage (unsigned pageno, SpecialActions &actions) override;
+		static void execute (const std::string &cmd, std::istream &is, std::stack<Color> &colorStack);
+
 	private:
+		using PageColorStack = std::pair<unsigned,std::stack<Color>>;  // page number and color stack at end of page
 		std::stack<Color> _colorStack;
+		std::vector<PageColorStack> _pageColorStacks;
 };
 
 #endif
@@ -42,6 +42,7 @@ class CommandLine : public CL::CommandLine {
 		TypedOption<int, Option::ArgMode::REQUIRED> gradSegmentsOpt {"grad-segments", '\0', "number", 20, "number of color gradient segments per row"};
 		TypedOption<double, Option::ArgMode::REQUIRED> gradSimplifyOpt {"grad-simplify", '\0', "delta", 0.05, "reduce level of detail for small segments"};
 		TypedOption<int, Option::ArgMode::OPTIONAL> helpOpt {"help", 'h', "mode", 0, "print this summary of options and exit"};
+		TypedOption<unsigned, Option::ArgMode::REQUIRED> jobsOpt {"jobs", '\0', "number", 1, "number of pages converted in parallel (ignored if specials affect subsequent pages)"};
 		Option keepOpt {"keep", '\0', "keep temporary files"};
 		TypedOption<std::string, Option::ArgMode::REQUIRED> libgsOpt {"libgs", '\0', "filename", "set name of Ghostscript shared library"};
 		TypedOption<std::string, Option::ArgMode::REQUIRED> linkmarkOpt {"linkmark", 'L', "style", "box", "select how to mark hyperlinked areas"};
@@ -130,6 +131,7 @@ class CommandLine : public CL::CommandLine {
 			{&zoomOpt, 2},
 			{&cacheOpt, 3},
 			{&exactOpt, 3},
+			{&jobsOpt, 3},
 			{&keepOpt, 3},
 #if !defined(HAVE_LIBGS) && !defined(DISABLE_GS)
 			{&libgsOpt, 3},
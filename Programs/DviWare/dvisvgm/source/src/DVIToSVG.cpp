@@ -213,6 +213,36 @@ void DVIToSVG::listHashes (const string &rangestr, std::ostream &os) {
 }
 
 
+/** DVI reader that looks for specials affecting the pages following the
+ *  one they occur on. */
+class PageDependencyScanner : public BasicDVIReader {
+	public:
+		explicit PageDependencyScanner (istream &is) : BasicDVIReader(is) {}
+		bool found () const {return _found;}
+
+	protected:
+		void cmdXXX (int len) override {
+			uint32_t numBytes = readUnsigned(len);
+			string s = readString(numBytes);
+			if (!_found)
+				_found = SpecialManager::instance().affectsFollowingPages(s);
+		}
+
+	private:
+		bool _found=false;
+};
+
+
+/** Returns true if the DVI file contains specials whose effects are not
+ *  limited to the page they occur on. In this case, a page can't be
+ *  converted without processing all preceding pages. */
+bool DVIToSVG::hasPageDependentSpecials () {
+	PageDependencyScanner scanner(getInputStream());
+	scanner.executeAllPages();
+	return scanner.found();
+}
+
+
 int DVIToSVG::executeCommand () {
 	SignalHandler::instance().check();
 	const streampos cmdpos = tell();
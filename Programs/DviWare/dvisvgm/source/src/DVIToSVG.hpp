@@ -60,6 +60,7 @@ class DVIToSVG : public DVIReader {
 		double getYPos() const override       {return dviState().v+_ty;}
 		void finishLine () override           {_prevYPos = std::numeric_limits<double>::min();}
 		void listHashes (const std::string &rangestr, std::ostream &os);
+		bool hasPageDependentSpecials ();
 
 		std::string getSVGFilename (unsigned pageno) const;
 		std::string getUserBBoxString () const  {return _bboxFormatString;}
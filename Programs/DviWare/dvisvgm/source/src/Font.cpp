@@ -21,8 +21,11 @@
 #if defined(MIKTEX)
 #  include <config.h>
 #endif
+#include <cctype>
 #include <cstdlib>
 #include <fstream>
+#include <iterator>
+#include <map>
 #include <set>
 #include <sstream>
 #include "CMap.hpp"
@@ -36,6 +39,11 @@
 #include "Subfont.hpp"
 #include "Unicode.hpp"
 #include "utility.hpp"
+#include "XXHashFunction.hpp"
+#if defined(MIKTEX_WINDOWS)
+#include <miktex/Util/CharBuffer>
+#define UW_(x) MiKTeX::Util::CharBuffer<wchar_t>(x).GetData()
+#endif
 
 
 using namespace std;
@@ -329,7 +337,7 @@ bool PhysicalFont::getGlyph (int c, GraphicsPath<int32_t> &glyph, GFGlyphTracer:
 		const Glyph *cached_glyph=0;
 		if (CACHE_PATH) {
 			_cache.write(CACHE_PATH);
-			_cache.read(name(), CACHE_PATH);
+			_cache.read(name(), CACHE_PATH, glyphCacheKey());
 			cached_glyph = _cache.getGlyph(c);
 		}
 		if (cached_glyph) {
@@ -389,6 +397,78 @@ bool PhysicalFont::createGF (string &gfname) const {
 }
 
 
+/** Adds the contents of a Metafont source file, and of all files it loads by
+ *  'input' or 'generate', to a hash value. The statements are recognized
+ *  lexically, so files loaded by other means aren't taken into account.
+ *  @param[in] fname name of the Metafont file (suffix .mf is optional)
+ *  @param[in,out] hashfunc the file contents are added to this hash function
+ *  @param[in,out] visited names of the files already added */
+static void hash_mf_sources (string fname, HashFunction &hashfunc, set<string> &visited) {
+	if (fname.length() < 3 || fname.substr(fname.length()-3) != ".mf")
+		fname += ".mf";
+	if (!visited.insert(fname).second)
+		return;
+	const char *path = FileFinder::instance().lookup(fname, false);
+	if (!path)
+		return;
+#if defined(MIKTEX_WINDOWS)
+	ifstream ifs(UW_(path), ios::binary);
+#else
+	ifstream ifs(path, ios::binary);
+#endif
+	string source((istreambuf_iterator<char>(ifs)), istreambuf_iterator<char>());
+	hashfunc.update(fname);
+	hashfunc.update(source);
+	size_t pos=0;
+	while (pos < source.length()) {
+		char c = source[pos];
+		if (c == '%')       // skip comment
+			pos = source.find('\n', pos);
+		else if (c == '"')  // skip string (strings don't span lines)
+			pos = source.find_first_of("\"\n", pos+1);
+		else if (isalpha((unsigned char)c) || c == '_') {
+			size_t start = pos;
+			while (pos < source.length() && (isalpha((unsigned char)source[pos]) || source[pos] == '_'))
+				pos++;
+			string token = source.substr(start, pos-start);
+			if (token == "input" || token == "generate") {
+				while (pos < source.length() && isspace((unsigned char)source[pos]))
+					pos++;
+				start = pos;
+				while (pos < source.length() && !isspace((unsigned char)source[pos]) && source[pos] != ';')
+					pos++;
+				if (pos > start)
+					hash_mf_sources(source.substr(start, pos-start), hashfunc, visited);
+			}
+			continue;
+		}
+		if (pos != string::npos)
+			pos++;
+	}
+}
+
+
+/** Returns a string identifying the data the glyph outlines of this font are
+ *  derived from. It's used to select the cache file of the font so that outlines
+ *  traced from different Metafont sources (including the files they load), or
+ *  with a different magnification, are kept apart. Since all dvisvgm processes
+ *  compute the same key, they can share the cached outlines. */
+string PhysicalFont::glyphCacheKey () const {
+	static map<string,string> keys;  // font name -> key
+	auto it = keys.find(name());
+	if (it == keys.end()) {
+		XXH64HashFunction hashfunc;
+		ostringstream oss;
+		oss << "ljfour:" << METAFONT_MAG << ':' << unitsPerEm() << ':' << (getMetrics() ? getMetrics()->getDesignSize() : 1);
+		hashfunc.update(oss.str());
+		set<string> visited;
+		hash_mf_sources(name(), hashfunc, visited);
+		it = keys.emplace(name(), hashfunc.digestString()).first;
+	}
+	return it->second;
+}
+
+
 /** Traces all glyphs of the current font and stores them in the cache. If caching is disabled, nothing happens.
  *  @param[in] includeCached if true, glyphs already cached are traced again
  *  @param[in] cb optional callback methods called by the tracer
@@ -402,7 +482,8 @@ int PhysicalFont::traceAllGlyphs (bool includeCached, GFGlyphTracer::Callback *c
 			string gfname;
 			Glyph glyph;
 			if (createGF(gfname)) {
-				_cache.read(name(), CACHE_PATH);
+				_cache.write(CACHE_PATH);
+				_cache.read(name(), CACHE_PATH, glyphCacheKey());
 				double ds = getMetrics() ? getMetrics()->getDesignSize() : 1;
 				GFGlyphTracer tracer(gfname, unitsPerEm()/ds, cb);
 				tracer.setGlyph(glyph);
@@ -138,6 +138,7 @@ class PhysicalFont : public virtual Font {
 
 	protected:
 		bool createGF (std::string &gfname) const;
+		std::string glyphCacheKey () const;
 
 	public:
 		static bool EXACT_BBOX;
@@ -19,10 +19,22 @@
 *************************************************************************/
 
 #include <algorithm>
+#include <cerrno>
 #include <cstring>
 #include <fstream>
 #include <iomanip>
 #include <sstream>
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#include <process.h>
+#include <sys/locking.h>
+#include <sys/stat.h>
+#include "windows.hpp"
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 #include "CRC32.hpp"
 #include "FileSystem.hpp"
 #include "FontCache.hpp"
@@ -40,6 +52,91 @@ using namespace std;
 const uint8_t FontCache::FORMAT_VERSION = 5;
 
 
+static int get_pid () {
+#ifdef _WIN32
+	return _getpid();
+#else
+	return getpid();
+#endif
+}
+
+
+/** Exclusive lock of a cache file. The lock is held on a separate lock file
+ *  which is never removed. The system releases the lock if the process
+ *  terminates without unlocking it. */
+class CacheFileLock {
+	public:
+		explicit CacheFileLock (const string &path);
+		CacheFileLock (const CacheFileLock&) =delete;
+		~CacheFileLock ();
+		bool locked () const {return _fd >= 0;}
+
+	private:
+		int _fd;
+};
+
+
+/** Waits until the lock of the given cache file can be acquired.
+ *  @param[in] path path of the cache file */
+CacheFileLock::CacheFileLock (const string &path) {
+	string lockpath = path + ".lock";
+#ifdef _WIN32
+#if defined(MIKTEX_WINDOWS)
+	_fd = _wopen(UW_(lockpath), _O_RDWR | _O_CREAT | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+	_fd = _open(lockpath.c_str(), _O_RDWR | _O_CREAT | _O_BINARY, _S_IREAD | _S_IWRITE);
+#endif
+	// _LK_LOCK retries for about 10 seconds before it gives up
+	if (_fd >= 0 && _locking(_fd, _LK_LOCK, 1) != 0) {
+		_close(_fd);
+		_fd = -1;
+	}
+#else
+	_fd = open(lockpath.c_str(), O_RDWR | O_CREAT, 0666);
+	if (_fd >= 0) {
+		struct flock fl;
+		memset(&fl, 0, sizeof(fl));
+		fl.l_type = F_WRLCK;
+		fl.l_whence = SEEK_SET;
+		int ret;
+		while ((ret = fcntl(_fd, F_SETLKW, &fl)) < 0 && errno == EINTR);
+		if (ret < 0) {
+			close(_fd);
+			_fd = -1;
+		}
+	}
+#endif
+}
+
+
+CacheFileLock::~CacheFileLock () {
+	if (_fd >= 0) {
+#ifdef _WIN32
+		_lseek(_fd, 0, SEEK_SET);
+		_locking(_fd, _LK_UNLCK, 1);
+		_close(_fd);
+#else
+		close(_fd);  // releases the lock
+#endif
+	}
+}
+
+
+/** Replaces a file by another one. Unlike rename(), this never leaves
+ *  a moment where the target file doesn't exist. */
+static bool replace_file (const string &src, const string &dest) {
+#ifdef _WIN32
+#if defined(MIKTEX_WINDOWS)
+	return MoveFileExW(UW_(src), UW_(dest), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+	return MoveFileExA(src.c_str(), dest.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#endif
+#else
+	return FileSystem::rename(src, dest);
+#endif
+}
+
+
 static Pair32 read_pair (int bytes, StreamReader &sr) {
 	int32_t x = sr.readSigned(bytes);
 	int32_t y = sr.readSigned(bytes);
@@ -51,6 +148,24 @@ static Pair32 read_pair (int bytes, StreamReader &sr) {
 void FontCache::clear () {
 	_glyphs.clear();
 	_fontname.clear();
+	_key.clear();
+}
+
+
+/** Returns the path of a cache file. Glyph data created from different font
+ *  sources or with different settings, e.g. another Metafont magnification,
+ *  is kept in separate files which are distinguished by the key.
+ *  @param[in] fontname name of the font
+ *  @param[in] key string identifying the font data (may be empty)
+ *  @param[in] dir directory where the cache files are located */
+string FontCache::filepath (const string &fontname, const string &key, const string &dir) {
+	string dirstr = dir.empty() ? FileSystem::getcwd() : dir;
+	ostringstream oss;
+	oss << dirstr << '/' << fontname;
+	if (!key.empty())
+		oss << '-' << key;
+	oss << ".fgd";
+	return oss.str();
 }
 
 
@@ -73,7 +188,10 @@ const Glyph* FontCache::getGlyph (int c) const {
 
 
 /** Writes the current cache data to a file (only if anything changed after
- *  the last call of read()).
+ *  the last call of read()). Glyphs added to the cache file by other processes
+ *  in the meantime are preserved. Concurrent writers are serialized by a lock
+ *  file. The data is written to a temporary file first which then replaces
+ *  the cache file. Thus, concurrent readers never see an incomplete cache file.
  *  @param[in] fontname name of current font
  *  @param[in] dir directory where the cache file should go
  *  @return true if writing was successful */
@@ -82,15 +200,40 @@ bool FontCache::write (const string &fontname, const string &dir) const {
 		return true;
 
 	if (!fontname.empty()) {
-		string dirstr = dir.empty() ? FileSystem::getcwd() : dir;
-		ostringstream oss;
-		oss << dirstr << '/' << fontname << ".fgd";
+		string path = filepath(fontname, _key, dir);
+		CacheFileLock lock(path);
+		if (!lock.locked())
+			return false;
+		FontCache cache;
+#if defined(MIKTEX_WINDOWS)
+		ifstream ifs(UW_(path), ios::binary);
+#else
+		ifstream ifs(path, ios::binary);
+#endif
+		if (cache.read(fontname, ifs)) {
+			for (const auto &charglyphpair : _glyphs)
+				cache._glyphs[charglyphpair.first] = charglyphpair.second;
+		}
+		else
+			cache._glyphs = _glyphs;
+		ifs.close();
+		cache._changed = true;
+		string tmppath = path + "." + to_string(get_pid()) + ".tmp";
+		bool ok;
+		{
 #if defined(MIKTEX_WINDOWS)
-                ofstream ofs(UW_(oss.str()), ios::binary);
+			ofstream ofs(UW_(tmppath), ios::binary);
 #else
-		ofstream ofs(oss.str(), ios::binary);
+			ofstream ofs(tmppath, ios::binary);
 #endif
-		return write(fontname, ofs);
+			ok = cache.write(fontname, ofs);
+		}
+		ok = ok && replace_file(tmppath, path);
+		if (!ok)
+			FileSystem::remove(tmppath);
+		else
+			_changed = false;
+		return ok;
 	}
 	return false;
 }
@@ -175,22 +318,23 @@ bool FontCache::write (const string &fontname, ostream &os) const {
 /** Reads font glyph information from a file.
  *  @param[in] fontname name of font data to read
  *  @param[in] dir directory where the cache files are located
+ *  @param[in] key string identifying the font data and settings (may be empty)
  *  @return true if reading was successful */
-bool FontCache::read (const string &fontname, const string &dir) {
+bool FontCache::read (const string &fontname, const string &dir, const string &key) {
 	if (fontname.empty())
 		return false;
-	if (_fontname == fontname)
+	if (_fontname == fontname && _key == key)
 		return true;
 	clear();
-	string dirstr = dir.empty() ? FileSystem::getcwd() : dir;
-	ostringstream oss;
-	oss << dirstr << '/' << fontname << ".fgd";
+	string path = filepath(fontname, key, dir);
 #if defined(MIKTEX_WINDOWS)
-        ifstream ifs(UW_(oss.str()), ios::binary);
+        ifstream ifs(UW_(path), ios::binary);
 #else
-	ifstream ifs(oss.str(), ios::binary);
+	ifstream ifs(path, ios::binary);
 #endif
-	return read(fontname, ifs);
+	bool ok = read(fontname, ifs);
+	_key = key;
+	return ok;
 }
 
 
@@ -368,9 +512,9 @@ void FontCache::fontinfo (const string &dirname, ostream &os, bool purge) {
 			os << "cache is empty\n";
 		else {
 			os << "cache format version " << infos[0].version << endl;
-			map<string, const FontInfo*> sortmap;
+			multimap<string, const FontInfo*> sortmap;
 			for (const FontInfo &info : infos)
-				sortmap[info.name] = &info;
+				sortmap.emplace(info.name, &info);
 			for (const auto &strinfopair : sortmap) {
 				os	<< dec << setfill(' ') << left
 					<< setw(10) << left  << strinfopair.second->name
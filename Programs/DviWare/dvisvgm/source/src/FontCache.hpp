@@ -41,7 +41,7 @@ class FontCache {
 	public:
 		FontCache () : _changed(false) {}
 		~FontCache () {clear();}
-		bool read (const std::string &fontname, const std::string &dir);
+		bool read (const std::string &fontname, const std::string &dir, const std::string &key="");
 		bool read (const std::string &fontname, std::istream &is);
 		bool write (const std::string &dir) const;
 		bool write (const std::string &fontname, const std::string &dir) const;
@@ -50,16 +50,21 @@ class FontCache {
 		void setGlyph (int c, const Glyph &glyph);
 		void clear ();
 		const std::string& fontname () const {return _fontname;}
+		const std::string& key () const      {return _key;}
 
 		static bool fontinfo (const std::string &dirname, std::vector<FontInfo> &infos, std::vector<std::string> &invalid);
 		static bool fontinfo (std::istream &is, FontInfo &info);
 		static void fontinfo (const std::string &dirname, std::ostream &os, bool purge=false);
 
+	protected:
+		static std::string filepath (const std::string &fontname, const std::string &key, const std::string &dir);
+
 	private:
 		static const uint8_t FORMAT_VERSION;
 		std::string _fontname;
+		std::string _key;  ///< identifies the font data and settings the glyphs were created from
 		std::map<int, Glyph> _glyphs;
-		bool _changed;
+		mutable bool _changed;
 };
 
 #endif
@@ -35,9 +35,11 @@
 #endif
 
 #include <cstdlib>
+#include <vector>
 #include "FileSystem.hpp"
 #include "Process.hpp"
 #include "SignalHandler.hpp"
+#include "utility.hpp"
 
 using namespace std;
 
@@ -53,9 +55,10 @@ class Subprocess {
 		Subprocess (const Subprocess&) =delete;
 		Subprocess (Subprocess&&) =delete;
 		~Subprocess ();
-		bool run (const string &cmd, string params);
+		bool run (const string &cmd, string params, bool captureStderr);
 		bool readFromPipe (string &out);
 		State state ();
+		void terminate ();
 
 	private:
 #ifdef _WIN32
@@ -68,36 +71,80 @@ class Subprocess {
 };
 
 
-Process::Process (const string &cmd, const string &paramstr)
-	: _cmd(cmd), _paramstr(paramstr)
+/** Creates a new process object. The subprocess is started by run() or start().
+ *  @param[in] cmd name of command to execute
+ *  @param[in] paramstr parameters required by command
+ *  @param[in] captureStderr if true, the output written to stderr is also captured on Windows
+ *    (other systems always redirect stderr to the output pipe) */
+Process::Process (const string &cmd, const string &paramstr, bool captureStderr)
+	: _cmd(cmd), _paramstr(paramstr), _captureStderr(captureStderr)
 {
 }
 
 
+Process::~Process () =default;
+
+
 /** Runs the process and waits until it's finished.
- *  @param[out] out takes the output written to stdout by the executed subprocess
+ *  @param[out] out takes the output written to stdout (and stderr, see constructor) by the executed subprocess
  *  @return true if process terminated properly
  *  @throw SignalException if CTRL-C was pressed during execution */
 bool Process::run (string *out) {
-	Subprocess subprocess;
-	if (!subprocess.run(_cmd, _paramstr))
+	return start() && wait(out);
+}
+
+
+/** Starts the subprocess without waiting for its termination. Together with
+ *  wait(), this allows for spawning several subprocesses from one thread and
+ *  collecting their output in others.
+ *  @return true if the subprocess started properly */
+bool Process::start () {
+	_subprocess = util::make_unique<Subprocess>();
+	if (_subprocess->run(_cmd, _paramstr, _captureStderr))
+		return true;
+	_subprocess.reset();
+	return false;
+}
+
+
+/** Waits until the subprocess started by start() is finished.
+ *  @param[out] out takes the output written to stdout (and stderr, see constructor) by the executed subprocess
+ *  @return true if process terminated properly
+ *  @throw SignalException if CTRL-C was pressed during execution */
+bool Process::wait (string *out) {
+	if (!_subprocess)
 		return false;
+	if (out)
+		out->clear();
 	for (;;) {
-		if (out) {
-			out->clear();
-			subprocess.readFromPipe(*out);
+		if (out)
+			_subprocess->readFromPipe(*out);
+		{
+			lock_guard<mutex> lock(_mutex);
+			Subprocess::State state = _subprocess->state();
+			if (state != Subprocess::State::RUNNING) {
+				_subprocess.reset();
+				return state == Subprocess::State::FINISHED;
+			}
 		}
-		Subprocess::State state = subprocess.state();
-		if (state != Subprocess::State::RUNNING)
-			return state == Subprocess::State::FINISHED;
 		SignalHandler::instance().check();
 	}
 }
 
 
+/** Terminates the subprocess started by start() if it's still running.
+ *  This function may be called while another thread waits for the subprocess
+ *  in wait(), which then returns false. */
+void Process::terminate () {
+	lock_guard<mutex> lock(_mutex);
+	if (_subprocess)
+		_subprocess->terminate();
+}
+
+
 /** Runs the process in the given working directory and waits until it's finished.
  *  @param[in] dir working directory
- *  @param[out] out takes the output written to stdout by the executed process
+ *  @param[out] out takes the output written to stdout (and stderr, see constructor) by the executed process
  *  @return true if process terminated properly
  *  @throw SignalException if CTRL-C was pressed during execution */
 bool Process::run (const string &dir, string *out) {
@@ -166,8 +213,9 @@ bool Subprocess::readFromPipe (string &out) {
 /** Starts a child process.
  *  @param[in] cmd name of command to execute
  *  @param[in] paramstr parameters required by command
+ *  @param[in] captureStderr if true, stderr is redirected to the pipe too
  *  @returns true if child process started properly */
-bool Subprocess::run (const string &cmd, string paramstr) {
+bool Subprocess::run (const string &cmd, string paramstr, bool captureStderr) {
 	SECURITY_ATTRIBUTES securityAttribs;
 	ZeroMemory(&securityAttribs, sizeof(SECURITY_ATTRIBUTES));
 	securityAttribs.nLength = sizeof(SECURITY_ATTRIBUTES);
@@ -191,7 +239,7 @@ bool Subprocess::run (const string &cmd, string paramstr) {
 		startupInfo.dwFlags = STARTF_USESTDHANDLES;
 		startupInfo.hStdInput = nullFile;
 		startupInfo.hStdOutput = pipeWriteHandle;
-		startupInfo.hStdError = GetStdHandle(STD_ERROR_HANDLE);
+		startupInfo.hStdError = captureStderr ? pipeWriteHandle : GetStdHandle(STD_ERROR_HANDLE);
 
 		PROCESS_INFORMATION processInfo;
 		ZeroMemory(&processInfo, sizeof(PROCESS_INFORMATION));
@@ -227,6 +275,13 @@ Subprocess::State Subprocess::state () {
 	return status == 0 ? State::FINISHED : State::FAILED;
 }
 
+
+/** Terminates the child process. */
+void Subprocess::terminate () {
+	if (_childProcHandle != NULL)
+		TerminateProcess(_childProcHandle, 1);
+}
+
 #else  // !_WIN32
 
 Subprocess::Subprocess () : _readfd(-1), _pid(-1) {
@@ -293,11 +348,24 @@ static void split_paramstr (string &paramstr, vector<const char*> &params) {
 /** Starts a child process.
  *  @param[in] cmd name of command to execute
  *  @param[in] paramstr parameters required by command
+ *  @param[in] captureStderr ignored, stderr is always redirected to the pipe
  *  @returns true if child process started properly */
-bool Subprocess::run (const string &cmd, string paramstr) {
+bool Subprocess::run (const string &cmd, string paramstr, bool) {
+	// Prepare the argument vector before forking. The child must not allocate
+	// memory if the parent is multithreaded.
+	vector<const char*> params;
+	params.push_back(cmd.c_str());
+	split_paramstr(paramstr, params);
+	params.push_back(nullptr); // trailing null pointer marks end of parameter list
+
 	int pipefd[2];
 	if (pipe(pipefd) < 0)
 		return false;
+	// Don't leak the pipe into other subprocesses started concurrently. Otherwise,
+	// the read end wouldn't see EOF before all of them have terminated.
+	// dup2() clears the flag on the descriptors of the redirected streams.
+	fcntl(pipefd[0], F_SETFD, FD_CLOEXEC);
+	fcntl(pipefd[1], F_SETFD, FD_CLOEXEC);
 
 	_pid = fork();
 	if (_pid < 0) {
@@ -310,14 +378,9 @@ bool Subprocess::run (const string &cmd, string paramstr) {
 		dup2(pipefd[1], STDERR_FILENO);  // redirect stderr to the pipe
 		close(pipefd[0]);
 		close(pipefd[1]);
-
-		vector<const char*> params;
-		params.push_back(cmd.c_str());
-		split_paramstr(paramstr, params);
-		params.push_back(nullptr); // trailing null pointer marks end of parameter list
 		signal(SIGINT, SIG_IGN);   // child process is supposed to ignore ctrl-c events
-		execvp(cmd.c_str(), const_cast<char* const*>(&params[0]));
-		exit(1);
+		execvp(params[0], const_cast<char* const*>(&params[0]));
+		_exit(1);
 	}
 	_readfd = pipefd[0];
 	close(pipefd[1]);  // close write end of pipe
@@ -337,4 +400,11 @@ Subprocess::State Subprocess::state () {
 	return State::FAILED;
 }
 
+
+/** Terminates the child process. */
+void Subprocess::terminate () {
+	if (_pid > 0)
+		kill(_pid, SIGTERM);
+}
+
 #endif  // !_WIN32
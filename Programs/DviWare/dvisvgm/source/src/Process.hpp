@@ -21,19 +21,30 @@
 #ifndef PROCESS_HPP
 #define PROCESS_HPP
 
+#include <memory>
+#include <mutex>
 #include <string>
 
+class Subprocess;
+
 class Process {
 	public:
-		Process (const std::string &cmd, const std::string &paramstr);
+		Process (const std::string &cmd, const std::string &paramstr, bool captureStderr=false);
 		Process (const Process &orig) =delete;
 		Process (Process &&orig) =delete;
+		~Process ();
 		bool run (std::string *out=0);
 		bool run (const std::string &dir, std::string *out=0);
+		bool start ();
+		bool wait (std::string *out=0);
+		void terminate ();
 
 	private:
 		std::string _cmd;
 		const std::string _paramstr;
+		bool _captureStderr;  ///< if true, stderr of the subprocess is redirected to the output pipe on all systems
+		std::unique_ptr<Subprocess> _subprocess;
+		std::mutex _mutex;  ///< synchronizes terminate() with the thread waiting for the subprocess
 };
 
 #endif
@@ -194,6 +194,15 @@ void PsSpecialHandler::preprocess (const string &prefix, istream &is, SpecialAct
 }
 
 
+/** Returns true if the special may change the state of the PostScript
+ *  interpreter used to process the following pages. This applies to all
+ *  literal PS code outside of headers because the interpreter doesn't reset
+ *  its state at the beginning of a page. */
+bool PsSpecialHandler::affectsFollowingPages (const string &prefix) const {
+	return prefix == "ps:" || prefix == "ps::" || prefix == "\"" || prefix == "pst:" || prefix == "PST:";
+}
+
+
 bool PsSpecialHandler::process (const string &prefix, istream &is, SpecialActions &actions) {
 	// process PS headers only once (in prescan)
 	if (prefix == "!" || prefix == "header=")
@@ -86,6 +86,7 @@ class PsSpecialHandler : public SpecialHandler, protected PSActions {
 		const char* info () const override {return "dvips PostScript specials";}
 		std::vector<const char*> prefixes() const override;
 		void preprocess (const std::string &prefix, std::istream &is, SpecialActions &actions) override;
+		bool affectsFollowingPages (const std::string &prefix) const override;
 		bool process (const std::string &prefix, std::istream &is, SpecialActions &actions) override;
 		void setDviScaleFactor (double dvi2bp) override {_previewFilter.setDviScaleFactor(dvi2bp);}
 		void enterBodySection ();
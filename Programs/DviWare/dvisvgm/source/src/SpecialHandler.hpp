@@ -45,6 +45,7 @@ class SpecialHandler {
 		virtual std::vector<const char*> prefixes() const =0;
 		virtual void setDviScaleFactor (double dvi2bp) {}
 		virtual void preprocess (const std::string &prefix, std::istream &is, SpecialActions &actions) {}
+		virtual bool affectsFollowingPages (const std::string &prefix) const {return false;}
 		virtual bool process (const std::string &prefix, std::istream &is, SpecialActions &actions)=0;
 		virtual void dviPreprocessingFinished () {}
 		virtual void dviBeginPage (unsigned pageno, SpecialActions &actions) {}
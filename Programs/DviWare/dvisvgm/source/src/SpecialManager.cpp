@@ -121,6 +121,19 @@ void SpecialManager::preprocess (const string &special, SpecialActions &actions)
 }
 
 
+/** Returns true if the effects of a special are not limited to the page it
+ *  occurs on, i.e. if the following pages can't be converted without
+ *  processing the special first.
+ *  @param[in] special the special expression */
+bool SpecialManager::affectsFollowingPages (const string &special) const {
+	istringstream iss(special);
+	const string prefix = extract_prefix(iss);
+	if (SpecialHandler *handler = findHandlerByPrefix(prefix))
+		return handler->affectsFollowingPages(prefix);
+	return false;
+}
+
+
 /** Executes a special command.
  *  @param[in] special the special expression
  *  @param[in] dvi2bp factor to convert DVI units to PS points
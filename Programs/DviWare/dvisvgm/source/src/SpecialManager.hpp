@@ -41,6 +41,7 @@ class SpecialManager {
 		void registerHandlers (std::vector<std::unique_ptr<SpecialHandler>> &handlers, const char *ignorelist);
 		void unregisterHandlers ();
 		void preprocess (const std::string &special, SpecialActions &actions) const;
+		bool affectsFollowingPages (const std::string &special) const;
 		bool process (const std::string &special, double dvi2bp, SpecialActions &actions) const;
 		void notifyPreprocessingFinished () const;
 		void notifyBeginPage (unsigned pageno, SpecialActions &actions) const;
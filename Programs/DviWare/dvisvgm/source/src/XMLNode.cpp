@@ -22,6 +22,8 @@
 #include <map>
 #include <list>
 #include <sstream>
+#include <type_traits>
+#include <unordered_set>
 #include "utility.hpp"
 #include "XMLNode.hpp"
 #include "XMLString.hpp"
@@ -29,7 +31,7 @@
 using namespace std;
 
 
-XMLElementNode::XMLElementNode (const string &n) : _name(n) {
+XMLElementNode::XMLElementNode (const string &n) : _name(&intern(n)) {
 }
 
 
@@ -47,6 +49,73 @@ XMLElementNode::XMLElementNode (XMLElementNode &&node)
 }
 
 
+/** Returns a unique string object for a given element or attribute name.
+ *  SVG documents usually contain only a few different names, so it's not
+ *  necessary to store a copy of the name in each element and attribute. */
+const string& XMLElementNode::intern (const string &str) {
+	static unordered_set<string> names;
+	return *names.insert(str).first;
+}
+
+
+/** Simple allocator that hands out fixed-size memory blocks taken from larger
+ *  chunks. Released blocks are kept in a free list and reused for subsequent
+ *  allocations. Since dense pages consist of thousands of elements, this avoids
+ *  most of the calls of the global allocation functions. The chunks are never
+ *  released, they are reused for the following pages. */
+class ElementPool {
+	struct FreeBlock {FreeBlock *next;};
+	public:
+		static ElementPool& instance () {
+			// never destroyed to allow elements being released during static deinitialization
+			static ElementPool *pool = new ElementPool;
+			return *pool;
+		}
+
+		void* allocate () {
+			if (!_freeList) {
+				_chunks.emplace_back(unique_ptr<Block[]>(new Block[BLOCKS_PER_CHUNK]));
+				Block *chunk = _chunks.back().get();
+				for (size_t i=0; i < BLOCKS_PER_CHUNK; i++)
+					release(&chunk[i]);
+			}
+			FreeBlock *block = _freeList;
+			_freeList = block->next;
+			return block;
+		}
+
+		void release (void *ptr) {
+			FreeBlock *block = static_cast<FreeBlock*>(ptr);
+			block->next = _freeList;
+			_freeList = block;
+		}
+
+	private:
+		ElementPool () : _freeList(nullptr) {}
+		static constexpr size_t BLOCKS_PER_CHUNK = 1024;
+		using Block = aligned_storage<sizeof(XMLElementNode), alignof(XMLElementNode)>::type;
+		vector<unique_ptr<Block[]>> _chunks;
+		FreeBlock *_freeList;
+};
+
+
+void* XMLElementNode::operator new (size_t size) {
+	if (size != sizeof(XMLElementNode))  // object of derived type?
+		return ::operator new(size);
+	return ElementPool::instance().allocate();
+}
+
+
+void XMLElementNode::operator delete (void *ptr, size_t size) {
+	if (!ptr)
+		return;
+	if (size != sizeof(XMLElementNode))
+		::operator delete(ptr);
+	else
+		ElementPool::instance().release(ptr);
+}
+
+
 void XMLElementNode::clear () {
 	_attributes.clear();
 	_children.clear();
@@ -56,8 +125,11 @@ void XMLElementNode::clear () {
 void XMLElementNode::addAttribute (const string &name, const string &value) {
 	if (Attribute *attr = getAttribute(name))
 		attr->value = value;
-	else
+	else {
+		if (_attributes.empty())
+			_attributes.reserve(4);  // most elements get only a few attributes
 		_attributes.emplace_back(Attribute(name, value));
+	}
 }
 
 
@@ -111,7 +183,7 @@ XMLNode* XMLElementNode::prepend (unique_ptr<XMLNode> &&child) {
 			return textNode2;
 		}
 	}
-	_children.emplace_front(std::move(child));
+	_children.emplace(_children.begin(), std::move(child));
 	return _children.front().get();
 }
 
@@ -199,7 +271,7 @@ XMLElementNode* XMLElementNode::getFirstDescendant (const char *name, const char
 
 
 ostream& XMLElementNode::write (ostream &os) const {
-	os << '<' << _name;
+	os << '<' << *_name;
 	for (const auto &attrib : _attributes)
 		os << ' ' << attrib.name << "='" << attrib.value << '\'';
 	if (_children.empty())
@@ -218,7 +290,7 @@ ostream& XMLElementNode::write (ostream &os) const {
 					os << '\n';
 			}
 		}
-		os << "</" << _name << '>';
+		os << "</" << *_name << '>';
 	}
 	return os;
 }
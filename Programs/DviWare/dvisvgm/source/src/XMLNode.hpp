@@ -21,7 +21,6 @@
 #ifndef XMLNODE_HPP
 #define XMLNODE_HPP
 
-#include <deque>
 #include <map>
 #include <memory>
 #include <ostream>
@@ -42,16 +41,18 @@ class XMLNode {
 class XMLElementNode : public XMLNode {
 	public:
 		struct Attribute {
-			Attribute (const std::string &nam, const std::string &val) : name(nam), value(val) {}
-			std::string name;
+			Attribute (const std::string &nam, const std::string &val) : name(intern(nam).c_str()), value(val) {}
+			const char *name;   // interned attribute name
 			std::string value;
 		};
-		using ChildList = std::deque<std::unique_ptr<XMLNode>>;
+		using ChildList = std::vector<std::unique_ptr<XMLNode>>;
 
 	public:
 		XMLElementNode (const std::string &name);
 		XMLElementNode (const XMLElementNode &node);
 		XMLElementNode (XMLElementNode &&node);
+		static void* operator new (size_t size);
+		static void operator delete (void *ptr, size_t size);
 		std::unique_ptr<XMLNode> clone () const override {return util::make_unique<XMLElementNode>(*this);}
 		void clear () override;
 		void addAttribute (const std::string &name, const std::string &value);
@@ -69,13 +70,15 @@ class XMLElementNode : public XMLNode {
 		std::ostream& write (std::ostream &os) const override;
 		bool empty () const                  {return _children.empty();}
 		const ChildList& children () const   {return _children;}
-		const std::string& getName () const  {return _name;}
+		const std::string& getName () const  {return *_name;}
+
 	protected:
 		Attribute* getAttribute (const std::string &name);
 		const Attribute* getAttribute (const std::string &name) const;
+		static const std::string& intern (const std::string &str);
 
 	private:
-		std::string _name;     // element name (<name a1="v1" .. an="vn">...</name>)
+		const std::string *_name;  // interned element name (<name a1="v1" .. an="vn">...</name>)
 		std::vector<Attribute> _attributes;
 		ChildList _children;   // child nodes
 };
@@ -20,11 +20,17 @@
 
 #include <config.h>
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <clipper.hpp>
+#include <cstring>
+#include <exception>
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <potracelib.h>
 #include <sstream>
+#include <thread>
 #include <vector>
 #include <zlib.h>
 #include "CommandLine.hpp"
@@ -39,8 +45,10 @@
 #include "HashFunction.hpp"
 #include "HyperlinkManager.hpp"
 #include "Message.hpp"
+#include "PageRanges.hpp"
 #include "PageSize.hpp"
 #include "PDFToSVG.hpp"
+#include "Process.hpp"
 #include "PSInterpreter.hpp"
 #include "PsSpecialHandler.hpp"
 #include "SignalHandler.hpp"
@@ -368,6 +376,174 @@ static void set_variables (const CommandLine &cmdline) {
 }
 
 
+/** Quotes a command-line argument if necessary so that it can be passed to
+ *  a subprocess as part of a parameter string.
+ *  @throw MessageException if the argument can't be quoted */
+static string quote_argument (const string &arg) {
+#ifdef _WIN32
+	// follow the rules of the Microsoft C runtime: backslashes are only special
+	// in front of a double quote, which must be escaped by a backslash itself
+	if (!arg.empty() && arg.find_first_of(" \t\"") == string::npos)
+		return arg;
+	string quoted = "\"";
+	size_t backslashes=0;
+	for (char c : arg) {
+		if (c == '\\')
+			backslashes++;
+		else {
+			if (c == '"')
+				quoted.append(backslashes+1, '\\');
+			backslashes = 0;
+		}
+		quoted += c;
+	}
+	quoted.append(backslashes, '\\');  // trailing backslashes must not escape the closing quote
+	return quoted + "\"";
+#else
+	// Process splits the parameter string at whitespace outside of single or
+	// double quotes and doesn't support escape characters
+	if (!arg.empty() && arg.find_first_of(" \t\n\v\f\r\"'") == string::npos)
+		return arg;
+	char quote = arg.find('"') == string::npos ? '"' : '\'';
+	if (arg.find(quote) != string::npos)
+		throw MessageException("argument '"+arg+"' can't be passed to a subprocess (contains both single and double quotes)");
+	return quote + arg + quote;
+#endif
+}
+
+
+/** Splits a sequence of page numbers into at most n contiguous chunks of
+ *  similar size and returns the page ranges of the chunks.
+ *  @param[in] pages ascending page numbers
+ *  @param[in] n maximal number of chunks
+ *  @return range strings of the chunks (e.g. "1-5,7") */
+static vector<string> split_pages (const vector<int> &pages, size_t n) {
+	vector<string> chunks;
+	n = min(n, pages.size());
+	for (size_t i=0; i < n; i++) {
+		size_t first = pages.size()*i/n;
+		size_t last = pages.size()*(i+1)/n;
+		ostringstream oss;
+		for (size_t j=first; j < last; j++) {
+			size_t k=j;
+			while (k+1 < last && pages[k+1] == pages[k]+1)
+				++k;
+			if (j > first)
+				oss << ',';
+			oss << pages[j];
+			if (k > j)
+				oss << '-' << pages[k];
+			j = k;
+		}
+		chunks.push_back(oss.str());
+	}
+	return chunks;
+}
+
+
+/** Converts the selected pages of a DVI file by running several instances
+ *  of dvisvgm in parallel, each of which converts a contiguous chunk of the
+ *  pages. Most components of dvisvgm (font manager, special handlers,
+ *  PostScript interpreter etc.) are global objects, so the pages can't be
+ *  processed by concurrent threads of a single process. Since each
+ *  subprocess evaluates the complete DVI file in its pre-processing step,
+ *  the generated files are identical to those of a serial run. DVI files
+ *  containing specials whose effects reach beyond the current page (e.g.
+ *  PostScript code not placed in headers) must not be converted this way.
+ *  @param[in] argc number of command-line arguments
+ *  @param[in] argv command-line arguments
+ *  @param[in] cmdline the parsed command-line
+ *  @param[in] numPages total number of pages of the DVI file
+ *  @param[out] pageinfo number of converted pages and total number of pages
+ *  @return true if all subprocesses terminated successfully */
+static bool convert_parallel (int argc, char **argv, const CommandLine &cmdline, unsigned numPages, pair<int,int> *pageinfo) {
+	PageRanges ranges;
+	if (!ranges.parse(cmdline.pageOpt.value(), numPages))
+		throw MessageException("invalid page range format");
+	vector<int> pages;
+	for (const auto &range : ranges)
+		for (int i=range.first; i <= min(range.second, int(numPages)); i++)
+			pages.push_back(i);
+	vector<string> chunks = split_pages(pages, cmdline.jobsOpt.value());
+	// Later options override earlier ones. Therefore, the options selecting the
+	// pages of a chunk are inserted in front of a terminating "--", if present.
+	int optend=1;
+	while (optend < argc && strcmp(argv[optend], "--") != 0)
+		optend++;
+	// All subprocesses are started from this thread before any other thread
+	// exists. The threads only collect the output of the subprocesses.
+	vector<unique_ptr<Process>> processes;
+	vector<char> successes(chunks.size(), 0);
+	for (size_t i=0; i < chunks.size(); i++) {
+		string paramstr;
+		for (int j=1; j < argc; j++) {
+			if (j == optend)
+				paramstr += "--jobs=1 --page=" + chunks[i] + " ";
+			paramstr += quote_argument(argv[j]) + " ";
+		}
+		if (optend == argc)
+			paramstr += "--jobs=1 --page=" + chunks[i];
+#ifdef _WIN32
+		processes.emplace_back(util::make_unique<Process>(quote_argument(argv[0]), paramstr, true));
+#else
+		processes.emplace_back(util::make_unique<Process>(argv[0], paramstr, true));
+#endif
+		successes[i] = processes.back()->start();
+	}
+	vector<string> outputs(chunks.size());
+	vector<exception_ptr> exceptions(chunks.size());
+	vector<thread> threads;
+	atomic<size_t> finished(0);
+	for (size_t i=0; i < chunks.size(); i++) {
+		if (!successes[i])
+			continue;
+		threads.emplace_back([&, i]() {
+			try {
+				successes[i] = processes[i]->wait(&outputs[i]);
+			}
+			catch (...) {
+				exceptions[i] = current_exception();
+			}
+			++finished;
+		});
+	}
+	// The threads may block while reading the output of the subprocesses, so
+	// this thread checks for CTRL-C and terminates the subprocesses if necessary.
+	try {
+		while (finished < threads.size()) {
+			SignalHandler::instance().check();
+			this_thread::sleep_for(chrono::milliseconds(100));
+		}
+	}
+	catch (SignalException&) {
+		for (auto &process : processes)
+			process->terminate();
+		for (thread &t : threads)
+			t.join();
+		throw;
+	}
+	for (thread &t : threads)
+		t.join();
+	// print the messages of the subprocesses (stdout and stderr) in page order
+	bool success=true;
+	for (size_t i=0; i < chunks.size(); i++) {
+		cerr << outputs[i];
+		if (!successes[i] && !exceptions[i]) {
+			Message::estream(true) << "conversion of page(s) " << chunks[i] << " failed\n";
+			success = false;
+		}
+	}
+	for (const exception_ptr &e : exceptions)
+		if (e)
+			rethrow_exception(e);
+	if (pageinfo) {
+		pageinfo->first = ranges.numberOfPages();
+		pageinfo->second = numPages;
+	}
+	return success;
+}
+
+
 static void timer_message (double start_time, const pair<int,int> *pageinfo) {
 	Message::mstream().indent(0);
 	if (!pageinfo)
@@ -386,9 +562,15 @@ int MIKTEXCEECALL Main(int argc, char **argv) {
 #else
 int main (int argc, char *argv[]) {
 #endif
+	// Failures are only reported by the exit status if option --jobs is given.
+	// The parent of a parallel conversion needs the status of its subprocesses
+	// (started with --jobs=1), while the behavior of other runs is unchanged.
+	bool reportStatus=false;
+	int status=0;
 	try {
 		CommandLine cmdline;
 		cmdline.parse(argc, argv);
+		reportStatus = cmdline.jobsOpt.given();
 		if (argc == 1 || cmdline.helpOpt.given()) {
 			cmdline.help(cout, cmdline.helpOpt.value());
 			return 0;
@@ -451,22 +633,36 @@ int main (int argc, char *argv[]) {
 			dvi2svg.setPageTransformation(get_transformation_string(cmdline));
 			dvi2svg.setPageSize(cmdline.bboxOpt.value());
 
-			dvi2svg.convert(cmdline.pageOpt.value(), &pageinfo);
+			bool parallel = cmdline.jobsOpt.value() > 1 && !cmdline.stdoutOpt.given() && !cmdline.filenames()[0].empty();
+			if (parallel && dvi2svg.hasPageDependentSpecials()) {
+				Message::wstream(true) << "DVI file contains specials affecting subsequent pages, option --jobs ignored\n";
+				parallel = false;
+			}
+			if (parallel) {
+				if (!convert_parallel(argc, argv, cmdline, dvi2svg.numberOfPages(), &pageinfo))
+					status = 1;
+			}
+			else
+				dvi2svg.convert(cmdline.pageOpt.value(), &pageinfo);
 			timer_message(start_time, &pageinfo);
 		}
 	}
 	catch (DVIException &e) {
 		Message::estream() << "\nDVI error: " << e.what() << '\n';
+		status = 1;
 	}
 	catch (PSException &e) {
 		Message::estream() << "\nPostScript error: " << e.what() << '\n';
+		status = 1;
 	}
 	catch (SignalException &e) {
 		Message::wstream().clearline();
 		Message::wstream(true) << "execution interrupted by user\n";
+		status = 1;
 	}
 	catch (exception &e) {
 		Message::estream(true) << e.what() << '\n';
+		status = 1;
 	}
-	return 0;
+	return reportStatus ? status : 0;
 }
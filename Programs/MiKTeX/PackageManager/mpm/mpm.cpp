@@ -943,15 +943,13 @@ void Application::Verify(const vector<string>& toBeVerifiedArg)
       }
     }
   }
-  bool ok = true;
-  for (const string& packageId : toBeVerified)
+  bool ok = packageManager->TryVerifyInstalledPackages(toBeVerified, [this](const string& packageId, bool packageOk)
   {
-    if (!packageManager->TryVerifyInstalledPackage(packageId))
+    if (!packageOk)
     {
       Message(fmt::format(T_("{0}: this package needs to be reinstalled."), packageId));
-      ok = false;
     }
-  }
+  });
   if (ok)
   {
     if (verifyAll)
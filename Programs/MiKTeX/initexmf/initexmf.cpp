@@ -905,7 +905,7 @@ void IniTeXMFApp::UpdateFilenameDatabase(const PathName& root)
   PrintOnly(fmt::format("fndbcreate {} {}", Q_(fndbPath), Q_(root)));
   if (!printOnly)
   {
-    Fndb::Create(fndbPath, root, this);
+    Fndb::Update(fndbPath, root, this);
   }
 }
 
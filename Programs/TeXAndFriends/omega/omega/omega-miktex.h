@@ -342,7 +342,8 @@ template<typename T> int dumpthings(const T& first_item, std::size_t n)
 
 template<typename T> int undumpthings(T& first_item, std::size_t n)
 {
-  return fread(&first_item, sizeof(first_item), n, OMEGAPROG.fmtfile);
+  OMEGAPROG.fmtfile.ReadRaw(&first_item, sizeof(first_item) * n);
+  return static_cast<int>(n);
 }
 
 #define cint c4p_P2.c4p_int
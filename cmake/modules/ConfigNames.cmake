@@ -29,11 +29,19 @@ set(MIKTEX_CONFIG_VALUE_ALTEXTENSIONS "AltExtensions[]")
 set(MIKTEX_CONFIG_VALUE_AUTOADMIN "AutoAdmin")
 set(MIKTEX_CONFIG_VALUE_AUTOINSTALL "AutoInstall")
 set(MIKTEX_CONFIG_VALUE_COMMONLINKTARGETDIRECTORY "CommonLinkTargetDirectory")
+set(MIKTEX_CONFIG_VALUE_COMPRESSMEMORYDUMPFILES "CompressMemoryDumpFiles")
 set(MIKTEX_CONFIG_VALUE_CREATEAUXDIRECTORY "CreateAuxDirectory")
 set(MIKTEX_CONFIG_VALUE_CREATEOUTPUTDIRECTORY "CreateOutputDirectory")
 set(MIKTEX_CONFIG_VALUE_CSTYLEERRORS "CStyleErrors")
+set(MIKTEX_CONFIG_VALUE_DECOMPRESSIONBUFFERSIZE "DecompressionBufferSize")
 set(MIKTEX_CONFIG_VALUE_ENVVARS "EnvVars[]")
 set(MIKTEX_CONFIG_VALUE_EXTENSIONS "Extensions[]")
+set(MIKTEX_CONFIG_VALUE_FINDFILECACHE "FindFileCache")
+set(MIKTEX_CONFIG_VALUE_FNDBCOMPACTIONTHRESHOLD "FndbCompactionThreshold")
+set(MIKTEX_CONFIG_VALUE_FNDBREVALIDATIONINTERVAL "FndbRevalidationInterval")
+set(MIKTEX_CONFIG_VALUE_FNDBSCANTHREADS "FndbScanThreads")
+set(MIKTEX_CONFIG_VALUE_MAXPARALLELDOWNLOADS "MaxParallelDownloads")
 set(MIKTEX_CONFIG_VALUE_PATHS "Paths[]")
 set(MIKTEX_CONFIG_VALUE_SHELLCOMMANDMODE "ShellCommandMode")
+set(MIKTEX_CONFIG_VALUE_SYNCDECOMPRESSIONTHRESHOLD "SyncDecompressionThreshold")
 set(MIKTEX_CONFIG_VALUE_USERLINKTARGETDIRECTORY "UserLinkTargetDirectory")